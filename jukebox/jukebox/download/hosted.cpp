@@ -1,44 +1,354 @@
 #include <jukebox/download/hosted.hpp>
 
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 
 #include <fmt/core.h>
 #include <Geode/Result.hpp>
 #include <Geode/loader/Mod.hpp>
+#include <Geode/utils/file.hpp>
 #include <Geode/utils/web.hpp>
+#include <matjson.hpp>
 
 #include <jukebox/events/file_download_progress.hpp>
+#include <jukebox/utils/file.hpp>
 #include <jukebox/utils/web.hpp>
 
 using namespace geode::prelude;
 
+namespace {
+
+// How much of a file is requested at a time. WebRequest hands over the body
+// only once all of it arrived, it can't be streamed to disk, so this is also
+// how much is held in memory. It's big enough that nearly every song is one
+// request, while a Range request is still what keeps bigger files bounded.
+// A server that ignores Range sends all of the file in one body regardless.
+constexpr uint64_t CHUNK_SIZE = 16 * 1024 * 1024;
+
+// What a .part file is a download of, stored next to it. If-Range lets the
+// server tell whether the file changed since. Without a strong ETag, the size
+// of the file is compared too, and the part started over if it differs.
+struct PartInfo {
+    std::string url;
+    std::optional<std::string> etag;
+    std::optional<std::string> lastModified;
+    std::optional<uint64_t> total;
+
+    // Weak ETags can't be used for If-Range
+    [[nodiscard]] std::optional<std::string> ifRange() const {
+        if (etag && !etag->starts_with("W/")) {
+            return etag;
+        }
+        return lastModified;
+    }
+
+    [[nodiscard]] bool resumable() const { return this->ifRange() || total; }
+};
+
+std::optional<PartInfo> readPartInfo(const std::filesystem::path& path) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return std::nullopt;
+    }
+
+    Result<matjson::Value> json = geode::utils::file::readJson(path);
+    if (json.isErr()) {
+        return std::nullopt;
+    }
+
+    const matjson::Value& value = json.unwrap();
+    Result<std::string> url = value["url"].asString();
+    if (url.isErr()) {
+        return std::nullopt;
+    }
+
+    return PartInfo{
+        .url = std::move(url).unwrap(),
+        .etag = value["etag"].asString().ok(),
+        .lastModified = value["lastModified"].asString().ok(),
+        .total = value["total"].asUInt().ok(),
+    };
+}
+
+void writePartInfo(const std::filesystem::path& path, const PartInfo& info) {
+    matjson::Value value = matjson::makeObject({{"url", info.url}});
+    if (info.etag) {
+        value.set("etag", info.etag.value());
+    }
+    if (info.lastModified) {
+        value.set("lastModified", info.lastModified.value());
+    }
+    if (info.total) {
+        value.set("total", info.total.value());
+    }
+
+    if (GEODE_UNWRAP_IF_ERR(err, jukebox::utils::file::writeStringAtomic(path, value.dump()))) {
+        log::warn("Failed to save download validators to {}: {}", path.filename(), err);
+    }
+}
+
+template <typename T>
+std::optional<std::string> toOptionalString(const std::optional<T>& value) {
+    return value.transform([](const auto& v) { return std::string(v); });
+}
+
+std::optional<uint64_t> parseUint(const std::string_view str) {
+    uint64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc() || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// A "bytes <first>-<last>/<total>" Content-Range header. The total is "*"
+// when the server doesn't know it.
+struct ContentRange {
+    uint64_t first = 0;
+    uint64_t last = 0;
+    std::optional<uint64_t> total;
+
+    [[nodiscard]] uint64_t size() const { return last - first + 1; }
+};
+
+std::optional<ContentRange> parseContentRange(std::string_view header) {
+    if (!header.starts_with("bytes ")) {
+        return std::nullopt;
+    }
+    header.remove_prefix(6);
+
+    const size_t dash = header.find('-');
+    const size_t slash = header.find('/');
+    if (dash == std::string_view::npos || slash == std::string_view::npos || dash > slash) {
+        return std::nullopt;
+    }
+
+    const std::optional<uint64_t> first = parseUint(header.substr(0, dash));
+    const std::optional<uint64_t> last = parseUint(header.substr(dash + 1, slash - dash - 1));
+    if (!first || !last || last < first) {
+        return std::nullopt;
+    }
+
+    const std::string_view total = header.substr(slash + 1);
+    return ContentRange{
+        .first = first.value(),
+        .last = last.value(),
+        .total = total == "*" ? std::nullopt : parseUint(total),
+    };
+}
+
+}  // namespace
+
 namespace jukebox::download {
 
-arc::Future<Result<ByteVector>> startHostedDownload(const std::string_view url) {
+arc::Future<Result<std::string>> startHostedDownload(std::string url, std::filesystem::path destination) {
     int timeout = Mod::get()->getSettingValue<int>("download-timeout");
 
     if (timeout < 30) {
         timeout = 30;
     }
 
-    const web::WebResponse response =
-        co_await web::WebRequest()
-            .timeout(std::chrono::seconds(timeout))
-            .onProgress([url = std::string(url)](const web::WebProgress& progress) {
-                const float actual = progress.downloadProgress().value_or(0.0f);
+    std::filesystem::path part = destination;
+    part += ".part";
+    std::filesystem::path partInfoPath = part;
+    partInfoPath += ".json";
+
+    const auto fail = [&part, &partInfoPath](std::string err, const bool keepPart) -> Result<std::string> {
+        log::error("File download failed. Error: {}", err);
+        if (!keepPart) {
+            std::error_code ec;
+            std::filesystem::remove(part, ec);
+            std::filesystem::remove(partInfoPath, ec);
+        }
+        return Err(std::move(err));
+    };
+
+    uint64_t written = 0;
+    PartInfo info{.url = url};
+
+    // A part is only resumed with something to tell whether it still belongs
+    // to the file on the server
+    if (std::optional<PartInfo> saved = readPartInfo(partInfoPath);
+        saved && saved->url == url && saved->resumable()) {
+        std::error_code ec;
+        written = std::filesystem::file_size(part, ec);
+        if (ec) {
+            written = 0;
+        } else {
+            info = std::move(saved).value();
+        }
+    }
+
+    if (written > 0) {
+        log::info("Resuming download of {} at {} bytes", url, written);
+    }
+
+    std::ofstream out(part, std::ios_base::out | std::ios_base::binary |
+                                (written > 0 ? std::ios_base::app : std::ios_base::trunc));
+
+    if (!out.is_open()) {
+        co_return fail("Failed to store downloaded file. Couldn't open file for write", false);
+    }
+
+    // Drops what was downloaded so far, for when the part turns out to be
+    // unusable
+    const auto startOver = [&]() {
+        out.close();
+        out.open(part, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        written = 0;
+        info = PartInfo{.url = url};
+        return out.is_open();
+    };
+
+    std::optional<uint64_t> total;
+    std::string contentType;
+    bool restarted = false;
+
+    while (!total || written < total.value()) {
+        const uint64_t offset = written;
+
+        web::WebRequest request;
+        request.timeout(std::chrono::seconds(timeout))
+            .header("Range", fmt::format("bytes={}-{}", offset, offset + CHUNK_SIZE - 1))
+            .onProgress([url, offset, total](const web::WebProgress& progress) {
+                // Until the first part says how big the file is, the progress
+                // of a request is only that of one chunk
+                float actual = 0.0f;
+                if (total && total.value() > 0) {
+                    actual = 100.0f * static_cast<float>(offset + progress.downloaded()) /
+                             static_cast<float>(total.value());
+                } else if (progress.downloadTotal() > CHUNK_SIZE) {
+                    // The server ignored the range and is sending the whole file
+                    actual = progress.downloadProgress().value_or(0.0f);
+                }
 
                 events::FileDownloadProgress(url).send(events::FileDownloadProgressData{url, actual});
-            })
-            .get(std::string(url));
+            });
 
-    if (!response.ok()) {
-        std::string err = utils::web::getErrorFromResponse(response);
-        log::error("File download failed. Error: {}", err);
+        if (const std::optional<std::string> ifRange = info.ifRange(); offset > 0 && ifRange) {
+            request.header("If-Range", ifRange.value());
+        }
+
+        web::WebResponse response = co_await request.get(url);
+
+        const bool partial = response.code() == 206;
+        const std::optional<ContentRange> range =
+            partial ? parseContentRange(response.header("Content-Range").value_or("")) : std::nullopt;
+
+        // A different size means a different file, whatever the validators
+        // said
+        const bool wrongPart = partial && (!range || range->first != offset ||
+                                           (info.total && range->total && range->total != info.total));
+
+        // The part doesn't line up with the file on the server anymore
+        if ((response.code() == 416 || wrongPart) && offset > 0 && !restarted) {
+            log::info("Download of {} can't be resumed at {} bytes, starting over", url, offset);
+            restarted = true;
+            if (!startOver()) {
+                co_return fail("Failed to store downloaded file. Couldn't open file for write", false);
+            }
+            total = std::nullopt;
+            continue;
+        }
 
-        co_return Err(std::move(err));
+        if (!response.ok()) {
+            // What was downloaded so far is kept, so the next attempt picks up
+            // from there
+            co_return fail(utils::web::getErrorFromResponse(response), info.resumable());
+        }
+
+        if (wrongPart) {
+            co_return fail("Server sent the wrong part of the file", false);
+        }
+
+        if (!partial && offset > 0) {
+            // Either the file changed since the part was downloaded, or the
+            // server ignores ranges. The response is the whole file either way.
+            log::info("Server sent all of {} instead of resuming at {} bytes", url, offset);
+            if (!startOver()) {
+                co_return fail("Failed to store downloaded file. Couldn't open file for write", false);
+            }
+        }
+
+        if (written == 0) {
+            info.etag = toOptionalString(response.header("ETag"));
+            info.lastModified = toOptionalString(response.header("Last-Modified"));
+            info.total = partial ? range->total : std::nullopt;
+            writePartInfo(partInfoPath, info);
+        }
+
+        if (partial) {
+            total = range->total;
+        }
+        contentType = response.header("Content-Type").value_or("");
+
+        const ByteVector chunk = std::move(response).data();
+
+        // A body cut short, or a server that got its own header wrong
+        if (partial && chunk.size() != range->size()) {
+            if (offset > 0 && !restarted) {
+                log::info("Part of {} at {} bytes has the wrong size, starting over", url, offset);
+                restarted = true;
+                if (!startOver()) {
+                    co_return fail("Failed to store downloaded file. Couldn't open file for write", false);
+                }
+                total = std::nullopt;
+                continue;
+            }
+            co_return fail(fmt::format("Server sent {} bytes for a part of {} bytes", chunk.size(), range->size()),
+                           false);
+        }
+
+        out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        out.flush();
+        if (!out) {
+            co_return fail("Failed to store downloaded file. Couldn't write to file", false);
+        }
+
+        written += chunk.size();
+
+        // The server ignored the range and sent the whole file, which may not
+        // be the size the earlier parts said it was
+        if (!partial) {
+            total = std::nullopt;
+            break;
+        }
+
+        // Without a total, a short chunk is the end of the file
+        if (chunk.empty() || (!total && chunk.size() < CHUNK_SIZE)) {
+            break;
+        }
     }
 
-    co_return Ok(std::move(response).data());
+    out.close();
+
+    // An empty part before the end. What was downloaded is kept, so the next
+    // attempt picks up from there.
+    if (total && written != total.value()) {
+        co_return fail(fmt::format("Download ended after {} of {} bytes", written, total.value()),
+                       info.resumable());
+    }
+
+    if (written == 0) {
+        co_return fail("Failed to store downloaded file. Downloaded file is empty.", false);
+    }
+
+    if (std::error_code ec; std::filesystem::rename(part, destination, ec), ec) {
+        co_return fail(fmt::format("Failed to store downloaded file. Couldn't move it into place: {}", ec.message()),
+                       false);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(partInfoPath, ec);
+
+    co_return Ok(std::move(contentType));
 }
 
 }  // namespace jukebox::download
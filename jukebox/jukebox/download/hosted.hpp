@@ -1,13 +1,27 @@
 #pragma once
 
-#include <string_view>
+#include <filesystem>
+#include <string>
 
 #include <Geode/Result.hpp>
-#include <Geode/utils/general.hpp>
 #include <arc/future/Future.hpp>
 
 namespace jukebox::download {
 
-arc::Future<geode::Result<geode::ByteVector>> startHostedDownload(std::string_view url);
+/**
+ * Downloads a file straight to disk. The file is fetched in large chunks with
+ * Range requests and appended to a temporary file next to the destination as
+ * they arrive, so memory use stays at one chunk no matter how big the file is,
+ * unless the server ignores Range. The temporary file is renamed to the
+ * destination once complete.
+ *
+ * If the download fails midway, the temporary ".part" file is kept along with
+ * the ETag or Last-Modified and the size it was downloaded with, and the next
+ * download of the same url resumes from it using If-Range. Servers that ignore
+ * Range, or whose copy changed since, get the whole file downloaded again.
+ *
+ * @return the Content-Type the server sent the file with, empty if none
+ */
+arc::Future<geode::Result<std::string>> startHostedDownload(std::string url, std::filesystem::path destination);
 
 }  // namespace jukebox::download
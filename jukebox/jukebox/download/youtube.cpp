@@ -1,5 +1,6 @@
 #include <jukebox/download/youtube.hpp>
 
+#include <filesystem>
 #include <matjson.hpp>
 #include <string>
 
@@ -14,17 +15,17 @@ using namespace arc;
 
 web::WebFuture getMetadata(const std::string& id);
 Result<std::string> getUrlFromMetadataPayload(web::WebResponse r);
-Future<Result<ByteVector>> onMetadata(web::WebResponse result);
+Future<Result<>> onMetadata(web::WebResponse result, std::filesystem::path destination);
 
 namespace jukebox::download {
 
-Future<Result<ByteVector>> startYoutubeDownload(const std::string& id) {
+Future<Result<>> startYoutubeDownload(std::string id, std::filesystem::path destination) {
     if (id.length() != 11) {
         co_return Err("Invalid YouTube ID");
     }
 
     auto metadata = co_await getMetadata(id);
-    co_return co_await onMetadata(std::move(metadata));
+    co_return co_await onMetadata(std::move(metadata), std::move(destination));
 }
 
 }  // namespace jukebox::download
@@ -70,11 +71,12 @@ web::WebFuture getMetadata(const std::string& id) {
         .post("https://api.cobalt.tools/api/json");
 }
 
-Future<Result<ByteVector>> onMetadata(web::WebResponse result) {
+Future<Result<>> onMetadata(web::WebResponse result, std::filesystem::path destination) {
     Result<std::string> res = getUrlFromMetadataPayload(std::move(result));
     if (res.isErr()) {
         co_return Err(res.unwrapErr());
     }
 
-    co_return co_await jukebox::download::startHostedDownload(res.unwrap());
+    ARC_CO_UNWRAP(co_await jukebox::download::startHostedDownload(res.unwrap(), std::move(destination)));
+    co_return Ok();
 }
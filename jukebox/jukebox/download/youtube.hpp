@@ -1,12 +1,13 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
 
-#include <Geode/utils/general.hpp>
+#include <Geode/Result.hpp>
 #include <arc/future/Future.hpp>
 
 namespace jukebox::download {
 
-arc::Future<geode::Result<geode::ByteVector>> startYoutubeDownload(const std::string& id);
+arc::Future<geode::Result<>> startYoutubeDownload(std::string id, std::filesystem::path destination);
 
 } // namespace jukebox::download
@@ -14,13 +14,17 @@ struct SongDownloadFinishedData final {
 private:
     std::optional<index::IndexSongMetadata*> m_indexSource;
     Song* m_destination;
+    bool m_background;
 
 public:
-    SongDownloadFinishedData(std::optional<index::IndexSongMetadata*> indexSource, Song* destination) noexcept
-        : m_indexSource(indexSource), m_destination(destination) {}
+    SongDownloadFinishedData(std::optional<index::IndexSongMetadata*> indexSource, Song* destination,
+                             bool background = false) noexcept
+        : m_indexSource(indexSource), m_destination(destination), m_background(background) {}
 
     [[nodiscard]] std::optional<index::IndexSongMetadata*> indexSource() const noexcept { return m_indexSource; }
     [[nodiscard]] Song* destination() const noexcept { return m_destination; }
+    // Prefetched rather than asked for by the user, the song isn't made active
+    [[nodiscard]] bool background() const noexcept { return m_background; }
 };
 
 struct SongDownloadFinished final : geode::Event<SongDownloadFinished, bool(const SongDownloadFinishedData&)> {
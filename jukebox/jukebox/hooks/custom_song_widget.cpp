@@ -28,6 +28,7 @@
 
 #include <jukebox/events/song_state_changed.hpp>
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/prefetch_manager.hpp>
 #include <jukebox/nong/nong.hpp>
 #include <jukebox/ui/nong_dropdown_layer.hpp>
 
@@ -81,7 +82,7 @@ class $modify(JBSongWidget, CustomSongWidget) {
         }
         songIDs.push_back(id);
 
-        bool isVerified = !NongManager::get().getVerifiedNongsForLevel(m_fields->levelID.value(), songIDs).empty();
+        bool isVerified = NongManager::get().isNongVerified(m_fields->levelID.value(), songIDs);
         if (!isVerified) {
             return;
         }
@@ -148,7 +149,7 @@ class $modify(JBSongWidget, CustomSongWidget) {
             if (!optPath) {
                 found->second = false;
             } else {
-                found->second = std::filesystem::exists(std::move(optPath).value());
+                found->second = NongManager::get().pathCache().exists(optPath.value());
             }
         }
     }
@@ -191,6 +192,8 @@ class $modify(JBSongWidget, CustomSongWidget) {
 
     void updateMultiAssetInfo(bool p) {
         CustomSongWidget::updateMultiAssetInfo(p);
+        // GD downloads the assets of levels itself, and updates this after
+        NongManager::get().assetSizes().forgetMissing();
         this->fixMultiAssetSize();
     }
 
@@ -444,7 +447,7 @@ class $modify(JBSongWidget, CustomSongWidget) {
         const std::filesystem::path activePath = std::move(activePathOpt).value();
 
         std::string sizeText;
-        if (std::filesystem::exists(activePath)) {
+        if (NongManager::get().pathCache().exists(activePath)) {
             sizeText = NongManager::get().getFormattedSize(activePath);
         } else if (m_songInfoObject) {
             sizeText = fmt::format("{:.2f}MB", m_songInfoObject->m_fileSize);
@@ -629,6 +632,7 @@ class $modify(JBLevelInfoLayer, LevelInfoLayer) {
             }
         }
         static_cast<JBSongWidget*>(this->m_songWidget)->setLevelID(m_level->m_levelID.value());
+        PrefetchManager::get().prefetchForLevel(m_level);
         return true;
     }
 };
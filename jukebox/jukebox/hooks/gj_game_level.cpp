@@ -7,6 +7,7 @@
 #include <Geode/utils/string.hpp>
 
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/storage_manager.hpp>
 
 using namespace geode::prelude;
 using namespace jukebox;
@@ -24,10 +25,11 @@ class $modify(GJGameLevel) {
             return GJGameLevel::getAudioFileName();
         }
         Song* active = res.value()->active();
-        if (!std::filesystem::exists(active->path().value())) {
+        if (!NongManager::get().pathCache().exists(active->path().value())) {
             return GJGameLevel::getAudioFileName();
         }
         jukebox::NongManager::get().m_currentlyPreparingNong = res.value();
+        jukebox::StorageManager::get().touch(active->path().value());
 
         return geode::utils::string::pathToString(active->path().value());
     }
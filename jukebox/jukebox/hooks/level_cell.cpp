@@ -8,6 +8,7 @@
 #include <Geode/loader/Loader.hpp>
 
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/prefetch_manager.hpp>
 #include <jukebox/nong/nong.hpp>
 
 using namespace geode::prelude;
@@ -17,6 +18,8 @@ class $modify(JBLevelCell, LevelCell) {
     void loadCustomLevelCell() {
         LevelCell::loadCustomLevelCell();
 
+        PrefetchManager::get().prefetchForLevel(m_level);
+
         if (!Loader::get()->isModLoaded("geode.node-ids")) {
             return;
         }
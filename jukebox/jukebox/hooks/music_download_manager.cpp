@@ -11,6 +11,7 @@
 
 #include <jukebox/events/get_song_info.hpp>
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/storage_manager.hpp>
 #include <jukebox/nong/nong.hpp>
 
 using namespace jukebox;
@@ -23,10 +24,11 @@ gd::string JBMusicDownloadManager::pathForSong(int id) {
     }
     Nongs* value = nongs.value();
     Song* active = value->active();
-    if (!std::filesystem::exists(active->path().value())) {
+    if (!NongManager::get().pathCache().exists(active->path().value())) {
         return MusicDownloadManager::pathForSong(id);
     }
     NongManager::get().m_currentlyPreparingNong = value;
+    StorageManager::get().touch(active->path().value());
 
     return geode::utils::string::pathToString(active->path().value());
 }
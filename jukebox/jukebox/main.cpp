@@ -1,10 +1,14 @@
 #include <Geode/DefaultInclude.hpp>
 #include <Geode/Result.hpp>
+#include <Geode/loader/Log.hpp>
 #include <Geode/loader/Mod.hpp>
 #include <Geode/loader/ModEvent.hpp>
 
+#include <jukebox/managers/download_manager.hpp>
 #include <jukebox/managers/index_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/prefetch_manager.hpp>
+#include <jukebox/managers/storage_manager.hpp>
 #include <jukebox/ui/indexes_setting.hpp>
 
 using namespace geode::prelude;
@@ -12,6 +16,19 @@ using namespace geode::prelude;
 $execute { (void)Mod::get()->registerCustomSettingType("indexes", &jukebox::IndexSetting::parse); }
 
 $on_mod(Loaded) {
+    jukebox::DownloadManager::get().init();
     jukebox::IndexManager::get().init();
     jukebox::NongManager::get().init();
+    jukebox::StorageManager::get().init();
+    jukebox::PrefetchManager::get().init();
+};
+
+$on_mod(DataSaved) {
+    jukebox::NongManager::get().flush();
+    jukebox::StorageManager::get().save();
+    jukebox::NongManager::get().assetSizes().save();
+
+    if (GEODE_UNWRAP_IF_ERR(err, jukebox::NongManager::get().saveSnapshot())) {
+        log::error("Failed to save manifest snapshot: {}", err);
+    }
 };
@@ -0,0 +1,286 @@
+#include <jukebox/managers/download_manager.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <Geode/loader/Event.hpp>
+#include <Geode/loader/Log.hpp>
+#include <Geode/loader/Mod.hpp>
+#include <Geode/utils/general.hpp>
+#include <Geode/utils/string.hpp>
+
+#include <jukebox/download/hosted.hpp>
+#include <jukebox/events/file_download_progress.hpp>
+#include <jukebox/events/song_download_failed.hpp>
+#include <jukebox/events/song_download_progress.hpp>
+#include <jukebox/nong/blob_store.hpp>
+#include <jukebox/utils/hash.hpp>
+#include <jukebox/utils/sha256.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Extensions FMOD plays that songs are usually hosted as
+constexpr std::array<std::pair<std::string_view, std::string_view>, 10> s_audioTypes = {{
+    {".mp3", "audio/mpeg"},
+    {".mp3", "audio/mp3"},
+    {".ogg", "audio/ogg"},
+    {".ogg", "audio/vorbis"},
+    {".ogg", "application/ogg"},
+    {".flac", "audio/flac"},
+    {".flac", "audio/x-flac"},
+    {".wav", "audio/wav"},
+    {".wav", "audio/x-wav"},
+    {".wav", "audio/vnd.wave"},
+}};
+
+std::string lowercase(std::string str) {
+    std::ranges::transform(str, str.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return str;
+}
+
+// Blobs keep the extension of the file, like local imports do. The url is
+// trusted first, then the Content-Type, and anything else is assumed to be
+// an MP3 like most hosted songs are.
+std::string audioExtension(std::string_view url, std::string_view contentType) {
+    url = url.substr(0, url.find_first_of("?#"));
+    const size_t dot = url.rfind('.');
+    if (dot != std::string_view::npos && url.find('/', dot) == std::string_view::npos) {
+        const std::string extension = lowercase(std::string(url.substr(dot)));
+        if (std::ranges::any_of(s_audioTypes, [&extension](const auto& type) { return type.first == extension; })) {
+            return extension;
+        }
+    }
+
+    const std::string type = lowercase(std::string(contentType.substr(0, contentType.find(';'))));
+    for (const auto& [extension, mime] : s_audioTypes) {
+        if (type == mime) {
+            return std::string(extension);
+        }
+    }
+
+    return ".mp3";
+}
+
+}  // namespace
+
+namespace jukebox {
+
+arc::Future<Result<DownloadManager::StagedFile>> DownloadManager::downloadAndHash(std::string url,
+                                                                                 std::filesystem::path staging) {
+    Result<std::string> download = co_await download::startHostedDownload(url, staging);
+    if (download.isErr()) {
+        co_return Err(download.unwrapErr());
+    }
+
+    ARC_CO_UNWRAP_INTO(std::string hash, sha256File(staging));
+    co_return Ok(StagedFile{.m_hash = std::move(hash), .m_extension = audioExtension(url, download.unwrap())});
+}
+
+bool DownloadManager::init() {
+    if (m_initialized) {
+        return true;
+    }
+
+    // Every song waiting on a transfer gets its progress
+    events::FileDownloadProgress()
+        .listen([this](const events::FileDownloadProgressData& event) {
+            const auto it = m_transfers.find(std::string(event.url()));
+            if (it == m_transfers.end()) {
+                return;
+            }
+
+            for (const Request& request : it->second.m_requests) {
+                event::SongDownloadProgress(request.m_gdSongID)
+                    .send(event::SongDownloadProgressData{request.m_gdSongID, request.m_uniqueID, event.progress()});
+            }
+        })
+        .leak();
+
+    // Downloads are staged in there
+    std::error_code ec;
+    std::filesystem::create_directories(blobs::basePath(), ec);
+    if (ec) {
+        log::error("Couldn't create the blob directory: {}", ec.message());
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void DownloadManager::enqueue(const std::string& url, const DownloadPriority priority, const int gdSongID,
+                              std::string uniqueID, Callback callback) {
+    auto [it, inserted] = m_transfers.try_emplace(url, Transfer{.m_priority = priority, .m_sequence = m_nextSequence});
+    Transfer& transfer = it->second;
+
+    if (inserted) {
+        m_nextSequence++;
+    } else {
+        transfer.m_priority = std::max(transfer.m_priority, priority);
+    }
+
+    const auto waiting = std::ranges::find_if(transfer.m_requests, [&](const Request& request) {
+        return request.m_gdSongID == gdSongID && request.m_uniqueID == uniqueID;
+    });
+
+    if (waiting == transfer.m_requests.end()) {
+        transfer.m_requests.push_back(Request{
+            .m_gdSongID = gdSongID,
+            .m_uniqueID = std::move(uniqueID),
+            .m_priority = priority,
+            .m_callback = std::move(callback),
+        });
+    } else if (priority > waiting->m_priority) {
+        // The user asked for a song that was being prefetched, so it's
+        // handled as their download once done
+        waiting->m_priority = priority;
+        waiting->m_callback = std::move(callback);
+    }
+
+    this->startTransfers();
+}
+
+bool DownloadManager::cancel(const int gdSongID, const std::string_view uniqueID) {
+    for (auto it = m_transfers.begin(); it != m_transfers.end(); ++it) {
+        std::vector<Request>& requests = it->second.m_requests;
+
+        const auto found = std::ranges::find_if(requests, [&](const Request& request) {
+            return request.m_gdSongID == gdSongID && request.m_uniqueID == uniqueID;
+        });
+
+        if (found == requests.end()) {
+            continue;
+        }
+
+        requests.erase(found);
+
+        if (requests.empty()) {
+            // A transfer in flight can't be stopped, it finishes with nobody
+            // waiting on it
+            if (!it->second.m_started) {
+                m_transfers.erase(it);
+            }
+        } else {
+            // A user download that got cancelled shouldn't keep prefetches
+            // sharing its transfer ahead of the queue
+            it->second.m_priority = std::ranges::max(requests, {}, &Request::m_priority).m_priority;
+        }
+
+        event::SongDownloadFailed(gdSongID).send(
+            event::SongDownloadFailedData{gdSongID, std::string(uniqueID), std::string(s_cancelled)});
+
+        return true;
+    }
+
+    return false;
+}
+
+bool DownloadManager::isDownloading(const int gdSongID, const std::string_view uniqueID) const {
+    return std::ranges::any_of(m_transfers, [&](const auto& pair) {
+        return std::ranges::any_of(pair.second.m_requests, [&](const Request& request) {
+            return request.m_gdSongID == gdSongID && request.m_uniqueID == uniqueID;
+        });
+    });
+}
+
+bool DownloadManager::isStaging(const std::filesystem::path& path) const {
+    const std::string file = string::pathToString(path);
+    return std::ranges::any_of(m_transfers, [&file](const auto& pair) {
+        return file.starts_with(string::pathToString(stagingPath(pair.first)));
+    });
+}
+
+std::filesystem::path DownloadManager::stagingPath(const std::string& url) {
+    return blobs::basePath() / fmt::format("{:016x}.download", fnv1a64(url));
+}
+
+void DownloadManager::startTransfers() {
+    const auto maxInFlight =
+        static_cast<size_t>(std::max<int64_t>(1, Mod::get()->getSettingValue<int64_t>("max-downloads")));
+
+    while (m_inFlight < maxInFlight) {
+        // Highest priority first, then oldest first. The queue rarely holds
+        // more than a handful of transfers, so a scan is fine.
+        auto next = m_transfers.end();
+        for (auto it = m_transfers.begin(); it != m_transfers.end(); ++it) {
+            const Transfer& transfer = it->second;
+            if (transfer.m_started) {
+                continue;
+            }
+
+            if (next == m_transfers.end() || transfer.m_priority > next->second.m_priority ||
+                (transfer.m_priority == next->second.m_priority && transfer.m_sequence < next->second.m_sequence)) {
+                next = it;
+            }
+        }
+
+        if (next == m_transfers.end()) {
+            return;
+        }
+
+        const std::string& url = next->first;
+        Transfer& transfer = next->second;
+
+        transfer.m_started = true;
+        m_inFlight++;
+
+        log::info("Starting download of {}", url);
+
+        async::spawn(downloadAndHash(url, stagingPath(url)),
+                     [this, url](Result<StagedFile> staged) { this->onTransferFinished(url, std::move(staged)); });
+    }
+}
+
+void DownloadManager::onTransferFinished(const std::string& url, Result<StagedFile>&& staged) {
+    m_inFlight--;
+
+    const auto it = m_transfers.find(url);
+    if (it == m_transfers.end()) {
+        this->startTransfers();
+        return;
+    }
+
+    // Take the transfer out first, so callbacks can queue the same url again
+    Transfer transfer = std::move(it->second);
+    m_transfers.erase(it);
+
+    const std::filesystem::path staging = stagingPath(url);
+
+    // Every song waiting on it got cancelled, storing it would only leave a
+    // blob nothing references
+    if (transfer.m_requests.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(staging, ec);
+        this->startTransfers();
+        return;
+    }
+
+    const Result<std::filesystem::path> blob = [&staged, &staging]() -> Result<std::filesystem::path> {
+        GEODE_UNWRAP_INTO(const StagedFile file, std::move(staged));
+        return blobs::commit(staging, file.m_hash, file.m_extension, false);
+    }();
+
+    for (Request& request : transfer.m_requests) {
+        if (blob.isErr()) {
+            request.m_callback(Err(blob.unwrapErr()));
+            continue;
+        }
+
+        request.m_callback(Ok(blob.unwrap()));
+    }
+
+    this->startTransfers();
+}
+
+}  // namespace jukebox
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <arc/future/Future.hpp>
+
+namespace jukebox {
+
+enum class DownloadPriority {
+    // Prefetching, only runs while nothing the user asked for is waiting
+    BACKGROUND = 0,
+    // Requested by the user, who is about to play the song
+    USER = 1,
+};
+
+/**
+ * Queue every hosted song download goes through. At most max-downloads
+ * transfers run at a time, picked by priority and then in the order they
+ * were queued.
+ *
+ * Requests for a url that is already queued or downloading join that
+ * transfer instead of starting another one. The file is downloaded once into
+ * the blob store, and every request gets the same blob.
+ *
+ * Everything here runs on the main thread.
+ */
+class DownloadManager {
+public:
+    // Called on the main thread with the path of the blob once the file is
+    // stored, or with the error if the download failed
+    using Callback = std::function<void(geode::Result<std::filesystem::path>)>;
+
+    // Error of the SongDownloadFailed event sent for cancelled downloads
+    static constexpr std::string_view s_cancelled = "Download cancelled";
+
+protected:
+    struct Request {
+        int m_gdSongID;
+        std::string m_uniqueID;
+        DownloadPriority m_priority;
+        Callback m_callback;
+    };
+
+    struct Transfer {
+        DownloadPriority m_priority;
+        // Queue order within a priority
+        uint64_t m_sequence;
+        bool m_started = false;
+        std::vector<Request> m_requests;
+    };
+
+    struct StagedFile {
+        // SHA-256 of the file
+        std::string m_hash;
+        // Extension the blob gets, including the leading dot
+        std::string m_extension;
+    };
+
+    bool m_initialized = false;
+
+    // url -> transfer, queued or in flight
+    std::unordered_map<std::string, Transfer> m_transfers {};
+    size_t m_inFlight = 0;
+    uint64_t m_nextSequence = 0;
+
+    DownloadManager() = default;
+
+    // Where a url is downloaded to before being moved into the blob store.
+    // Always the same for a url, so an interrupted download can be resumed.
+    static std::filesystem::path stagingPath(const std::string& url);
+
+    // Hashing reads the whole file, so it's done there rather than on the
+    // main thread once the download is done
+    static arc::Future<geode::Result<StagedFile>> downloadAndHash(std::string url, std::filesystem::path staging);
+
+    void startTransfers();
+    void onTransferFinished(const std::string& url, geode::Result<StagedFile>&& staged);
+
+public:
+    DownloadManager(const DownloadManager&) = delete;
+    DownloadManager(DownloadManager&&) = delete;
+
+    DownloadManager& operator=(const DownloadManager&) = delete;
+    DownloadManager& operator=(DownloadManager&&) = delete;
+
+    bool init();
+
+    /**
+     * Queues a download of url. Asking for a song that is already queued
+     * raises the priority of its transfer, and a higher priority request
+     * replaces the callback of the queued one.
+     *
+     * @param gdSongID song ID the download is for, progress is reported to it
+     * @param uniqueID unique ID of the song being downloaded
+     * @param callback called once the download finishes or fails, unless it
+     * gets cancelled first
+     */
+    void enqueue(const std::string& url, DownloadPriority priority, int gdSongID, std::string uniqueID,
+                 Callback callback);
+
+    /**
+     * Cancels the download of a song. A transfer that already started keeps
+     * going for any other song waiting on it, but this song won't be told
+     * about it. Sends SongDownloadFailed with s_cancelled as the error.
+     *
+     * @return whether the song was waiting on a download
+     */
+    bool cancel(int gdSongID, std::string_view uniqueID);
+
+    [[nodiscard]] bool isDownloading(int gdSongID, std::string_view uniqueID) const;
+
+    /**
+     * Whether a file belongs to a queued or running transfer, either where it
+     * is being downloaded to or the files kept to resume it
+     */
+    [[nodiscard]] bool isStaging(const std::filesystem::path& path) const;
+
+    static DownloadManager& get() {
+        static DownloadManager instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
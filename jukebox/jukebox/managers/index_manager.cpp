@@ -1,14 +1,19 @@
 #include <jukebox/managers/index_manager.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
-
 #include <functional>
 #include <ios>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
-#include <variant>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
@@ -23,24 +28,37 @@
 #include <arc/future/Future.hpp>
 #include <matjson.hpp>
 
-#include <jukebox/download/hosted.hpp>
-#include <jukebox/events/file_download_progress.hpp>
 #include <jukebox/events/song_download_failed.hpp>
 #include <jukebox/events/song_download_finished.hpp>
-#include <jukebox/events/song_download_progress.hpp>
 #include <jukebox/events/song_error.hpp>
 #include <jukebox/events/start_download.hpp>
+#include <jukebox/managers/download_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
 #include <jukebox/nong/index.hpp>
+#include <jukebox/nong/index_delta.hpp>
+#include <jukebox/nong/index_parser.hpp>
 #include <jukebox/nong/index_serialize.hpp>
+#include <jukebox/nong/index_sidecar.hpp>
 #include <jukebox/nong/nong.hpp>
+#include <jukebox/nong/song_search.hpp>
 #include <jukebox/ui/indexes_setting.hpp>
+#include <jukebox/utils/file.hpp>
+#include <jukebox/utils/hash.hpp>
 #include <jukebox/utils/web.hpp>
 
 using namespace geode::prelude;
 using namespace jukebox::index;
 using namespace arc;
 
+namespace {
+
+template <typename T>
+std::optional<std::string> toOptionalString(const std::optional<T>& value) {
+    return value.transform([](const auto& v) { return std::string(v); });
+}
+
+}  // namespace
+
 namespace jukebox {
 
 bool IndexManager::init() {
@@ -52,11 +70,9 @@ bool IndexManager::init() {
         std::filesystem::create_directory(path);
     }
 
-    async::spawn(this->fetchIndexes(), [](Result<> result) {
-        if (GEODE_UNWRAP_IF_ERR(err, result)) {
-            log::error("Failed to start fetching indexes: {}", err);
-        }
-    });
+    if (GEODE_UNWRAP_IF_ERR(err, this->fetchIndexes())) {
+        log::error("Failed to start fetching indexes: {}", err);
+    }
 
     event::StartDownload()
         .listen([this](const event::StartDownloadData& event) {
@@ -68,18 +84,6 @@ bool IndexManager::init() {
         })
         .leak();
 
-    events::FileDownloadProgress()
-        .listen([this](const events::FileDownloadProgressData& event) {
-            const auto url = std::string(event.url());
-            if (const auto& it = m_urlToIDs.find(url); it != m_urlToIDs.end()) {
-                const int gdId = std::get<int>(it->second);
-                auto uniqueID = std::get<std::string>(it->second);
-                event::SongDownloadProgress(gdId).send(
-                    event::SongDownloadProgressData{gdId, std::move(uniqueID), event.progress()});
-            }
-        })
-        .leak();
-
     m_initialized = true;
     return true;
 }
@@ -94,106 +98,237 @@ std::filesystem::path IndexManager::baseIndexesPath() {
     return path;
 }
 
-Result<> IndexManager::loadIndex(std::filesystem::path path) {
+Result<IndexManager::PreparedIndex> IndexManager::prepareCachedIndex(const std::filesystem::path& path,
+                                                                     std::optional<std::string_view> url) {
     if (!std::filesystem::exists(path)) {
         return Err("Index file does not exist");
     }
 
-    GEODE_UNWRAP_INTO(matjson::Value jsonObj, geode::utils::file::readJson(path));
+    GEODE_UNWRAP_INTO(std::string contents, geode::utils::file::readString(path));
 
-    return this->loadIndex(std::move(jsonObj));
+    const uint64_t hash = fnv1a64(contents);
+    std::filesystem::path sidecarPath = path;
+    sidecarPath.replace_extension(".idx");
+
+    if (GEODE_UNWRAP_EITHER(loaded, err, IndexSidecar::read(sidecarPath, hash))) {
+        SongSearch search = this->loadSongSearch(path, *loaded.index, hash);
+        return Ok(this->prepareIndex(std::move(loaded.index), loaded.lookup, std::move(search), {}));
+    } else if (std::error_code ec; std::filesystem::exists(sidecarPath, ec)) {
+        log::info("Ignoring index sidecar {}: {}", sidecarPath.filename(), err);
+    }
+
+    GEODE_UNWRAP_INTO(ParsedIndex parsed, parseIndexJson(contents, url));
+    const SongLookup lookup = buildSongLookup(*parsed.index);
+
+    this->writeSidecar(sidecarPath, *parsed.index, lookup, parsed.header, hash);
+    SongSearch search = this->loadSongSearch(path, *parsed.index, hash);
+
+    return Ok(this->prepareIndex(std::move(parsed.index), lookup, std::move(search), std::move(parsed.errors)));
 }
 
-Result<> IndexManager::loadIndex(matjson::Value&& jsonObj) {
-    GEODE_UNWRAP_INTO(auto indexMeta, jsonObj.as<IndexMetadata>());
-    auto index = std::make_unique<IndexMetadata>(std::move(indexMeta));
+Result<IndexManager::PreparedIndex> IndexManager::prepareFetchedIndex(const std::string& url, FetchedIndex&& fetched,
+                                                                      std::chrono::milliseconds latency) {
+    const std::filesystem::path filepath = this->cachePathForUrl(url);
+    const std::string& contents = fetched.m_body;
 
-    this->cacheIndexName(index->m_id, index->m_name);
+    log::info("Fetched index {} in {}ms ({:.1f} KiB)", url, latency.count(), contents.size() / 1024.0);
 
-    // TODO: re-enable youtube downloads at a later date
-    /*for (const auto& [key, ytNong] : jsonObj["nongs"]["youtube"].as_object())
-     * {*/
-    /*    Result<IndexSongMetadata> r =*/
-    /*        matjson::Serialize<IndexSongMetadata>::from_json(ytNong);*/
-    /*    if (r.isErr()) {*/
-    /*        event::SongError(*/
-    /*            false, fmt::format("Failed to parse index song: {}",
-     * r.error()))*/
-    /*            .post();*/
-    /*        continue;*/
-    /*    }*/
-    /*    std::unique_ptr<IndexSongMetadata> song =*/
-    /*        std::make_unique<IndexSongMetadata>(r.unwrap());*/
-    /*    song->uniqueID = key;*/
-    /*    song->parentID = index.get();*/
-    /**/
-    /*    for (int id : song->songIDs) {*/
-    /*        if (!m_nongsForId.contains(id)) {*/
-    /*            m_nongsForId[id] = {song.get()};*/
-    /*        } else {*/
-    /*            m_nongsForId[id].push_back(song.get());*/
-    /*        }*/
-    /**/
-    /*        std::optional<Nongs*> opt = NongManager::get().getNongs(id);*/
-    /*        if (!opt.has_value()) {*/
-    /*            continue;*/
-    /*        }*/
-    /**/
-    /*        Nongs* nongs = opt.value();*/
-    /**/
-    /*        if (geode::Result<> r = nongs->registerIndexSong(song.get());*/
-    /*            r.isErr()) {*/
-    /*            event::SongError(*/
-    /*                false,*/
-    /*                fmt::format("Failed to register index song: {}",
-     * r.error()))*/
-    /*                .post();*/
-    /*        }*/
-    /*    }*/
-    /*    index->m_songs.m_youtube.push_back(std::move(song));*/
-    /*}*/
-
-    for (const auto& [key, hostedNong] : jsonObj["nongs"]["hosted"]) {
-        GEODE_UNWRAP_OR_ELSE(r, err, hostedNong.as<IndexSongMetadata>()) {
-            event::SongError().send(event::SongErrorData{false, fmt::format("Failed to parse index song: {}", err)});
-            continue;
-        }
+    // Indexes don't contain their own url, the one they were fetched from is used
+    GEODE_UNWRAP_INTO(ParsedIndex parsed, parseIndexJson(contents, url));
+    const SongLookup lookup = buildSongLookup(*parsed.index);
+    SongSearch search;
+    bool cached = false;
 
-        auto song = std::make_unique<IndexSongMetadata>(std::move(r));
+    // Written atomically, so a cached copy is always whole even if the game
+    // closes halfway through
+    if (GEODE_UNWRAP_IF_ERR(err, utils::file::writeStringAtomic(filepath, contents))) {
+        log::error("Failed to cache index: {}", err);
+        search = SongSearch::build(*parsed.index);
+    } else {
+        log::info("Cached index: {}", url);
 
-        song->uniqueID = key;
-        song->parentID = index.get();
+        std::filesystem::path sidecarPath = filepath;
+        sidecarPath.replace_extension(".idx");
+        this->writeSidecar(sidecarPath, *parsed.index, lookup, parsed.header, fnv1a64(contents));
+        search = this->loadSongSearch(filepath, *parsed.index, fnv1a64(contents));
 
-        for (int id : song->songIDs) {
-            if (!m_nongsForId.contains(id)) {
-                m_nongsForId[id] = {song.get()};
-            } else {
-                m_nongsForId[id].push_back(song.get());
-            }
-            std::optional<Nongs*> opt = NongManager::get().getNongs(id);
-            if (!opt.has_value()) {
-                continue;
+        fetched.m_validators.m_lastUpdate = parsed.index->m_lastUpdate;
+        fetched.m_validators.m_deltaUrl = parsed.index->m_deltaUrl;
+        cached = true;
+    }
+
+    PreparedIndex prepared =
+        this->prepareIndex(std::move(parsed.index), lookup, std::move(search), std::move(parsed.errors));
+    // Without a cached copy, a 304 next time would point at one that doesn't exist
+    prepared.m_validators.emplace(cached ? std::optional(std::move(fetched.m_validators)) : std::nullopt);
+
+    return Ok(std::move(prepared));
+}
+
+IndexManager::PreparedIndex IndexManager::prepareIndex(std::unique_ptr<IndexMetadata>&& index, const SongLookup& lookup,
+                                                       SongSearch&& search, std::vector<std::string>&& errors) {
+    SongsForID songs;
+    VerifiedForLevel verified;
+
+    // The lookup is sorted by song ID, so every song ID is only hashed once
+    for (auto it = lookup.begin(); it != lookup.end();) {
+        const int id = it->first;
+        std::vector<IndexSongMetadata*>& forID = songs[id];
+
+        for (; it != lookup.end() && it->first == id; ++it) {
+            forID.push_back(it->second);
+
+            for (const int levelID : it->second->verifiedLevelIDs) {
+                verified[levelID].push_back(VerifiedSong{id, it->second});
             }
+        }
+    }
+
+    return PreparedIndex{std::move(index), std::move(songs), std::move(verified), std::move(search), std::move(errors)};
+}
+
+void IndexManager::publishIndex(PreparedIndex&& prepared) {
+    // Parse errors are reported here since events have to be sent from the main thread
+    for (std::string& err : prepared.m_errors) {
+        event::SongError().send(event::SongErrorData{false, std::move(err)});
+    }
+
+    IndexMetadata* index = prepared.m_index.get();
+
+    if (m_loadedIndexes.contains(index->m_id)) {
+        log::warn("Index {} is already loaded, ignoring {}", index->m_id, index->m_url);
+        // The cached copy was still replaced, so the old validators don't
+        // describe it anymore
+        if (prepared.m_validators) {
+            this->setValidators(index->m_url, std::nullopt);
+        }
+        return;
+    }
+
+    if (prepared.m_validators) {
+        this->setValidators(index->m_url, prepared.m_validators.value());
+    }
+
+    this->cacheIndexName(index->m_id, index->m_name);
+
+    m_loadedIndexes.emplace(index->m_id, std::move(prepared.m_index));
+    const SongsForID& songs = m_songsForIndex.emplace_back(std::move(prepared.m_songs));
+    m_searchForIndex.emplace_back(index, std::move(prepared.m_search));
+
+    for (auto& [levelID, verified] : prepared.m_verified) {
+        std::vector<VerifiedSong>& forLevel = m_verifiedForLevel[levelID];
+        if (forLevel.empty()) {
+            forLevel = std::move(verified);
+        } else {
+            forLevel.insert(forLevel.end(), verified.begin(), verified.end());
+        }
+    }
 
-            Nongs* nongs = opt.value();
+    // Only song IDs that are already loaded need to know about the new songs.
+    // Song IDs still packed in the snapshot pick them up once decoded.
+    for (const int id : NongManager::get().getLoadedSongIDs()) {
+        const auto it = songs.find(id);
+        if (it == songs.end()) {
+            continue;
+        }
+
+        Nongs* nongs = NongManager::get().getLoadedNongs(id).value();
 
-            if (GEODE_UNWRAP_IF_ERR(err, nongs->registerIndexSong(song.get()))) {
+        for (IndexSongMetadata* song : it->second) {
+            if (GEODE_UNWRAP_IF_ERR(err, nongs->registerIndexSong(song))) {
                 event::SongError().send(
                     event::SongErrorData{false, fmt::format("Failed to register index song: {}", err)});
             }
         }
+    }
+}
+
+std::vector<IndexSongMetadata*> IndexManager::songsForID(int gdSongID) {
+    std::vector<IndexSongMetadata*> ret;
 
-        index->m_songs.m_hosted.push_back(std::move(song));
+    for (const SongsForID& songs : m_songsForIndex) {
+        if (const auto it = songs.find(gdSongID); it != songs.end()) {
+            ret.insert(ret.end(), it->second.begin(), it->second.end());
+        }
     }
 
-    IndexMetadata* ref = index.get();
-    m_loadedIndexes.emplace(ref->m_id, std::move(index));
+    return ret;
+}
 
-    return Ok();
+std::span<const IndexManager::VerifiedSong> IndexManager::verifiedForLevel(const int levelID) const {
+    if (const auto it = m_verifiedForLevel.find(levelID); it != m_verifiedForLevel.end()) {
+        return it->second;
+    }
+
+    return {};
 }
 
-Future<Result<>> IndexManager::fetchIndexes() {
-    ARC_CO_UNWRAP_INTO(const std::vector<IndexSource> indexes, this->getIndexes());
+std::vector<SongMatch> IndexManager::searchSongs(const std::string_view query, const size_t limit) const {
+    std::vector<SongMatch> ret;
+
+    for (const auto& [index, search] : m_searchForIndex) {
+        search.search(*index, query, ret);
+    }
+
+    const auto better = [](const SongMatch& a, const SongMatch& b) {
+        if (a.m_score != b.m_score) {
+            return a.m_score > b.m_score;
+        }
+        return a.m_song->name < b.m_song->name;
+    };
+
+    if (ret.size() > limit) {
+        std::ranges::partial_sort(ret, ret.begin() + static_cast<std::ptrdiff_t>(limit), better);
+        ret.resize(limit);
+    } else {
+        std::ranges::sort(ret, better);
+    }
+
+    return ret;
+}
+
+void IndexManager::writeSidecar(const std::filesystem::path& path, const IndexMetadata& index,
+                                const SongLookup& lookup, std::string_view header, uint64_t hash) {
+    if (GEODE_UNWRAP_IF_ERR(err, IndexSidecar::write(path, index, lookup, header, hash))) {
+        log::error("Failed to write index sidecar {}: {}", path.filename(), err);
+    }
+}
+
+SongSearch IndexManager::loadSongSearch(const std::filesystem::path& path, const IndexMetadata& index,
+                                        const uint64_t hash) {
+    std::filesystem::path searchPath = path;
+    searchPath.replace_extension(".search");
+
+    if (GEODE_UNWRAP_EITHER(search, err, SongSearch::read(searchPath, hash, index.m_songs.m_hosted.size()))) {
+        return std::move(search);
+    } else if (std::error_code ec; std::filesystem::exists(searchPath, ec)) {
+        log::info("Rebuilding song search {}: {}", searchPath.filename(), err);
+    }
+
+    SongSearch search = SongSearch::build(index);
+
+    if (GEODE_UNWRAP_IF_ERR(err, search.write(searchPath, hash))) {
+        log::error("Failed to write song search {}: {}", searchPath.filename(), err);
+    }
+
+    return search;
+}
+
+std::filesystem::path IndexManager::cachePathForUrl(const std::string& url) {
+    static constexpr std::hash<std::string> hasher;
+    return this->baseIndexesPath() / fmt::format("{0:x}.json", hasher(url));
+}
+
+Result<> IndexManager::fetchIndexes() {
+    if (m_fetchesApplied < m_fetches.size()) {
+        return Err("Indexes are already being fetched");
+    }
+
+    GEODE_UNWRAP_INTO(const std::vector<IndexSource> indexes, this->getIndexes());
+
+    m_fetches.clear();
+    m_fetchesStarted = 0;
+    m_fetchesApplied = 0;
 
     for (const IndexSource& index : indexes) {
         if (!index.m_enabled || index.m_url.size() < 3) {
@@ -208,57 +343,198 @@ Future<Result<>> IndexManager::fetchIndexes() {
             continue;
         }
 
-        const std::string url = index.m_url;
+        // Fetches of the same url would write the same cached copy
+        if (std::ranges::any_of(m_fetches, [&index](const IndexFetch& fetch) {
+                return fetch.m_source.m_url == index.m_url;
+            })) {
+            log::warn("Skipping index {}, as it is listed twice", index.m_url);
+            continue;
+        }
 
-        log::info("Starting fetch for index {}", index.m_url);
+        m_fetches.push_back(IndexFetch{.m_source = index, .m_validators = this->getValidators(index.m_url)});
+    }
+
+    this->startIndexFetches();
+
+    return Ok();
+}
+
+void IndexManager::startIndexFetches() {
+    const auto maxInFlight =
+        static_cast<size_t>(std::max<int64_t>(1, Mod::get()->getSettingValue<int64_t>("max-index-fetches")));
+
+    while (m_fetchesInFlight < maxInFlight && m_fetchesStarted < m_fetches.size()) {
+        const size_t i = m_fetchesStarted++;
+        m_fetchesInFlight++;
+
+        log::info("Starting fetch for index {}", m_fetches[i].m_source.m_url);
+
+        async::spawn(this->fetchAndPrepareIndex(m_fetches[i].m_source, m_fetches[i].m_validators),
+                     [this, i](Result<PreparedIndex> result) {
+                         m_fetches[i].m_result = std::move(result);
+                         m_fetchesInFlight--;
+
+                         this->applyFetchedIndexes();
+                         this->startIndexFetches();
+                     });
+    }
+}
+
+void IndexManager::applyFetchedIndexes() {
+    // Fetches finish in any order, but are published in settings order so
+    // songs for a song ID are listed the same way on every start
+    while (m_fetchesApplied < m_fetches.size() && m_fetches[m_fetchesApplied].m_result.has_value()) {
+        IndexFetch& fetch = m_fetches[m_fetchesApplied++];
 
-        Result<matjson::Value> fetchedIndex = co_await this->fetchIndex(index);
+        Result<PreparedIndex> prepared = std::move(fetch.m_result).value();
+        fetch.m_result.reset();
 
-        if (GEODE_UNWRAP_EITHER(value, err, fetchedIndex)) {
-            co_await this->onIndexFetched(url, std::move(value));
+        if (GEODE_UNWRAP_EITHER(value, err, prepared)) {
+            this->publishIndex(std::move(value));
         } else {
-            log::error("Failed to fetch index {}: {}", index.m_url, err);
+            log::error("Failed to load index {}: {}", fetch.m_source.m_url, err);
         }
     }
+}
+
+Future<Result<IndexManager::PreparedIndex>> IndexManager::fetchAndPrepareIndex(IndexSource index,
+                                                                              IndexValidators validators) {
+    const std::string url = index.m_url;
+    const auto start = std::chrono::steady_clock::now();
+
+    Result<std::optional<FetchedIndex>> fetchedIndex = co_await this->fetchIndex(index, std::move(validators));
+
+    const auto latency =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
 
-    co_return Ok();
+    if (GEODE_UNWRAP_EITHER(value, err, fetchedIndex)) {
+        if (value.has_value()) {
+            co_return this->prepareFetchedIndex(url, std::move(value).value(), latency);
+        }
+
+        Result<PreparedIndex> cached = this->prepareCachedIndex(this->cachePathForUrl(url), url);
+        if (GEODE_UNWRAP_IF_ERR(err, cached)) {
+            // The validators describe a copy that can't be used, so download
+            // the whole index again. Its validators replace the stored ones.
+            log::warn("Index {} is unchanged, but the cached copy is unusable: {}", url, err);
+
+            Result<std::optional<FetchedIndex>> full = co_await this->fetchIndex(index, IndexValidators{});
+            ARC_CO_UNWRAP_INTO(std::optional<FetchedIndex> refetched, std::move(full));
+            if (!refetched.has_value()) {
+                co_return Err("Index {} came back unchanged without validators", url);
+            }
+
+            co_return this->prepareFetchedIndex(url, std::move(refetched).value(), latency);
+        }
+
+        log::info("Index {} is unchanged after {}ms, loaded cached copy", url, latency.count());
+        co_return std::move(cached);
+    } else {
+        log::error("Failed to fetch index {} after {}ms: {}", url, latency.count(), err);
+
+        Result<PreparedIndex> cached = this->prepareCachedIndex(this->cachePathForUrl(url), url);
+        if (cached.isErr()) {
+            co_return Err("No usable cached copy: {}", cached.unwrapErr());
+        }
+
+        log::info("Loaded cached copy of index {}", url);
+        co_return std::move(cached);
+    }
 }
 
-Future<Result<matjson::Value>> IndexManager::fetchIndex(const IndexSource& index) {
-    const web::WebResponse response = co_await web::WebRequest().timeout(std::chrono::seconds(30)).get(index.m_url);
+Future<Result<std::optional<IndexManager::FetchedIndex>>> IndexManager::fetchIndex(IndexSource index,
+                                                                                 IndexValidators validators) {
+    // Validators are worthless without the copy they were stored for
+    if (std::error_code ec; !std::filesystem::exists(this->cachePathForUrl(index.m_url), ec)) {
+        validators = IndexValidators{};
+    }
 
-    if (!response.ok()) {
-        co_return Err(utils::web::getErrorFromResponse(response));
+    if (validators.m_deltaUrl && validators.m_lastUpdate) {
+        Result<std::optional<FetchedIndex>> delta = co_await this->fetchIndexDelta(index, validators);
+
+        if (delta.isOk()) {
+            co_return delta;
+        }
+
+        log::info("Not using delta for index {}, fetching it fully: {}", index.m_url, delta.unwrapErr());
     }
 
-    ARC_CO_UNWRAP_INTO(matjson::Value jsonObj, response.json());
+    web::WebRequest request;
+    request.timeout(std::chrono::seconds(30));
 
-    jsonObj.set("url", index.m_url);
+    if (validators.m_etag) {
+        request.header("If-None-Match", validators.m_etag.value());
+    }
+    if (validators.m_lastModified) {
+        request.header("If-Modified-Since", validators.m_lastModified.value());
+    }
+
+    const web::WebResponse response = co_await request.get(index.m_url);
 
-    ARC_CO_UNWRAP(matjson::Serialize<IndexMetadata>::fromJson(jsonObj));
+    if (response.code() == 304 && (validators.m_etag || validators.m_lastModified)) {
+        co_return Ok(std::nullopt);
+    }
 
-    co_return Ok(std::move(jsonObj));
+    if (!response.ok()) {
+        co_return Err(utils::web::getErrorFromResponse(response));
+    }
+
+    ARC_CO_UNWRAP_INTO(std::string body, response.string());
+
+    // lastUpdate and the delta url are filled in once the index is parsed
+    co_return Ok(FetchedIndex{
+        .m_body = std::move(body),
+        .m_validators =
+            IndexValidators{
+                .m_etag = toOptionalString(response.header("ETag")),
+                .m_lastModified = toOptionalString(response.header("Last-Modified")),
+            },
+    });
 }
 
-Future<> IndexManager::onIndexFetched(const std::string& url, matjson::Value&& json) {
-    static constexpr std::hash<std::string> hasher;
-    std::size_t hashValue = hasher(url);
+Future<Result<std::optional<IndexManager::FetchedIndex>>> IndexManager::fetchIndexDelta(const IndexSource& index,
+                                                                                      IndexValidators validators) {
+    const web::WebResponse response =
+        co_await web::WebRequest().timeout(std::chrono::seconds(30)).get(validators.m_deltaUrl.value());
 
-    const std::filesystem::path filepath = this->baseIndexesPath() / fmt::format("{0:x}.json", hashValue);
+    if (!response.ok()) {
+        co_return Err(utils::web::getErrorFromResponse(response));
+    }
 
-    log::info("Fetched index: {}", url);
-    auto success = geode::utils::file::writeString(filepath, json.dump(matjson::NO_INDENTATION));
-    if (success.isErr()) {
-        log::error("Failed to cache index: {}", std::move(success).unwrapErr());
-    } else {
-        log::info("Cached index: {}", url);
+    ARC_CO_UNWRAP_INTO(matjson::Value delta, response.json());
+
+    if (delta["to"].asInt().ok() == validators.m_lastUpdate) {
+        co_return Ok(std::nullopt);
     }
 
-    this->loadIndex(std::move(json)).inspectErr([url](const std::string& err) {
-        log::error("Failed to load index {}: {}", url, err);
-    });
+    // Deltas are small, and rare enough that going through the DOM is fine
+    ARC_CO_UNWRAP_INTO(matjson::Value jsonObj, geode::utils::file::readJson(this->cachePathForUrl(index.m_url)));
+    ARC_CO_UNWRAP(applyIndexDelta(jsonObj, delta));
+
+    log::info("Applied delta to index {}, {} -> {}", index.m_url, validators.m_lastUpdate.value(),
+              std::as_const(jsonObj)["lastUpdate"].asInt().unwrapOr(0));
+
+    // The ETag and Last-Modified still describe the full index as it was last
+    // downloaded, so a full fetch after this one can still come back as a 304
+    co_return Ok(FetchedIndex{.m_body = jsonObj.dump(matjson::NO_INDENTATION), .m_validators = std::move(validators)});
+}
 
-    co_return;
+IndexValidators IndexManager::getValidators(const std::string& url) {
+    auto jsonObj = Mod::get()->getSavedValue<matjson::Value>("index-validators");
+    if (!jsonObj.contains(url)) {
+        return {};
+    }
+    return jsonObj[url].as<IndexValidators>().unwrapOr(IndexValidators{});
+}
+
+void IndexManager::setValidators(const std::string& url, const std::optional<IndexValidators>& validators) {
+    auto jsonObj = Mod::get()->getSavedValue<matjson::Value>("index-validators", matjson::Value::object());
+    if (validators.has_value()) {
+        jsonObj.set(url, matjson::Serialize<IndexValidators>::toJson(validators.value()));
+    } else {
+        jsonObj.erase(url);
+    }
+    Mod::get()->setSavedValue("index-validators", jsonObj);
 }
 
 std::optional<std::string> IndexManager::getIndexName(const std::string& indexID) {
@@ -276,7 +552,7 @@ void IndexManager::cacheIndexName(const std::string& indexId, const std::string&
     Mod::get()->setSavedValue("cached-index-names", jsonObj);
 }
 
-Result<> IndexManager::downloadSong(int gdSongID, const std::string_view uniqueID) {
+Result<> IndexManager::downloadSong(int gdSongID, const std::string_view uniqueID, const DownloadPriority priority) {
     Nongs* nongs = nullptr;
 
     if (!NongManager::get().hasSongID(gdSongID)) {
@@ -293,52 +569,40 @@ Result<> IndexManager::downloadSong(int gdSongID, const std::string_view uniqueI
     bool found = false;
 
     // Try starting download from local reference first
-    for (const std::unique_ptr<YTSong>& song : nongs->youtube()) {
-        if (song->metadata()->uniqueID != uniqueID) {
-            continue;
-        }
-
+    const std::optional<Song*> local = nongs->findSong(std::string(uniqueID));
+    if (local.has_value() && local.value()->type() == NongType::YOUTUBE) {
         return Err("YouTube song downloads will be enabled in a future release!");
-
-        /*Result<DownloadSongTask> t = song->startDownload();*/
-        /*if (t.isErr()) {*/
-        /*    return Err("Failed to start download: {}", t.error());*/
-        /*}*/
-        /**/
-        /*task = t.unwrap();*/
-        /*found = true;*/
-        /*local = song.get();*/
-        /*break;*/
     }
 
-    for (const std::unique_ptr<HostedSong>& song : nongs->hosted()) {
-        if (song->metadata()->uniqueID != uniqueID) {
-            continue;
+    if (local.has_value() && local.value()->type() == NongType::HOSTED) {
+        auto* song = dynamic_cast<HostedSong*>(local.value());
+
+        if (song->path().has_value() && NongManager::get().pathCache().exists(song->path().value())) {
+            return Err("Song already is downloaded");
         }
 
-        m_urlToIDs[song->url()] = {song->metadata()->gdID, std::string(uniqueID)};
-        async::spawn(song->startDownload(),
-                     [this, song = song.get(), nongs, uniqueID = std::string(uniqueID)](Result<ByteVector> data) {
-                         m_urlToIDs.erase(song->url());
-                         if (data.isErr()) {
-                             event::SongDownloadFailed(nongs->songID())
-                                 .send(event::SongDownloadFailedData{nongs->songID(), uniqueID, data.unwrapErr()});
-                             return;
-                         }
-                         this->onDownloadFinish(song, nongs, std::move(data.unwrap()));
-                     });
+        DownloadManager::get().enqueue(
+            song->url(), priority, gdSongID, std::string(uniqueID),
+            [this, gdSongID, priority, uniqueID = std::string(uniqueID)](Result<std::filesystem::path> res) {
+                if (res.isErr()) {
+                    event::SongDownloadFailed(gdSongID)
+                        .send(event::SongDownloadFailedData{gdSongID, uniqueID, res.unwrapErr()});
+                    return;
+                }
+                this->onDownloadFinish(gdSongID, uniqueID, res.unwrap(), priority);
+            });
 
         found = true;
-        break;
     }
 
     // If not uniqueID not found in local songs, search in indexes
     if (!found) {
-        if (!m_nongsForId.contains(gdSongID)) {
+        const std::vector<IndexSongMetadata*> indexSongs = this->songsForID(gdSongID);
+        if (indexSongs.empty()) {
             return Err("Can't download nong for id {}. No local or index songs found.", gdSongID);
         }
 
-        for (IndexSongMetadata* s : m_nongsForId[gdSongID]) {
+        for (IndexSongMetadata* s : indexSongs) {
             if (s->uniqueID != uniqueID) {
                 continue;
             }
@@ -348,17 +612,15 @@ Result<> IndexManager::downloadSong(int gdSongID, const std::string_view uniqueI
             }
 
             if (s->url.has_value()) {
-                m_urlToIDs[s->url.value()] = {nongs->songID(), std::string(uniqueID)};
-                async::spawn(
-                    download::startHostedDownload(s->url.value()),
-                    [this, s, nongs, uniqueID = std::string(uniqueID)](Result<ByteVector> data) {
-                        m_urlToIDs.erase(s->url.value());
-                        if (data.isErr()) {
-                            event::SongDownloadFailed(nongs->songID())
-                                .send(event::SongDownloadFailedData{nongs->songID(), uniqueID, data.unwrapErr()});
+                DownloadManager::get().enqueue(
+                    std::string(s->url.value()), priority, gdSongID, std::string(uniqueID),
+                    [this, gdSongID, priority, uniqueID = std::string(uniqueID)](Result<std::filesystem::path> res) {
+                        if (res.isErr()) {
+                            event::SongDownloadFailed(gdSongID)
+                                .send(event::SongDownloadFailedData{gdSongID, uniqueID, res.unwrapErr()});
                             return;
                         }
-                        this->onDownloadFinish(s, nongs, std::move(data.unwrap()));
+                        this->onDownloadFinish(gdSongID, uniqueID, res.unwrap(), priority);
                     });
 
                 found = true;
@@ -374,78 +636,59 @@ Result<> IndexManager::downloadSong(int gdSongID, const std::string_view uniqueI
     return Ok();
 }
 
-void IndexManager::onDownloadFinish(std::variant<IndexSongMetadata*, Song*>&& source, Nongs* destination,
-                                    ByteVector&& data) {
-    std::string uniqueId;
-    if (std::holds_alternative<index::IndexSongMetadata*>(source)) {
-        uniqueId = std::get<index::IndexSongMetadata*>(source)->uniqueID;
-    } else {
-        uniqueId = std::get<Song*>(source)->metadata()->uniqueID;
-    }
+void IndexManager::onDownloadFinish(const int gdSongID, const std::string& uniqueId, const std::filesystem::path& path,
+                                    const DownloadPriority priority) {
+    const bool background = priority == DownloadPriority::BACKGROUND;
+
+    const std::function<void(std::string)> orElse = [gdSongID, uniqueId, path](std::string err) {
+        const std::string print = fmt::format("Couldn't store index song. {}", err);
+        log::error("{}", print);
+        event::SongDownloadFailed(gdSongID).send(event::SongDownloadFailedData{gdSongID, uniqueId, print});
+        NongManager::get().releaseAudio(path);
+    };
 
-    if (data.empty()) {
-        const std::string err = "Failed to store downloaded file. ByteVector empty.";
-        log::error("{}", err);
-        event::SongDownloadFailed(destination->songID())
-            .send(event::SongDownloadFailedData{destination->songID(), uniqueId, err});
+    // The song ID, the song or its index may have gone away while the song
+    // was downloading, so everything is looked up again
+    const std::optional<Nongs*> nongs = NongManager::get().getNongs(gdSongID);
+    if (!nongs.has_value()) {
+        orElse(fmt::format("Song ID {} was removed during the download", gdSongID));
         return;
     }
+    Nongs* destination = nongs.value();
 
-    std::filesystem::path path;
-
-    if (std::holds_alternative<IndexSongMetadata*>(source)) {
-        auto s = std::get<IndexSongMetadata*>(source);
-        path = NongManager::get().baseNongsPath() / fmt::format("{}-{}.mp3", s->parentID->m_id, s->uniqueID);
-    } else {
-        std::string name;
+    Song* insertedSong = nullptr;
 
-        if (auto song = std::get<Song*>(source); song->indexID().has_value()) {
-            name = fmt::format("{}-{}.mp3", song->indexID().value(), song->metadata()->uniqueID);
-        } else {
-            name = fmt::format("{}.mp3", song->metadata()->uniqueID);
+    if (const std::optional<Song*> local = destination->findSong(uniqueId); local.has_value()) {
+        if (local.value()->type() != NongType::HOSTED) {
+            orElse("Song was replaced during the download");
+            return;
         }
 
-        path = NongManager::get().baseNongsPath() / name;
-    }
-
-    std::ofstream out(path, std::ios_base::out | std::ios_base::binary);
-
-    if (!out.is_open()) {
-        const std::string err = "Failed to store downloaded file. Couldn't open file for write";
-        log::error("{}", err);
-        event::SongDownloadFailed(destination->songID())
-            .send(event::SongDownloadFailedData{destination->songID(), uniqueId, err});
+        local.value()->setPath(path);
+        (void)NongManager::get().saveNongs(gdSongID, ManifestOp::Update, uniqueId);
+        event::SongDownloadFinished().send(event::SongDownloadFinishedData(std::nullopt, local.value(), background));
         return;
     }
 
-    out.write(reinterpret_cast<const char*>(data.data()), data.size());
-    out.close();
-
-    Song* insertedSong = nullptr;
+    IndexSongMetadata* metadata = nullptr;
+    for (IndexSongMetadata* s : this->songsForID(gdSongID)) {
+        if (s->uniqueID == uniqueId) {
+            metadata = s;
+            break;
+        }
+    }
 
-    if (std::holds_alternative<Song*>(source)) {
-        auto localSong = std::get<Song*>(source);
-        localSong->setPath(path);
-        event::SongDownloadFinished().send(event::SongDownloadFinishedData(std::nullopt, std::get<Song*>(source)));
+    if (!metadata) {
+        orElse("Song was removed from its index during the download");
         return;
     }
 
-    auto metadata = std::get<IndexSongMetadata*>(source);
-
-    const std::function<void(std::string)> orElse = [destination, uniqueId, path](std::string err) {
-        const std::string print = fmt::format("Couldn't store index song. {}", err);
-        log::error("{}", print);
-        event::SongDownloadFailed(destination->songID())
-            .send(event::SongDownloadFailedData{destination->songID(), uniqueId, print});
-        std::error_code ec;
-        std::filesystem::remove(path, ec);
-    };
-
     if (metadata->url.has_value()) {
         Result<HostedSong*> r =
-            destination->add(HostedSong(SongMetadata(destination->songID(), metadata->uniqueID, metadata->name,
-                                                     metadata->artist, std::nullopt, metadata->startOffset),
-                                        metadata->url.value(), metadata->parentID->m_id, path));
+            destination->add(HostedSong(SongMetadata(destination->songID(), std::string(metadata->uniqueID),
+                                                     std::string(metadata->name), std::string(metadata->artist),
+                                                     std::nullopt, metadata->startOffset),
+                                        std::string(metadata->url.value()), metadata->parentID->m_id, path));
 
         if (r.isErr()) {
             orElse(r.unwrapErr());
@@ -455,9 +698,10 @@ void IndexManager::onDownloadFinish(std::variant<IndexSongMetadata*, Song*>&& so
         insertedSong = r.unwrap();
     } else if (metadata->ytId.has_value()) {
         Result<YTSong*> r =
-            destination->add(YTSong(SongMetadata(destination->songID(), metadata->uniqueID, metadata->name,
-                                                 metadata->artist, std::nullopt, metadata->startOffset),
-                                    metadata->ytId.value(), metadata->parentID->m_id, path));
+            destination->add(YTSong(SongMetadata(destination->songID(), std::string(metadata->uniqueID),
+                                                 std::string(metadata->name), std::string(metadata->artist),
+                                                 std::nullopt, metadata->startOffset),
+                                    std::string(metadata->ytId.value()), metadata->parentID->m_id, path));
         if (r.isErr()) {
             orElse(r.unwrapErr());
             return;
@@ -470,20 +714,19 @@ void IndexManager::onDownloadFinish(std::variant<IndexSongMetadata*, Song*>&& so
         return;
     }
 
-    (void)destination->commit();
+    (void)NongManager::get().saveNongs(gdSongID, ManifestOp::Add, uniqueId);
 
-    event::SongDownloadFinished().send(event::SongDownloadFinishedData{std::optional(metadata), insertedSong});
+    event::SongDownloadFinished().send(
+        event::SongDownloadFinishedData{std::optional(metadata), insertedSong, background});
 }
 
 void IndexManager::registerIndexNongs(Nongs* destination) {
-    if (!m_nongsForId.contains(destination->songID())) {
+    std::vector<IndexSongMetadata*> songs = this->songsForID(destination->songID());
+    if (songs.empty()) {
         return;
     }
 
-    destination->indexSongs().clear();
-    for (IndexSongMetadata* s : m_nongsForId[destination->songID()]) {
-        destination->indexSongs().push_back(s);
-    }
+    destination->indexSongs() = std::move(songs);
 }
 
 };  // namespace jukebox
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <unordered_map>
-#include <variant>
+#include <utility>
+#include <vector>
 
 #include <Geode/Result.hpp>
 #include <Geode/utils/general.hpp>
@@ -12,25 +19,116 @@
 #include <matjson.hpp>
 
 #include <jukebox/events/start_download.hpp>
+#include <jukebox/managers/download_manager.hpp>
 #include <jukebox/nong/index.hpp>
+#include <jukebox/nong/index_sidecar.hpp>
 #include <jukebox/nong/nong.hpp>
+#include <jukebox/nong/song_search.hpp>
 
 namespace jukebox {
 
 class IndexManager {
+public:
+    // An index song verified for a level, along with the song ID of the level
+    // it replaces
+    struct VerifiedSong {
+        int m_songID;
+        index::IndexSongMetadata* m_song;
+    };
+
 protected:
     bool m_initialized = false;
 
     IndexManager() = default;
 
-    std::unordered_map<int, std::vector<index::IndexSongMetadata*>> m_nongsForId {};
-    std::unordered_map<std::string, std::tuple<int, std::string>> m_urlToIDs {};
+    using SongsForID = std::unordered_map<int, std::vector<index::IndexSongMetadata*>>;
+    using VerifiedForLevel = std::unordered_map<int, std::vector<VerifiedSong>>;
+
+    // An index that has been parsed, but not published yet. Building one is
+    // done off the main thread, and only touches the files cached for its url.
+    // Only one fetch of a url runs at a time, and cached copies aren't loaded
+    // while it does. Anything else it changes is applied by publishIndex.
+    struct PreparedIndex {
+        std::unique_ptr<index::IndexMetadata> m_index;
+        SongsForID m_songs;
+        VerifiedForLevel m_verified;
+        index::SongSearch m_search;
+        // Song parse errors, reported when the index is published
+        std::vector<std::string> m_errors;
+        // Validators stored for the url once the index is published, set
+        // if it was fetched. Holds nullopt if the stored ones should go.
+        std::optional<std::optional<index::IndexValidators>> m_validators = std::nullopt;
+    };
+
+    // Songs of every loaded index by song ID, in the order indexes were loaded
+    std::vector<SongsForID> m_songsForIndex {};
+    // Verified songs of every loaded index by level ID
+    VerifiedForLevel m_verifiedForLevel {};
+    // Song search of every loaded index, in the order indexes were loaded
+    std::vector<std::pair<index::IndexMetadata*, index::SongSearch>> m_searchForIndex {};
+
+    // Raw index JSON as it came from the host
+    struct FetchedIndex {
+        std::string m_body;
+        index::IndexValidators m_validators;
+    };
+
+    struct IndexFetch {
+        index::IndexSource m_source;
+        // Read when the fetch is created, saved values can only be used on
+        // the main thread
+        index::IndexValidators m_validators;
+        // Set once the fetch finishes, until it is published
+        std::optional<geode::Result<PreparedIndex>> m_result = std::nullopt;
+    };
+
+    // Fetches of the current fetchIndexes call, in settings order
+    std::vector<IndexFetch> m_fetches {};
+    size_t m_fetchesStarted = 0;
+    size_t m_fetchesApplied = 0;
+    size_t m_fetchesInFlight = 0;
 
     void onDownloadProgress(int gdSongID, const std::string& uniqueId, float progress);
-    void onDownloadFinish(std::variant<index::IndexSongMetadata*, Song*>&& source, Nongs* destination,
-                          geode::ByteVector&& data);
-    arc::Future<geode::Result<matjson::Value>> fetchIndex(const index::IndexSource& index);
-    arc::Future<> onIndexFetched(const std::string& url, matjson::Value&& json);
+    /**
+     * Stores a finished download. Only IDs are kept while downloading, since
+     * the song or its index can go away meanwhile, in which case the download
+     * is dropped.
+     */
+    void onDownloadFinish(int gdSongID, const std::string& uniqueId, const std::filesystem::path& path,
+                          DownloadPriority priority);
+    /**
+     * Fetches an index, asking the host for a delta or a 304 first if there is
+     * a cached copy. Resolves to nullopt if the cached copy is up to date.
+     */
+    arc::Future<geode::Result<std::optional<FetchedIndex>>> fetchIndex(index::IndexSource index,
+                                                                       index::IndexValidators validators);
+    arc::Future<geode::Result<std::optional<FetchedIndex>>> fetchIndexDelta(const index::IndexSource& index,
+                                                                          index::IndexValidators validators);
+    arc::Future<geode::Result<PreparedIndex>> fetchAndPrepareIndex(index::IndexSource index,
+                                                                   index::IndexValidators validators);
+    void startIndexFetches();
+    void applyFetchedIndexes();
+
+    geode::Result<PreparedIndex> prepareCachedIndex(const std::filesystem::path& path,
+                                                    std::optional<std::string_view> url);
+    geode::Result<PreparedIndex> prepareFetchedIndex(const std::string& url, FetchedIndex&& fetched,
+                                                     std::chrono::milliseconds latency);
+    PreparedIndex prepareIndex(std::unique_ptr<index::IndexMetadata>&& index, const index::SongLookup& lookup,
+                               index::SongSearch&& search, std::vector<std::string>&& errors);
+    /**
+     * Makes a prepared index visible, and registers its songs with song IDs
+     * that are already loaded. Must run on the main thread.
+     */
+    void publishIndex(PreparedIndex&& prepared);
+
+    void writeSidecar(const std::filesystem::path& path, const index::IndexMetadata& index,
+                      const index::SongLookup& lookup, std::string_view header, uint64_t hash);
+    /**
+     * Reads the song search cached next to an index, or builds it and caches
+     * it if there is no usable one
+     */
+    index::SongSearch loadSongSearch(const std::filesystem::path& path, const index::IndexMetadata& index,
+                                     uint64_t hash);
 
 public:
     IndexManager(const IndexManager&) = delete;
@@ -45,22 +143,54 @@ public:
 
     [[nodiscard]] bool initialized() const { return m_initialized; }
 
-    arc::Future<geode::Result<>> fetchIndexes();
-
-    geode::Result<> loadIndex(std::filesystem::path path);
-    geode::Result<> loadIndex(matjson::Value&& jsonObj);
+    /**
+     * Starts fetching every enabled index, at most max-index-fetches at a
+     * time. Indexes are loaded on the main thread as they come in, in the
+     * order they appear in the settings.
+     */
+    geode::Result<> fetchIndexes();
 
     geode::Result<std::vector<index::IndexSource>> getIndexes();
 
     std::optional<std::string> getIndexName(const std::string& indexID);
     void cacheIndexName(const std::string& indexId, const std::string& indexName);
 
+    index::IndexValidators getValidators(const std::string& url);
+    void setValidators(const std::string& url, const std::optional<index::IndexValidators>& validators);
+
     std::filesystem::path baseIndexesPath();
+    std::filesystem::path cachePathForUrl(const std::string& url);
 
-    geode::Result<> downloadSong(int gdSongID, std::string_view uniqueID);
+    /**
+     * Queues a download of a song, either one added locally or one from an
+     * index, through DownloadManager. Songs downloaded with background
+     * priority aren't made active once done.
+     */
+    geode::Result<> downloadSong(int gdSongID, std::string_view uniqueID,
+                                 DownloadPriority priority = DownloadPriority::USER);
 
     void registerIndexNongs(Nongs* destination);
 
+    /**
+     * Gets the songs of every loaded index for a song ID
+     */
+    std::vector<index::IndexSongMetadata*> songsForID(int gdSongID);
+
+    /**
+     * Gets the songs verified for a level, from every loaded index. Only valid
+     * until the next index is loaded.
+     */
+    [[nodiscard]] std::span<const VerifiedSong> verifiedForLevel(int levelID) const;
+
+    /**
+     * Searches the names and artists of the songs of every loaded index,
+     * tolerating a typo or two. Best matches come first.
+     *
+     * @param query what the user typed so far, the last word can be partial
+     * @param limit how many matches to return at most
+     */
+    [[nodiscard]] std::vector<index::SongMatch> searchSongs(std::string_view query, size_t limit = 50) const;
+
     static IndexManager& get() {
         static IndexManager instance;
         return instance;
@@ -1,13 +1,21 @@
 #include <jukebox/managers/nong_manager.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 #include <Geode/Result.hpp>
@@ -25,38 +33,261 @@
 #include <jukebox/events/song_download_finished.hpp>
 #include <jukebox/events/song_error.hpp>
 #include <jukebox/managers/index_manager.hpp>
+#include <jukebox/nong/blob_store.hpp>
+#include <jukebox/nong/manifest_journal.hpp>
+#include <jukebox/nong/manifest_snapshot.hpp>
+#include <jukebox/nong/manifest_writer.hpp>
 #include <jukebox/nong/nong.hpp>
 #include <jukebox/nong/nong_serialize.hpp>
+#include <jukebox/utils/asset_size_cache.hpp>
+#include <jukebox/utils/file.hpp>
+#include <jukebox/utils/parallel.hpp>
+#include <jukebox/utils/path_cache.hpp>
 #include <jukebox/utils/random_string.hpp>
+#include <jukebox/utils/sha256.hpp>
 
 using namespace geode::prelude;
 
-namespace jukebox {
+namespace {
 
-std::optional<Nongs*> NongManager::getNongs(int songID) {
-    if (!m_manifest.m_nongs.contains(songID)) {
-        return std::nullopt;
+// A song whose audio is being moved into the blob store
+struct BlobMigration {
+    int m_songID;
+    std::string m_uniqueID;
+    std::filesystem::path m_path;
+};
+
+arc::Future<std::vector<Result<std::string>>> hashFiles(std::vector<std::filesystem::path> files) {
+    std::vector<Result<std::string>> ret;
+    ret.reserve(files.size());
+    for (const std::filesystem::path& file : files) {
+        ret.push_back(jukebox::sha256File(file));
+    }
+    co_return ret;
+}
+
+constexpr std::array<std::string_view, 3> SONG_LISTS = {"locals", "youtube", "hosted"};
+
+std::string_view songList(const jukebox::NongType type) {
+    switch (type) {
+        case jukebox::NongType::LOCAL:
+            return "locals";
+        case jukebox::NongType::YOUTUBE:
+            return "youtube";
+        case jukebox::NongType::HOSTED:
+            return "hosted";
     }
+    return "locals";
+}
 
-    return m_manifest.m_nongs[songID].get();
+matjson::Value songToJson(const jukebox::Song* song) {
+    switch (song->type()) {
+        case jukebox::NongType::LOCAL:
+            return matjson::Serialize<jukebox::LocalSong>::toJson(*static_cast<const jukebox::LocalSong*>(song));
+        case jukebox::NongType::YOUTUBE:
+            return matjson::Serialize<jukebox::YTSong>::toJson(*static_cast<const jukebox::YTSong*>(song));
+        case jukebox::NongType::HOSTED:
+            return matjson::Serialize<jukebox::HostedSong>::toJson(*static_cast<const jukebox::HostedSong*>(song));
+    }
+    return matjson::Value();
 }
 
-std::vector<std::string> NongManager::getVerifiedNongsForLevel(int levelID, std::vector<int> songIDs) {
-    std::vector<std::string> verifiedNongs;
+// Journal payload for a change to a song ID. Full records hold the whole
+// song ID, every other record holds the active song and what the op needs.
+std::string describeChange(jukebox::Nongs* nongs, const jukebox::ManifestOp op, const std::string_view uniqueID) {
+    if (op == jukebox::ManifestOp::Full) {
+        return matjson::Serialize<jukebox::Nongs>::toJson(*nongs).dump(matjson::NO_INDENTATION);
+    }
+
+    matjson::Value change = matjson::makeObject({{"active", nongs->active()->metadata()->uniqueID}});
+
+    switch (op) {
+        case jukebox::ManifestOp::Add:
+        case jukebox::ManifestOp::Update: {
+            change["unique_id"] = std::string(uniqueID);
+
+            const std::optional<jukebox::Song*> song = nongs->findSong(std::string(uniqueID));
+            if (song) {
+                change["list"] = std::string(songList(song.value()->type()));
+                change["song"] = songToJson(song.value());
+            }
+            break;
+        }
+        case jukebox::ManifestOp::Delete:
+            change["unique_id"] = std::string(uniqueID);
+            break;
+        case jukebox::ManifestOp::Metadata:
+            change["name"] = nongs->defaultSong()->metadata()->name;
+            change["artist"] = nongs->defaultSong()->metadata()->artist;
+            break;
+        case jukebox::ManifestOp::Full:
+        case jukebox::ManifestOp::DeleteAll:
+        case jukebox::ManifestOp::SetActive:
+            break;
+    }
 
-    for (const int songID : songIDs) {
-        auto nongs = this->getNongs(songID);
+    return change.dump(matjson::NO_INDENTATION);
+}
 
-        if (!nongs.has_value()) {
+// Removes the song with the given unique ID from a song list, putting
+// replacement in its place if there is one. Returns whether it was found.
+bool replaceInList(matjson::Value& list, const std::string_view uniqueID, const matjson::Value* replacement) {
+    matjson::Value ret = matjson::Value::array();
+    bool found = false;
+
+    for (const matjson::Value& song : list) {
+        if (song["unique_id"].asString().unwrapOr("") != uniqueID) {
+            ret.push(song);
             continue;
         }
 
-        // For each indexSong, check if it contains the given levelID in its
-        // verifiedLevelIDs field.
-        for (const auto indexSong : nongs.value()->indexSongs()) {
-            if (auto& ids = indexSong->verifiedLevelIDs; std::ranges::find(ids, levelID) != ids.end()) {
-                verifiedNongs.push_back(indexSong->uniqueID);
+        found = true;
+        if (replacement) {
+            ret.push(*replacement);
+        }
+    }
+
+    list = std::move(ret);
+    return found;
+}
+
+// Applies a journal record made by describeChange to a serialized song ID,
+// the same way the change was made to the loaded one
+Result<> applyChange(matjson::Value& nongs, const jukebox::ManifestOp op, const matjson::Value& change) {
+    GEODE_UNWRAP_INTO(std::string active, change["active"].asString());
+
+    switch (op) {
+        case jukebox::ManifestOp::Add:
+        case jukebox::ManifestOp::Update: {
+            GEODE_UNWRAP_INTO(std::string uniqueID, change["unique_id"].asString());
+            const matjson::Value* song = change.contains("song") ? &change["song"] : nullptr;
+
+            // Added songs go at the end like in Nongs::add, even if they
+            // replace an existing one, updated ones stay where they were
+            bool found = false;
+            for (const std::string_view list : SONG_LISTS) {
+                found |= replaceInList(nongs[list], uniqueID, op == jukebox::ManifestOp::Update ? song : nullptr);
+            }
+
+            if (song && (op == jukebox::ManifestOp::Add || !found)) {
+                GEODE_UNWRAP_INTO(std::string list, change["list"].asString());
+                if (std::ranges::find(SONG_LISTS, list) == SONG_LISTS.end()) {
+                    return Err("Unknown song list {}", list);
+                }
+                nongs[list].push(*song);
             }
+            break;
+        }
+        case jukebox::ManifestOp::Delete: {
+            GEODE_UNWRAP_INTO(std::string uniqueID, change["unique_id"].asString());
+            for (const std::string_view list : SONG_LISTS) {
+                replaceInList(nongs[list], uniqueID, nullptr);
+            }
+            break;
+        }
+        case jukebox::ManifestOp::DeleteAll:
+            for (const std::string_view list : SONG_LISTS) {
+                nongs[list] = matjson::Value::array();
+            }
+            break;
+        case jukebox::ManifestOp::Metadata: {
+            GEODE_UNWRAP_INTO(std::string name, change["name"].asString());
+            GEODE_UNWRAP_INTO(std::string artist, change["artist"].asString());
+            nongs["default"]["name"] = name;
+            nongs["default"]["artist"] = artist;
+            break;
+        }
+        case jukebox::ManifestOp::Full:
+        case jukebox::ManifestOp::SetActive:
+            break;
+    }
+
+    nongs["active"] = active;
+    return Ok();
+}
+
+// Calls f with the file name of every song path in the stored JSON of a song
+// ID. Paths are plain strings there, so they're found without parsing it.
+template <typename F>
+void forEachPathName(const std::string_view raw, F&& f) {
+    constexpr std::string_view KEY = "\"path\":\"";
+
+    for (size_t at = raw.find(KEY); at != std::string_view::npos; at = raw.find(KEY, at)) {
+        at += KEY.size();
+
+        std::string path;
+        for (; at < raw.size() && raw[at] != '"'; at++) {
+            if (raw[at] == '\\' && at + 1 < raw.size()) {
+                at++;
+            }
+            path.push_back(raw[at]);
+        }
+
+        const size_t separator = path.find_last_of("/\\");
+        f(separator == std::string::npos ? std::move(path) : path.substr(separator + 1));
+    }
+}
+
+}  // namespace
+
+namespace jukebox {
+
+std::optional<Nongs*> NongManager::getNongs(int songID) {
+    if (std::optional<Nongs*> loaded = this->getLoadedNongs(songID)) {
+        return loaded;
+    }
+
+    if (!m_snapshot || !m_snapshot->contains(songID) || m_brokenSnapshotIDs.contains(songID)) {
+        return std::nullopt;
+    }
+
+    return this->decodeFromSnapshot(songID);
+}
+
+std::optional<Nongs*> NongManager::getLoadedNongs(int songID) {
+    if (const auto it = m_manifest.m_nongs.find(songID); it != m_manifest.m_nongs.end()) {
+        return it->second.get();
+    }
+
+    return std::nullopt;
+}
+
+std::vector<int> NongManager::getLoadedSongIDs() const {
+    std::vector<int> ret;
+    ret.reserve(m_manifest.m_nongs.size());
+    for (const auto& entry : m_manifest.m_nongs) {
+        ret.push_back(entry.first);
+    }
+    return ret;
+}
+
+std::optional<Nongs*> NongManager::decodeFromSnapshot(int songID) {
+    m_decodingSnapshot = true;
+    Result<std::unique_ptr<Nongs>> res = m_snapshot->decode(songID);
+    m_decodingSnapshot = false;
+
+    if (res.isErr()) {
+        log::error("Failed to decode song ID {} from the manifest snapshot: {}", songID, res.unwrapErr());
+        m_brokenSnapshotIDs.insert(songID);
+        return std::nullopt;
+    }
+
+    std::unique_ptr<Nongs> ptr = std::move(res.unwrap());
+    Nongs* nongs = ptr.get();
+    m_manifest.m_nongs.insert({songID, std::move(ptr)});
+    m_packedUnloaded--;
+    this->unindexPackedFiles(songID);
+    IndexManager::get().registerIndexNongs(nongs);
+
+    return nongs;
+}
+
+std::vector<std::string_view> NongManager::getVerifiedNongsForLevel(int levelID, std::vector<int> songIDs) {
+    std::vector<std::string_view> verifiedNongs;
+
+    for (const IndexManager::VerifiedSong& verified : IndexManager::get().verifiedForLevel(levelID)) {
+        if (std::ranges::find(songIDs, verified.m_songID) != songIDs.end()) {
+            verifiedNongs.push_back(verified.m_song->uniqueID);
         }
     }
 
@@ -65,11 +296,16 @@ std::vector<std::string> NongManager::getVerifiedNongsForLevel(int levelID, std:
 
 int NongManager::getCurrentManifestVersion() const { return m_manifest.m_version; }
 
-int NongManager::getStoredIDCount() const { return m_manifest.m_nongs.size(); }
+int NongManager::getStoredIDCount() const {
+    return static_cast<int>(m_manifest.m_nongs.size() + m_packedUnloaded);
+}
 
 int NongManager::adjustSongID(int id, bool robtop) { return robtop ? (id < 0 ? id : -id - 1) : id; }
 
-bool NongManager::hasSongID(int id) const { return m_manifest.m_nongs.contains(id); }
+bool NongManager::hasSongID(int id) const {
+    return m_manifest.m_nongs.contains(id) ||
+           (m_snapshot && m_snapshot->contains(id) && !m_brokenSnapshotIDs.contains(id));
+}
 
 Result<Nongs*> NongManager::initSongID(SongInfoObject* obj, int id, bool robtop) {
     int adjusted = this->adjustSongID(id, robtop);
@@ -82,6 +318,13 @@ Result<Nongs*> NongManager::initSongID(SongInfoObject* obj, int id, bool robtop)
         return Err("Critical. No song object for RobTop song");
     }
 
+    // Every path below loads the song ID, which may be a broken one from the
+    // snapshot
+    if (m_snapshot && m_snapshot->contains(adjusted)) {
+        m_packedUnloaded--;
+        this->unindexPackedFiles(adjusted);
+    }
+
     if (obj && robtop) {
         std::string filename = LevelTools::getAudioFileName(id);
         std::filesystem::path gdDir = std::filesystem::path(CCFileUtils::sharedFileUtils()->getWritablePath2().c_str());
@@ -146,7 +389,7 @@ bool NongManager::init() {
             defaultSongMetadata->name = event.songName();
             defaultSongMetadata->artist = event.artistName();
 
-            (void)this->saveNongs(event.gdId());
+            (void)this->saveNongs(event.gdId(), ManifestOp::Metadata);
 
             return ListenerResult::Propagate;
         })
@@ -154,6 +397,15 @@ bool NongManager::init() {
 
     event::SongDownloadFinished()
         .listen([this](const event::SongDownloadFinishedData& event) {
+            if (const std::optional<std::filesystem::path> path = event.destination()->path()) {
+                m_assetSizes.invalidate(path.value());
+            }
+            m_assetSizes.forgetMissing();
+
+            if (event.background()) {
+                return ListenerResult::Propagate;
+            }
+
             const auto nongsOpt = this->getNongs(event.destination()->metadata()->gdID);
 
             if (!nongsOpt) {
@@ -165,12 +417,16 @@ bool NongManager::init() {
             if (GEODE_UNWRAP_IF_ERR(err, nongs->setActive(event.destination()->metadata()->uniqueID))) {
                 log::error("Failed to set newly downloaded song {} as active: {}",
                            event.destination()->metadata()->uniqueID, err);
+            } else {
+                (void)this->saveNongs(nongs->songID(), ManifestOp::SetActive);
             }
 
             return ListenerResult::Propagate;
         })
         .leak();
 
+    m_assetSizes.load();
+
     log::info("Starting NONG read");
 
     const std::filesystem::path path = this->baseManifestPath();
@@ -181,16 +437,43 @@ bool NongManager::init() {
     if (const std::filesystem::path nongsPath = this->baseNongsPath(); !std::filesystem::exists(nongsPath)) {
         std::filesystem::create_directory(nongsPath);
     }
+    m_pathCache.watch(this->baseNongsPath());
+    if (std::error_code ec; std::filesystem::create_directories(blobs::basePath(), ec), !ec) {
+        m_pathCache.watch(blobs::basePath());
+    }
+
+    const auto readStart = std::chrono::steady_clock::now();
 
+    this->openSnapshot();
+
+    std::vector<std::filesystem::path> files;
     for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path)) {
         if (entry.path().extension() != ".json") {
             continue;
         }
 
-        auto res = this->loadNongsFromPath(entry.path());
+        files.push_back(entry.path());
+    }
+
+    // Parsing is independent per file, so spread it over a few threads, then
+    // merge everything back on this one in directory order
+    std::vector<std::optional<Result<std::unique_ptr<Nongs>>>> results(files.size());
+    std::atomic<int64_t> parseMicros = 0;
+
+    parallelFor(files.size(), [this, &files, &results, &parseMicros](size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        results[i] = this->loadNongsFromPath(files[i]);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        parseMicros += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    });
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const std::filesystem::path& file = files[i];
+        Result<std::unique_ptr<Nongs>> res = std::move(results[i]).value();
+
         if (res.isErr()) {
-            log::error("Failed to read file {}: {}", entry.path().filename(), res.unwrapErr());
-            std::filesystem::rename(entry.path(), path / fmt::format("{}.bak", entry.path().filename()));
+            log::error("Failed to read file {}: {}", file.filename(), res.unwrapErr());
+            std::filesystem::rename(file, path / fmt::format("{}.bak", file.filename()));
             continue;
         }
 
@@ -200,16 +483,115 @@ bool NongManager::init() {
         m_manifest.m_nongs.insert({id, std::move(ptr)});
     }
 
-    log::info("Read {} files successfully!", m_manifest.m_nongs.size());
+    const auto readElapsed = std::chrono::steady_clock::now() - readStart;
+    log::info("Read {} files successfully in {}ms using {} threads ({}ms of sequential parsing work)",
+              m_manifest.m_nongs.size(), std::chrono::duration_cast<std::chrono::milliseconds>(readElapsed).count(),
+              parallelWorkerCount(files.size()), parseMicros.load() / 1000);
+
+    this->replayJournal();
+
+    if (m_snapshot && !Mod::get()->getSettingValue<bool>("packed-manifest")) {
+        log::info("Packed manifest is disabled, unpacking {} song IDs", m_snapshot->size());
+        if (GEODE_UNWRAP_IF_ERR(err, this->exportSnapshot())) {
+            log::error("Failed to unpack manifest snapshot: {}", err);
+        }
+    }
 
     if (Result<> res = this->migrateV2(); res.isErr()) {
         log::error("{}", res.unwrapErr());
     }
 
+    this->migrateToBlobs();
+    // Per-ID files and the journal may have loaded packed song IDs
+    this->countPackedUnloaded();
+    this->indexPackedFiles();
+
     m_initialized = true;
     return true;
 }
 
+void NongManager::migrateToBlobs() {
+    std::vector<BlobMigration> pending;
+    std::vector<std::filesystem::path> files;
+
+    const auto collect = [this, &pending, &files](const int songID, const Song* song) {
+        const std::optional<std::filesystem::path> path = song->path();
+        if (!path.has_value() || path->parent_path() != this->baseNongsPath()) {
+            return;
+        }
+
+        if (std::error_code ec; !std::filesystem::exists(path.value(), ec)) {
+            return;
+        }
+
+        pending.push_back(BlobMigration{songID, song->metadata()->uniqueID, path.value()});
+        files.push_back(path.value());
+    };
+
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        for (const std::unique_ptr<LocalSong>& song : nongs->locals()) {
+            collect(id, song.get());
+        }
+        for (const std::unique_ptr<YTSong>& song : nongs->youtube()) {
+            collect(id, song.get());
+        }
+        for (const std::unique_ptr<HostedSong>& song : nongs->hosted()) {
+            collect(id, song.get());
+        }
+    }
+
+    if (files.empty()) {
+        return;
+    }
+
+    log::info("Moving {} songs into the blob store", files.size());
+
+    async::spawn(hashFiles(std::move(files)), [this, pending = std::move(pending)](
+                                                  std::vector<Result<std::string>> hashes) {
+        std::unordered_set<int> changed;
+
+        for (size_t i = 0; i < pending.size(); i++) {
+            const BlobMigration& migration = pending[i];
+
+            if (hashes[i].isErr()) {
+                log::warn("Couldn't move {} into the blob store: {}", migration.m_path.filename(),
+                          hashes[i].unwrapErr());
+                continue;
+            }
+
+            // The song may have been deleted or downloaded again while hashing
+            const std::optional<Nongs*> nongs = this->getLoadedNongs(migration.m_songID);
+            if (!nongs.has_value()) {
+                continue;
+            }
+            const std::optional<Song*> song = nongs.value()->findSong(migration.m_uniqueID);
+            if (!song.has_value() || song.value()->path() != migration.m_path) {
+                continue;
+            }
+
+            // Song IDs still packed in the snapshot aren't migrated, leave them
+            // their file
+            const bool keepSource = this->isInSnapshot(migration.m_path);
+
+            Result<std::filesystem::path> blob =
+                blobs::commit(migration.m_path, hashes[i].unwrap(), migration.m_path.extension(), keepSource);
+            if (blob.isErr()) {
+                log::warn("{}", blob.unwrapErr());
+                continue;
+            }
+
+            song.value()->setPath(std::move(blob).unwrap());
+            changed.insert(migration.m_songID);
+        }
+
+        for (const int id : changed) {
+            (void)this->saveNongs(id);
+        }
+
+        log::info("Moved songs of {} song IDs into the blob store", changed.size());
+    });
+}
+
 Result<> NongManager::migrateV2() {
     if (bool migrate = compat::v2::manifestExists(); !migrate) {
         log::info("Nothing to migrate from V2!");
@@ -222,7 +604,7 @@ Result<> NongManager::migrateV2() {
     size_t i = 0;
 
     for (const auto& [id, compatManifest] : manifest) {
-        if (!m_manifest.m_nongs.contains(id)) {
+        if (!this->hasSongID(id)) {
             LocalSong defaultSong = compatManifest.defaultSong;
             auto nongs = Nongs(id, std::move(defaultSong));
             m_manifest.m_nongs.insert({id, std::make_unique<Nongs>(std::move(nongs))});
@@ -231,7 +613,12 @@ Result<> NongManager::migrateV2() {
             IndexManager::get().registerIndexNongs(n);
         }
 
-        Nongs* nongs = m_manifest.m_nongs[id].get();
+        std::optional<Nongs*> opt = this->getNongs(id);
+        if (!opt) {
+            continue;
+        }
+
+        Nongs* nongs = opt.value();
 
         for (const LocalSong& song : compatManifest.songs) {
             if (song.path().value() == compatManifest.defaultSong.path().value()) {
@@ -268,23 +655,316 @@ Result<> NongManager::migrateV2() {
     return Ok();
 }
 
-Result<> NongManager::saveNongs(std::optional<int> saveID) {
-    const std::filesystem::path path = this->baseManifestPath();
+Result<> NongManager::saveNongs(const int songID, ManifestOp op, const std::string_view uniqueID) {
+    const std::optional<Nongs*> nongs = this->getLoadedNongs(songID);
+    if (!nongs) {
+        return Ok();
+    }
 
-    if (!std::filesystem::exists(path)) {
+    m_dirty.insert(songID);
+
+    // Records only describe what changed, so replay needs a whole song ID to
+    // apply them to first. Ops don't cover the default song either.
+    if (m_journaled.insert(songID).second || uniqueID == nongs.value()->defaultSong()->metadata()->uniqueID) {
+        op = ManifestOp::Full;
+    }
+
+    ManifestWriter::get().journal(ManifestJournal::format(op, songID, describeChange(nongs.value(), op, uniqueID)));
+    m_journalRecords++;
+
+    ManifestWriter::get().schedule([this] { this->collectDirty(); });
+
+    return Ok();
+}
+
+void NongManager::collectDirty() {
+    if (m_dirty.empty()) {
+        return;
+    }
+
+    if (const std::filesystem::path path = this->baseManifestPath(); !std::filesystem::exists(path)) {
         std::filesystem::create_directory(path);
     }
 
-    for (const auto& entry : m_manifest.m_nongs) {
-        auto id = entry.first;
+    ManifestWriter::Batch batch;
+
+    for (const int id : m_dirty) {
+        const std::optional<Nongs*> nongs = this->getLoadedNongs(id);
+        if (!nongs) {
+            continue;
+        }
+
+        batch.insert({nongs.value()->manifestPath(), this->manifestContents(nongs.value())});
+    }
+
+    m_dirty.clear();
+    ManifestWriter::get().enqueue(std::move(batch));
+
+    if (m_journalRecords >= s_journalCompactThreshold) {
+        this->compactJournal();
+    }
+}
+
+void NongManager::flush() {
+    this->collectDirty();
+    this->compactJournal();
+    ManifestWriter::get().flush();
+}
+
+void NongManager::compactJournal() {
+    if (m_journalRecords == 0) {
+        return;
+    }
+
+    // Every journaled change has been collected into queued files by now, so
+    // the writer can empty the journal once those are written
+    ManifestWriter::get().truncateJournal();
+    m_journaled.clear();
+    m_journalRecords = 0;
+}
+
+void NongManager::replayJournal() {
+    const std::filesystem::path path = this->journalPath();
+    auto journal = std::make_unique<ManifestJournal>(path);
+
+    std::vector<ManifestJournal::Record> records;
+    if (std::error_code ec; std::filesystem::exists(path, ec)) {
+        records = ManifestJournal::read(path);
+    }
+
+    // Full records start a song ID over, everything else applies on top
+    std::map<int, matjson::Value> latest;
+    for (const ManifestJournal::Record& record : records) {
+        GEODE_UNWRAP_OR_ELSE(payload, err, matjson::parse(record.payload)) {
+            log::error("Couldn't parse journaled JSON for song ID {}: {}", record.songID, err.message);
+            continue;
+        }
+
+        if (record.op == ManifestOp::Full) {
+            latest.insert_or_assign(record.songID, std::move(payload));
+            continue;
+        }
+
+        const auto it = latest.find(record.songID);
+        if (it == latest.end()) {
+            log::error("Journaled change to song ID {} has nothing to apply to", record.songID);
+            continue;
+        }
+
+        if (GEODE_UNWRAP_IF_ERR(err, applyChange(it->second, record.op, payload))) {
+            log::error("Couldn't replay journaled change to song ID {}: {}", record.songID, err);
+        }
+    }
+
+    bool compacted = true;
+
+    for (const auto& [id, json] : latest) {
+        Result<Nongs> res = matjson::Serialize<Nongs>::fromJson(json, id);
+        if (res.isErr()) {
+            log::error("Failed to parse journaled JSON for song ID {}: {}", id, res.unwrapErr());
+            continue;
+        }
+
+        std::unique_ptr<Nongs> nongs = std::make_unique<Nongs>(std::move(res.unwrap()));
+
+        if (const std::optional<std::string> contents = this->manifestContents(nongs.get()); !contents) {
+            std::error_code ec;
+            std::filesystem::remove(nongs->manifestPath(), ec);
+        } else if (GEODE_UNWRAP_IF_ERR(err, utils::file::writeStringAtomic(nongs->manifestPath(), contents.value()))) {
+            log::error("Failed to write replayed song ID {}: {}", id, err);
+            compacted = false;
+        }
+
+        m_manifest.m_nongs.insert_or_assign(id, std::move(nongs));
+    }
+
+    if (!records.empty()) {
+        log::info("Replayed {} journal records for {} song IDs", records.size(), latest.size());
+    }
+
+    // Keep the journal around if anything failed to land, replaying it again
+    // next time is harmless
+    if (!compacted) {
+        m_journalRecords = records.size();
+    } else if (!records.empty()) {
+        if (GEODE_UNWRAP_IF_ERR(err, journal->truncate())) {
+            log::error("Failed to compact manifest journal: {}", err);
+            m_journalRecords = records.size();
+        }
+    }
+
+    ManifestWriter::get().attachJournal(std::move(journal));
+}
+
+void NongManager::openSnapshot() {
+    m_packedFiles.clear();
+
+    const std::filesystem::path path = this->snapshotPath();
+
+    if (std::error_code ec; !std::filesystem::exists(path, ec)) {
+        return;
+    }
+
+    GEODE_UNWRAP_OR_ELSE(snapshot, err, ManifestSnapshot::open(path)) {
+        log::error("Failed to open manifest snapshot: {}", err);
+        std::error_code ec;
+        std::filesystem::rename(path, fmt::format("{}.bak", string::pathToString(path)), ec);
+        return;
+    }
+
+    m_snapshot = std::move(snapshot);
+    log::info("Mapped manifest snapshot with {} song IDs", m_snapshot->size());
+
+    this->countPackedUnloaded();
+    this->indexPackedFiles();
+}
+
+std::optional<std::string> NongManager::manifestContents(Nongs* nongs) const {
+    if (std::optional<std::string> json = nongs->serialize()) {
+        return json;
+    }
+
+    // A song ID left with only its default song normally has no file, but if
+    // it's packed in the snapshot the file has to stay until the snapshot is
+    // rewritten, or the packed songs would come back next launch
+    if (m_snapshot && m_snapshot->contains(nongs->songID())) {
+        return matjson::Serialize<jukebox::Nongs>::toJson(*nongs).dump(matjson::NO_INDENTATION);
+    }
+
+    return std::nullopt;
+}
+
+void NongManager::countPackedUnloaded() {
+    m_packedUnloaded = 0;
+
+    if (!m_snapshot) {
+        return;
+    }
+
+    for (const int id : m_snapshot->songIDs()) {
+        if (!m_manifest.m_nongs.contains(id)) {
+            m_packedUnloaded++;
+        }
+    }
+}
+
+void NongManager::indexPackedFiles() {
+    m_packedFiles.clear();
+
+    if (!m_snapshot) {
+        return;
+    }
+
+    for (const int id : m_snapshot->songIDs()) {
+        if (m_manifest.m_nongs.contains(id)) {
+            continue;
+        }
+
+        if (const std::optional<std::string_view> raw = m_snapshot->raw(id)) {
+            forEachPathName(raw.value(), [this](std::string name) { m_packedFiles[std::move(name)]++; });
+        }
+    }
+}
+
+void NongManager::unindexPackedFiles(const int songID) {
+    const std::optional<std::string_view> raw = m_snapshot ? m_snapshot->raw(songID) : std::nullopt;
+    if (!raw) {
+        return;
+    }
+
+    forEachPathName(raw.value(), [this](const std::string& name) {
+        if (const auto found = m_packedFiles.find(name); found != m_packedFiles.end() && --found->second == 0) {
+            m_packedFiles.erase(found);
+        }
+    });
+}
+
+Result<> NongManager::saveSnapshot() {
+    if (!Mod::get()->getSettingValue<bool>("packed-manifest")) {
+        return Ok();
+    }
+
+    // Pending per-ID writes would otherwise land after the cleanup below
+    this->flush();
 
-        if (saveID.has_value() && saveID.value() != id) {
+    std::map<int, std::string> entries;
+
+    // Song IDs that were never decoded are copied over as they are
+    if (m_snapshot) {
+        for (const int id : m_snapshot->songIDs()) {
+            if (m_manifest.m_nongs.contains(id)) {
+                continue;
+            }
+
+            if (std::optional<std::string_view> raw = m_snapshot->raw(id)) {
+                entries.insert({id, std::string(raw.value())});
+            }
+        }
+    }
+
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        if (std::optional<std::string> json = nongs->serialize()) {
+            entries.insert({id, std::move(json).value()});
+        }
+    }
+
+    const std::filesystem::path path = this->snapshotPath();
+    const std::filesystem::path tmp = fmt::format("{}.tmp", string::pathToString(path));
+
+    GEODE_UNWRAP(ManifestSnapshot::write(tmp, entries));
+
+    // The old mapping has to go before the file can be replaced
+    m_snapshot.reset();
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        return Err("Couldn't replace manifest snapshot: {}", ec.message());
+    }
+
+    this->openSnapshot();
+
+    // Everything lives in the snapshot now, so the per-ID files are redundant
+    for (const std::filesystem::directory_entry& entry :
+         std::filesystem::directory_iterator(this->baseManifestPath(), ec)) {
+        if (entry.path().extension() != ".json") {
             continue;
         }
 
-        GEODE_UNWRAP(entry.second->commit());
+        // Song IDs that are loaded but not packed had nothing worth storing
+        Result<int> id = geode::utils::numFromString<int>(string::pathToString(entry.path().stem()));
+        if (id.isOk() && (entries.contains(id.unwrap()) || m_manifest.m_nongs.contains(id.unwrap()))) {
+            std::filesystem::remove(entry.path(), ec);
+        }
     }
 
+    log::info("Packed {} song IDs into the manifest snapshot", entries.size());
+
+    return Ok();
+}
+
+Result<> NongManager::exportSnapshot() {
+    if (!m_snapshot) {
+        return Ok();
+    }
+
+    for (const int id : m_snapshot->songIDs()) {
+        std::optional<Nongs*> nongs = this->getNongs(id);
+        if (!nongs) {
+            continue;
+        }
+
+        GEODE_UNWRAP(nongs.value()->commit());
+    }
+
+    m_snapshot.reset();
+    m_brokenSnapshotIDs.clear();
+    m_packedUnloaded = 0;
+    m_packedFiles.clear();
+
+    std::error_code ec;
+    std::filesystem::remove(this->snapshotPath(), ec);
+
     return Ok();
 }
 
@@ -307,69 +987,89 @@ Result<std::unique_ptr<Nongs>> NongManager::loadNongsFromPath(const std::filesys
 }
 
 bool NongManager::isNongVerifiedForLevelSong(const int levelID, int songID, const std::string_view uniqueID) {
-    // List the verified nongs for the given level and song
-    std::vector<std::string> verifiedNongs = NongManager::get().getVerifiedNongsForLevel(levelID, {songID});
-    return std::ranges::find(verifiedNongs, uniqueID) != verifiedNongs.end();
+    return std::ranges::any_of(IndexManager::get().verifiedForLevel(levelID),
+                               [songID, uniqueID](const IndexManager::VerifiedSong& verified) {
+                                   return verified.m_songID == songID && verified.m_song->uniqueID == uniqueID;
+                               });
+}
+
+bool NongManager::isNongVerified(const int levelID, std::vector<int> songIDs) {
+    return std::ranges::any_of(IndexManager::get().verifiedForLevel(levelID),
+                               [&songIDs](const IndexManager::VerifiedSong& verified) {
+                                   return std::ranges::find(songIDs, verified.m_songID) != songIDs.end();
+                               });
 }
 
 std::string NongManager::getFormattedSize(const std::filesystem::path& path) {
-    std::error_code code;
-    const auto size = std::filesystem::file_size(path, code);
-    if (code) {
+    const PathStatus status = m_pathCache.status(path);
+    if (!status.m_exists) {
         return "N/A";
     }
-    double toMegabytes = static_cast<double>(size) / 1024.f / 1024.f;
+    double toMegabytes = static_cast<double>(status.m_size) / 1024.f / 1024.f;
     return fmt::format("{:.2f}MB", toMegabytes);
 }
 
 arc::Future<std::string> NongManager::getMultiAssetSizes(std::string songs, std::string sfx,
                                                          const std::filesystem::path resourcesDir,
                                                          const std::filesystem::path songDir) {
-    uintmax_t sum = 0.f;
-    std::error_code _ec;
+    struct ResolvedSongs {
+        // Sizes GD already knows, for songs that aren't replaced
+        uintmax_t m_known = 0;
+        std::vector<std::filesystem::path> m_files;
+    };
+
+    // The manifest and song info objects may only be used on the main thread
+    const std::optional<ResolvedSongs> resolved =
+        co_await async::waitForMainThread<ResolvedSongs>([this, songs = std::move(songs), resourcesDir]() {
+            ResolvedSongs ret;
+
+            for (auto s : asp::iter::split(std::string_view(songs), ',')) {
+                Result<int> idRes = geode::utils::numFromString<int>(s);
+                if (idRes.isErr()) {
+                    continue;
+                }
+                int id = idRes.unwrap();
+                auto result = this->getNongs(id);
+                if (!result.has_value()) {
+                    continue;
+                }
+                auto nongs = result.value();
+                if (nongs->isDefaultActive()) {
+                    SongInfoObject* songObj = MusicDownloadManager::sharedState()->getSongInfoObject(id);
+                    if (songObj && songObj->m_fileSize > 0.f) {
+                        double filesizeMB = songObj->m_fileSize;
+                        ret.m_known += static_cast<uintmax_t>(filesizeMB * 1000000.f);
+                        continue;
+                    }
+                }
 
-    for (auto s : asp::iter::split(std::string_view(songs), ',')) {
-        Result<int> idRes = geode::utils::numFromString<int>(s);
-        if (idRes.isErr()) {
-            continue;
-        }
-        int id = idRes.unwrap();
-        auto result = this->getNongs(id);
-        if (!result.has_value()) {
-            continue;
-        }
-        auto nongs = result.value();
-        if (nongs->isDefaultActive()) {
-            auto songObj = co_await async::waitForMainThread<SongInfoObject*>(
-                [id]() { return MusicDownloadManager::sharedState()->getSongInfoObject(id); });
-            if (songObj && songObj.value() && songObj.value()->m_fileSize > 0.f) {
-                double filesizeMB = songObj.value()->m_fileSize;
-                sum += static_cast<uintmax_t>(filesizeMB * 1000000.f);
-                continue;
+                auto path = nongs->active()->path().value();
+                if (string::pathToString(path).starts_with("songs/")) {
+                    path = resourcesDir / path;
+                }
+                ret.m_files.push_back(std::move(path));
             }
-        }
 
-        auto path = nongs->active()->path().value();
-        if (string::pathToString(path).starts_with("songs/")) {
-            path = resourcesDir / path;
-        }
-        if (std::filesystem::exists(path, _ec)) {
-            sum += std::filesystem::file_size(path, _ec);
+            return ret;
+        });
+
+    uintmax_t sum = 0;
+
+    if (resolved) {
+        sum += resolved->m_known;
+        for (const std::filesystem::path& path : resolved->m_files) {
+            sum += m_assetSizes.size(path).value_or(0);
         }
     }
 
     for (auto s : asp::iter::split(std::string_view(sfx), ',')) {
         std::string filename = fmt::format("s{}.ogg", s);
-        auto localPath = resourcesDir / "sfx" / filename;
 
-        if (std::filesystem::exists(localPath, _ec)) {
-            sum += std::filesystem::file_size(localPath, _ec);
+        if (const std::optional<uintmax_t> size = m_assetSizes.size(resourcesDir / "sfx" / filename)) {
+            sum += size.value();
             continue;
         }
-        auto path = songDir / filename;
-        if (std::filesystem::exists(path, _ec)) {
-            sum += std::filesystem::file_size(path, _ec);
-        }
+        sum += m_assetSizes.size(songDir / filename).value_or(0);
     }
 
     double toMegabytes = static_cast<double>(sum) / 1000000.f;
@@ -401,7 +1101,7 @@ Result<> NongManager::setActiveSong(int gdSongID, std::string uniqueID) {
     if (auto err = nongs.value()->setActive(uniqueID); err.isErr()) {
         return err;
     }
-    return saveNongs(gdSongID);
+    return saveNongs(gdSongID, ManifestOp::SetActive);
 }
 
 Result<> NongManager::deleteSong(int gdSongID, std::string uniqueID) {
@@ -413,7 +1113,7 @@ Result<> NongManager::deleteSong(int gdSongID, std::string uniqueID) {
     GEODE_UNWRAP(nongs.value()->deleteSong(uniqueID).mapErr(
         [](std::string err) { return fmt::format("Couldn't delete Nong: {}", err); }));
 
-    return nongs.value()->commit();
+    return this->saveNongs(gdSongID, ManifestOp::Delete, uniqueID);
 }
 
 Result<> NongManager::deleteSongAudio(int gdSongID, std::string uniqueID) {
@@ -425,7 +1125,7 @@ Result<> NongManager::deleteSongAudio(int gdSongID, std::string uniqueID) {
     GEODE_UNWRAP(nongs.value()->deleteSongAudio(uniqueID).mapErr(
         [](std::string err) { return fmt::format("Couldn't delete Nong: {}", err); }));
 
-    return saveNongs(gdSongID);
+    return saveNongs(gdSongID, ManifestOp::Update, uniqueID);
 }
 
 Result<> NongManager::deleteAllSongs(int gdSongID) {
@@ -436,7 +1136,53 @@ Result<> NongManager::deleteAllSongs(int gdSongID) {
     if (auto err = m_manifest.m_nongs.at(gdSongID)->deleteAllSongs(); err.isErr()) {
         return err;
     }
-    return this->saveNongs(gdSongID);
+    return this->saveNongs(gdSongID, ManifestOp::DeleteAll);
+}
+
+bool NongManager::isInSnapshot(const std::filesystem::path& file) const {
+    return m_packedFiles.contains(string::pathToString(file.filename()));
+}
+
+std::unordered_set<std::string> NongManager::packedFileNames() const {
+    std::unordered_set<std::string> ret;
+    ret.reserve(m_packedFiles.size());
+    for (const auto& [name, count] : m_packedFiles) {
+        ret.insert(name);
+    }
+    return ret;
+}
+
+bool NongManager::isAudioReferenced(const std::filesystem::path& path) const {
+    const auto uses = [&path](const Song* song) { return song->path() == path; };
+
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        if (std::ranges::any_of(nongs->locals(), [&uses](const auto& song) { return uses(song.get()); }) ||
+            std::ranges::any_of(nongs->youtube(), [&uses](const auto& song) { return uses(song.get()); }) ||
+            std::ranges::any_of(nongs->hosted(), [&uses](const auto& song) { return uses(song.get()); })) {
+            return true;
+        }
+    }
+
+    return this->isInSnapshot(path);
+}
+
+void NongManager::releaseAudio(const std::filesystem::path& path) {
+    if (blobs::isBlob(path) && this->isAudioReferenced(path)) {
+        return;
+    }
+
+    if (!m_pathCache.exists(path)) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    m_pathCache.invalidate(path);
+    m_assetSizes.invalidate(path);
+    if (ec) {
+        log::error("Couldn't delete nong. Category: {}, message: {}", ec.category().name(),
+                   ec.category().message(ec.value()));
+    }
 }
 
 std::filesystem::path NongManager::generateSongFilePath(const std::string& extension,
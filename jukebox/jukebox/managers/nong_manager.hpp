@@ -3,14 +3,22 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <Geode/Result.hpp>
 #include <Geode/loader/Mod.hpp>
 #include <Geode/utils/Task.hpp>
 
+#include <jukebox/nong/manifest_journal.hpp>
+#include <jukebox/nong/manifest_snapshot.hpp>
 #include <jukebox/nong/nong.hpp>
+#include <jukebox/utils/asset_size_cache.hpp>
+#include <jukebox/utils/path_cache.hpp>
 
 namespace jukebox {
 
@@ -18,6 +26,24 @@ class NongManager {
 protected:
     Manifest m_manifest;
     bool m_initialized = false;
+    bool m_decodingSnapshot = false;
+
+    std::unique_ptr<ManifestSnapshot> m_snapshot;
+    std::unordered_set<int> m_brokenSnapshotIDs;
+    // Song IDs in the snapshot that haven't been loaded yet
+    size_t m_packedUnloaded = 0;
+    // Audio file name -> how many of those song IDs use it
+    std::unordered_map<std::string, size_t> m_packedFiles;
+    // Song IDs changed since the last time the manifest writer collected them
+    std::unordered_set<int> m_dirty;
+    // Song IDs with a Full record in the journal since it was last emptied
+    std::unordered_set<int> m_journaled;
+    size_t m_journalRecords = 0;
+    PathCache m_pathCache;
+    AssetSizeCache m_assetSizes;
+
+    // Records the journal may hold before it gets compacted into per-ID files
+    static constexpr size_t s_journalCompactThreshold = 256;
 
     NongManager() = default;
 
@@ -31,10 +57,27 @@ protected:
         }
     }
 
-    geode::Result<> saveNongs(std::optional<int> saveId = std::nullopt);
     geode::Result<std::unique_ptr<Nongs>> loadNongsFromPath(const std::filesystem::path& path);
+    std::optional<Nongs*> decodeFromSnapshot(int songID);
+    void openSnapshot();
+    std::optional<std::string> manifestContents(Nongs* nongs) const;
+    void countPackedUnloaded();
+    void indexPackedFiles();
+    /**
+     * Forgets the files of a packed song ID, once it's loaded and they can be
+     * found through the manifest instead
+     */
+    void unindexPackedFiles(int songID);
+    void collectDirty();
+    void replayJournal();
+    void compactJournal();
 
     geode::Result<> migrateV2();
+    /**
+     * Moves audio stored before blobs existed into the blob store. Files are
+     * hashed in the background, songs are pointed to their blob once done.
+     */
+    void migrateToBlobs();
 
 public:
     NongManager(const NongManager&) = delete;
@@ -50,16 +93,45 @@ public:
 
     bool initialized() const { return m_initialized; }
 
+    /**
+     * Whether Nongs should broadcast state changes. This is false while the
+     * manifest is being read, or while a song ID is decoded from the snapshot
+     */
+    bool shouldSendEvents() const { return m_initialized && !m_decodingSnapshot; }
+
     std::filesystem::path baseManifestPath() {
         static std::filesystem::path path = geode::Mod::get()->getSaveDir() / "manifest";
         return path;
     }
 
+    std::filesystem::path journalPath() {
+        static std::filesystem::path path = geode::Mod::get()->getSaveDir() / "manifest.journal";
+        return path;
+    }
+
+    std::filesystem::path snapshotPath() {
+        static std::filesystem::path path = geode::Mod::get()->getSaveDir() / "manifest.bin";
+        return path;
+    }
+
     std::filesystem::path baseNongsPath() {
         static std::filesystem::path path = geode::Mod::get()->getSaveDir() / "nongs";
         return path;
     }
 
+    /**
+     * Status of song files, cached so lists and hooks can check whether songs
+     * are downloaded without touching the disk. Invalidate paths after
+     * writing or deleting them.
+     */
+    [[nodiscard]] const PathCache& pathCache() const { return m_pathCache; }
+
+    /**
+     * Sizes of song and SFX files, used by getMultiAssetSizes. Saved along
+     * with the mod's data.
+     */
+    AssetSizeCache& assetSizes() { return m_assetSizes; }
+
     [[nodiscard]] bool hasSongID(int id) const;
 
     geode::Result<Nongs*> initSongID(SongInfoObject* obj, int id, bool robtop);
@@ -92,6 +164,50 @@ public:
      */
     std::optional<Nongs*> getNongs(int songID);
 
+    /**
+     * Same as getNongs, but never decodes song IDs that are still packed in
+     * the manifest snapshot
+     *
+     * @param songID the id of the song
+     * @return the data, or nullopt if it wasn't created or decoded yet
+     */
+    std::optional<Nongs*> getLoadedNongs(int songID);
+
+    /**
+     * Gets every song ID that is currently loaded, see getLoadedNongs
+     */
+    [[nodiscard]] std::vector<int> getLoadedSongIDs() const;
+
+    /**
+     * Records a change to a song ID in the journal, and marks it as changed.
+     * Its file gets written in the background shortly after, so repeated
+     * saves of the same ID end up as a single write.
+     *
+     * @param songID the song ID to save
+     * @param op what kind of change was made. Full stores the whole song ID,
+     * prefer the narrowest op that describes the change.
+     * @param uniqueID the song that was added, updated or deleted
+     */
+    geode::Result<> saveNongs(int songID, ManifestOp op = ManifestOp::Full, std::string_view uniqueID = {});
+
+    /**
+     * Writes every pending change to disk, blocks until that is done, then
+     * empties the journal. Only meant for when the game saves.
+     */
+    void flush();
+
+    /**
+     * Packs the whole manifest into the snapshot file, if the packed manifest
+     * is enabled. Per-ID files that made it into the snapshot are removed.
+     */
+    geode::Result<> saveSnapshot();
+
+    /**
+     * Unpacks every song ID stored in the snapshot back into per-ID files, and
+     * removes the snapshot
+     */
+    geode::Result<> exportSnapshot();
+
     /**
      * Returns all the uniqueIDs of nongs that are verified for the given level
      * ID
@@ -99,9 +215,9 @@ public:
      * @param levelID the id of the level
      * @param songIDs list of all the song ids to check their nongs
      * @return List of all uniqueIDs of nongs that are verified for the given
-     * level ID
+     * level ID. They point into the indexes the songs come from.
      */
-    std::vector<std::string> getVerifiedNongsForLevel(int levelID, std::vector<int> songIDs);
+    std::vector<std::string_view> getVerifiedNongsForLevel(int levelID, std::vector<int> songIDs);
 
     /**
      * Returns whether the nong is verified for the a song in a level
@@ -134,8 +250,8 @@ public:
 
     /**
      * Calculates the total size of multiple assets, then writes it to a string.
-     * Runs on a separate thread. Returns a task that will resolve to the total
-     * size.
+     * Songs are resolved on the main thread in one go, file sizes are looked up
+     * on a separate thread. Returns a task that will resolve to the total size.
      *
      * @param songs string of song ids, separated by commas
      * @param sfx string of sfx ids, separated by commas
@@ -185,6 +301,29 @@ public:
      */
     geode::Result<> deleteAllSongs(int gdSongID);
 
+    /**
+     * Whether a song ID that is still packed in the snapshot mentions the file
+     */
+    [[nodiscard]] bool isInSnapshot(const std::filesystem::path& file) const;
+
+    /**
+     * Copies the names of the audio files used by song IDs still packed in
+     * the snapshot, so they can be looked up off the main thread
+     */
+    [[nodiscard]] std::unordered_set<std::string> packedFileNames() const;
+
+    /**
+     * Whether any song in the manifest uses an audio file, including song IDs
+     * still packed in the snapshot
+     */
+    [[nodiscard]] bool isAudioReferenced(const std::filesystem::path& path) const;
+
+    /**
+     * Deletes an audio file no longer used by the song that had it. Blobs are
+     * only deleted once no other song uses them, other files right away.
+     */
+    void releaseAudio(const std::filesystem::path& path);
+
     /**
      * Get a path to a song file
      */
@@ -0,0 +1,156 @@
+#include <jukebox/managers/prefetch_manager.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <Geode/binding/GJGameLevel.hpp>
+#include <Geode/loader/Event.hpp>
+#include <Geode/loader/Log.hpp>
+#include <Geode/loader/Mod.hpp>
+#include <Geode/utils/general.hpp>
+#include <asp/iter.hpp>
+
+#include <jukebox/events/song_download_failed.hpp>
+#include <jukebox/events/song_download_finished.hpp>
+#include <jukebox/managers/download_manager.hpp>
+#include <jukebox/managers/index_manager.hpp>
+#include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/managers/storage_manager.hpp>
+#include <jukebox/nong/nong.hpp>
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+bool PrefetchManager::init() {
+    if (m_initialized) {
+        return true;
+    }
+
+    event::SongDownloadFinished()
+        .listen([this](const event::SongDownloadFinishedData& event) {
+            const SongMetadata* metadata = event.destination()->metadata();
+            // The user may have asked for the song meanwhile, then it isn't
+            // a prefetch anymore
+            if (!this->forgetQueued(metadata->gdID, metadata->uniqueID) || !event.background()) {
+                return ListenerResult::Propagate;
+            }
+
+            if (const std::optional<std::filesystem::path> path = event.destination()->path()) {
+                std::error_code ec;
+                const uintmax_t size = std::filesystem::file_size(path.value(), ec);
+                if (!ec) {
+                    m_downloadedBytes += size;
+                }
+            }
+
+            return ListenerResult::Propagate;
+        })
+        .leak();
+
+    event::SongDownloadFailed()
+        .listen([this](const event::SongDownloadFailedData& event) {
+            this->forgetQueued(event.gdId(), event.uniqueId());
+            return ListenerResult::Propagate;
+        })
+        .leak();
+
+    m_initialized = true;
+    return true;
+}
+
+bool PrefetchManager::withinBudget() const {
+    constexpr uintmax_t MEGABYTE = 1024 * 1024;
+
+    // Counts the song about to be queued too
+    const uintmax_t queued = (m_queued.size() + 1) * s_estimatedSongBytes;
+
+    const int64_t limitMB = Mod::get()->getSettingValue<int64_t>("prefetch-limit");
+    if (limitMB > 0 && m_downloadedBytes + queued > static_cast<uintmax_t>(limitMB) * MEGABYTE) {
+        return false;
+    }
+
+    // Keep some room, or prefetched songs would push out the ones the user
+    // actually played
+    const int64_t budgetMB = Mod::get()->getSettingValue<int64_t>("storage-budget");
+    if (budgetMB > 0 &&
+        StorageManager::get().storedBytes() + queued > static_cast<uintmax_t>(budgetMB) * MEGABYTE / 10 * 9) {
+        return false;
+    }
+
+    return true;
+}
+
+bool PrefetchManager::forgetQueued(const int songID, const std::string_view uniqueID) {
+    const auto found = std::ranges::find_if(m_queued, [songID, uniqueID](const std::pair<int, std::string>& queued) {
+        return queued.first == songID && queued.second == uniqueID;
+    });
+    if (found == m_queued.end()) {
+        return false;
+    }
+
+    m_queued.erase(found);
+    return true;
+}
+
+void PrefetchManager::prefetchForLevel(GJGameLevel* level) {
+    if (level == nullptr || !Mod::get()->getSettingValue<bool>("prefetch-verified")) {
+        return;
+    }
+
+    const int levelID = level->m_levelID.value();
+
+    std::vector<int> songIDs;
+    songIDs.push_back(level->m_songID != 0 ? level->m_songID : (-level->m_audioTrack) - 1);
+
+    const std::string extraSongs = level->m_songIDs;
+    for (auto s : asp::iter::split(std::string_view(extraSongs), ',')) {
+        Result<int> id = geode::utils::numFromString<int>(s);
+        if (id.isOk() && id.unwrap() != songIDs.front()) {
+            songIDs.push_back(id.unwrap());
+        }
+    }
+
+    for (const int songID : songIDs) {
+        const std::vector<std::string_view> verified =
+            NongManager::get().getVerifiedNongsForLevel(levelID, {songID});
+        if (verified.empty()) {
+            continue;
+        }
+
+        const std::string uniqueID(verified.front());
+
+        // Songs already in the list were downloaded before, and may have been
+        // deleted on purpose since. Song IDs without an entry get one when the
+        // download is queued, except RobTop songs, which need their level's
+        // song object for it.
+        const std::optional<Nongs*> nongs = NongManager::get().getNongs(songID);
+        if (nongs.has_value() ? nongs.value()->findSong(uniqueID).has_value() : songID < 0) {
+            continue;
+        }
+        if (DownloadManager::get().isDownloading(songID, uniqueID)) {
+            continue;
+        }
+
+        if (!this->withinBudget()) {
+            return;
+        }
+
+        Result<> res = IndexManager::get().downloadSong(songID, uniqueID, DownloadPriority::BACKGROUND);
+        if (res.isErr()) {
+            log::debug("Not prefetching {} for song ID {}: {}", uniqueID, songID, res.unwrapErr());
+            continue;
+        }
+
+        m_queued.emplace_back(songID, uniqueID);
+    }
+}
+
+}  // namespace jukebox
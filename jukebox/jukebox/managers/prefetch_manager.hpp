@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Geode/binding/GJGameLevel.hpp>
+
+namespace jukebox {
+
+/**
+ * Downloads verified nongs of levels the user comes across in the background,
+ * so they are already on disk when the level gets played. Prefetched songs are
+ * only added to the song's list, they never become active on their own.
+ *
+ * Opt-in through the prefetch-verified setting. Prefetching stops once it
+ * downloaded prefetch-limit MB this session, or once stored audio gets close
+ * to the storage budget.
+ */
+class PrefetchManager {
+protected:
+    bool m_initialized = false;
+
+    // Sizes aren't known until a download starts, so every queued prefetch
+    // counts as this much until it finishes
+    static constexpr uintmax_t s_estimatedSongBytes = 8 * 1024 * 1024;
+
+    // Downloaded by prefetching this session
+    uintmax_t m_downloadedBytes = 0;
+    // Song ID and unique ID of queued prefetches
+    std::vector<std::pair<int, std::string>> m_queued;
+
+    PrefetchManager() = default;
+
+    /**
+     * Whether another song can be prefetched, counting queued ones at
+     * s_estimatedSongBytes
+     */
+    [[nodiscard]] bool withinBudget() const;
+    /**
+     * @return whether the song was a queued prefetch
+     */
+    bool forgetQueued(int songID, std::string_view uniqueID);
+
+public:
+    PrefetchManager(const PrefetchManager&) = delete;
+    PrefetchManager(PrefetchManager&&) = delete;
+
+    PrefetchManager& operator=(const PrefetchManager&) = delete;
+    PrefetchManager& operator=(PrefetchManager&&) = delete;
+
+    bool init();
+
+    /**
+     * Queues a background download of the first verified nong of every song
+     * in the level that doesn't have it downloaded yet
+     */
+    void prefetchForLevel(GJGameLevel* level);
+
+    static PrefetchManager& get() {
+        static PrefetchManager instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
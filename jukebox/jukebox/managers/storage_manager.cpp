@@ -0,0 +1,432 @@
+#include <jukebox/managers/storage_manager.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <Geode/loader/Event.hpp>
+#include <Geode/loader/Log.hpp>
+#include <Geode/loader/Mod.hpp>
+#include <Geode/utils/general.hpp>
+#include <Geode/utils/string.hpp>
+#include <arc/future/Future.hpp>
+#include <matjson.hpp>
+
+#include <jukebox/events/song_download_finished.hpp>
+#include <jukebox/managers/download_manager.hpp>
+#include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/nong/blob_store.hpp>
+#include <jukebox/nong/nong.hpp>
+#include <jukebox/utils/parallel.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Audio that could be deleted to make space, along with every downloaded
+// song using it
+struct Candidate {
+    std::filesystem::path m_path;
+    uintmax_t m_size;
+    int64_t m_lastUsed;
+    std::filesystem::file_time_type m_written;
+    std::vector<std::pair<int, std::string>> m_songs {};
+};
+
+std::string keyFor(const std::filesystem::path& path) { return string::pathToString(path.filename()); }
+
+// Leftovers from writes and downloads younger than this are left alone, they
+// may still be in use or get resumed
+constexpr auto STALE_AFTER = std::chrono::hours(24 * 7);
+
+// What the main thread knows about, copied for the scan
+struct GarbageScan {
+    std::vector<std::filesystem::path> m_audioDirs;
+    std::filesystem::path m_manifestDir;
+    std::unordered_set<std::string> m_referenced;
+    // File names used by song IDs still packed in the snapshot
+    std::unordered_set<std::string> m_packed;
+};
+
+struct GarbageFile {
+    std::filesystem::path m_path;
+    uintmax_t m_size;
+    // Audio is checked against the manifest again once the scan is done
+    bool m_audio;
+};
+
+bool isTemporary(const std::string_view name) {
+    return name.ends_with(".tmp") || name.ends_with(".part") || name.ends_with(".part.json") ||
+           name.ends_with(".download");
+}
+
+std::vector<GarbageFile> scanDirectory(const GarbageScan& scan, const std::filesystem::path& dir) {
+    std::vector<GarbageFile> ret;
+    const bool isManifest = dir == scan.m_manifestDir;
+    const auto now = std::filesystem::file_time_type::clock::now();
+
+    std::error_code ec;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+
+        const std::filesystem::path& path = entry.path();
+        const std::string name = string::pathToString(path.filename());
+        bool audio = false;
+
+        if (isTemporary(name)) {
+            const auto written = entry.last_write_time(ec);
+            if (ec || now - written < STALE_AFTER) {
+                continue;
+            }
+        } else if (isManifest) {
+            if (path.extension() != ".bak") {
+                continue;
+            }
+        } else {
+            if (scan.m_referenced.contains(string::pathToString(path)) || scan.m_packed.contains(name)) {
+                continue;
+            }
+            audio = true;
+        }
+
+        const uintmax_t size = entry.file_size(ec);
+        ret.push_back(GarbageFile{path, ec ? 0 : size, audio});
+    }
+
+    return ret;
+}
+
+arc::Future<std::vector<GarbageFile>> findGarbage(GarbageScan scan) {
+    std::vector<std::filesystem::path> dirs = scan.m_audioDirs;
+    dirs.push_back(scan.m_manifestDir);
+
+    std::vector<std::vector<GarbageFile>> found(dirs.size());
+    jukebox::parallelFor(dirs.size(),
+                         [&scan, &dirs, &found](const size_t i) { found[i] = scanDirectory(scan, dirs[i]); });
+
+    std::vector<GarbageFile> ret;
+    for (std::vector<GarbageFile>& files : found) {
+        std::ranges::move(files, std::back_inserter(ret));
+    }
+    co_return ret;
+}
+
+// Every stored audio file, by path, as in StorageManager::StoredFiles
+struct StoredAudio {
+    uintmax_t m_total = 0;
+    std::unordered_map<std::string, std::pair<uintmax_t, std::filesystem::file_time_type>> m_files;
+};
+
+arc::Future<StoredAudio> scanStoredAudio(std::vector<std::filesystem::path> dirs) {
+    StoredAudio ret;
+
+    for (const std::filesystem::path& dir : dirs) {
+        std::error_code ec;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, ec)) {
+            if (!entry.is_regular_file(ec)) {
+                continue;
+            }
+
+            const uintmax_t size = entry.file_size(ec);
+            if (ec) {
+                continue;
+            }
+
+            ret.m_total += size;
+            ret.m_files.emplace(string::pathToString(entry.path()), std::pair{size, entry.last_write_time(ec)});
+        }
+    }
+
+    co_return ret;
+}
+
+}  // namespace
+
+namespace jukebox {
+
+bool StorageManager::init() {
+    if (m_initialized) {
+        return true;
+    }
+
+    const auto saved = Mod::get()->getSavedValue<matjson::Value>("last-used", matjson::Value::object());
+    for (const auto& [file, time] : saved) {
+        if (const std::optional<std::intmax_t> value = time.asInt().ok()) {
+            m_lastUsed[file] = static_cast<int64_t>(value.value());
+        }
+    }
+
+    event::SongDownloadFinished()
+        .listen([this](const event::SongDownloadFinishedData& event) {
+            // Prefetched songs count as played once they actually are, until
+            // then they go before anything the user played
+            if (const std::optional<std::filesystem::path> path = event.destination()->path();
+                path.has_value() && !event.background()) {
+                this->touch(path.value());
+            }
+
+            // Once every listener is done, so the new song already is active
+            geode::queueInMainThread([this] { this->enforceBudget(); });
+
+            return ListenerResult::Propagate;
+        })
+        .leak();
+
+    this->enforceBudget();
+    this->collectGarbage(!Mod::get()->getSettingValue<bool>("clean-unused-files"));
+
+    m_initialized = true;
+    return true;
+}
+
+void StorageManager::touch(const std::filesystem::path& path) {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    m_lastUsed[keyFor(path)] = std::chrono::duration_cast<std::chrono::seconds>(now).count();
+}
+
+void StorageManager::save() const {
+    matjson::Value json = matjson::Value::object();
+    for (const auto& [file, time] : m_lastUsed) {
+        json.set(file, time);
+    }
+    Mod::get()->setSavedValue("last-used", json);
+}
+
+void StorageManager::enforceBudget() {
+    if (Mod::get()->getSettingValue<int64_t>("storage-budget") <= 0) {
+        return;
+    }
+
+    // One scan at a time, downloads finishing meanwhile get another one after
+    if (m_scanning) {
+        m_scanAgain = true;
+        return;
+    }
+    m_scanning = true;
+
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    const int64_t started = std::chrono::duration_cast<std::chrono::seconds>(now).count();
+
+    NongManager& nongManager = NongManager::get();
+    std::vector<std::filesystem::path> dirs = {blobs::basePath(), nongManager.baseNongsPath()};
+    async::spawn(scanStoredAudio(std::move(dirs)), [this, started](StoredAudio stored) {
+        m_scanning = false;
+        (void)this->evictOverBudget(stored.m_total, stored.m_files, started);
+
+        if (std::exchange(m_scanAgain, false)) {
+            this->enforceBudget();
+        }
+    });
+}
+
+uintmax_t StorageManager::evictOverBudget(uintmax_t total, const StoredFiles& stored, const int64_t scannedAt) {
+    // The setting may have changed during the scan
+    const int64_t budgetMB = Mod::get()->getSettingValue<int64_t>("storage-budget");
+    if (budgetMB <= 0) {
+        return 0;
+    }
+    const auto budget = static_cast<uintmax_t>(budgetMB) * 1024 * 1024;
+
+    NongManager& nongManager = NongManager::get();
+
+    // Forget files that are gone. Files played since the scan started may be
+    // new ones it didn't see.
+    std::erase_if(m_lastUsed, [&stored, &nongManager, scannedAt](const auto& pair) {
+        return pair.second < scannedAt && !stored.contains(string::pathToString(blobs::basePath() / pair.first)) &&
+               !stored.contains(string::pathToString(nongManager.baseNongsPath() / pair.first));
+    });
+
+    m_storedBytes = total;
+
+    if (total <= budget) {
+        return 0;
+    }
+
+    std::unordered_map<std::string, Candidate> candidates;
+    std::unordered_set<std::string> pinned;
+
+    const auto addCandidate = [&](const int songID, const Song* song) {
+        const std::optional<std::filesystem::path> path = song->path();
+        if (!path.has_value()) {
+            return;
+        }
+
+        const std::string key = string::pathToString(path.value());
+        const auto it = stored.find(key);
+        if (it == stored.end()) {
+            return;
+        }
+
+        auto [candidate, inserted] = candidates.try_emplace(key, Candidate{
+                                                                     .m_path = path.value(),
+                                                                     .m_size = it->second.first,
+                                                                     .m_lastUsed = 0,
+                                                                     .m_written = it->second.second,
+                                                                 });
+        if (inserted) {
+            if (const auto used = m_lastUsed.find(keyFor(path.value())); used != m_lastUsed.end()) {
+                candidate->second.m_lastUsed = used->second;
+            }
+        }
+        candidate->second.m_songs.emplace_back(songID, song->metadata()->uniqueID);
+    };
+
+    for (const int id : nongManager.getLoadedSongIDs()) {
+        const Nongs* nongs = nongManager.getLoadedNongs(id).value();
+
+        if (const std::optional<std::filesystem::path> path = nongs->active()->path()) {
+            pinned.insert(string::pathToString(path.value()));
+        }
+        for (const std::unique_ptr<LocalSong>& song : nongs->locals()) {
+            if (const std::optional<std::filesystem::path> path = song->path()) {
+                pinned.insert(string::pathToString(path.value()));
+            }
+        }
+
+        for (const std::unique_ptr<YTSong>& song : nongs->youtube()) {
+            addCandidate(id, song.get());
+        }
+        for (const std::unique_ptr<HostedSong>& song : nongs->hosted()) {
+            addCandidate(id, song.get());
+        }
+    }
+
+    std::vector<Candidate> order;
+    order.reserve(candidates.size());
+    for (auto& [key, candidate] : candidates) {
+        // Song IDs still packed in the snapshot may be using it, maybe as
+        // their active song
+        if (pinned.contains(key) || nongManager.isInSnapshot(candidate.m_path)) {
+            continue;
+        }
+        order.push_back(std::move(candidate));
+    }
+
+    // Files never played since they were tracked go first, oldest first
+    std::ranges::sort(order, [](const Candidate& a, const Candidate& b) {
+        if (a.m_lastUsed != b.m_lastUsed) {
+            return a.m_lastUsed < b.m_lastUsed;
+        }
+        return a.m_written < b.m_written;
+    });
+
+    uintmax_t freed = 0;
+    size_t evicted = 0;
+
+    for (const Candidate& candidate : order) {
+        if (total <= budget) {
+            break;
+        }
+
+        for (const auto& [songID, uniqueID] : candidate.m_songs) {
+            if (GEODE_UNWRAP_IF_ERR(err, nongManager.deleteSongAudio(songID, uniqueID))) {
+                log::warn("Couldn't evict song {} of song ID {}: {}", uniqueID, songID, err);
+            } else {
+                evicted++;
+            }
+        }
+
+        if (!nongManager.pathCache().exists(candidate.m_path)) {
+            total -= candidate.m_size;
+            freed += candidate.m_size;
+            m_lastUsed.erase(keyFor(candidate.m_path));
+        }
+    }
+
+    m_storedBytes = total;
+
+    if (evicted > 0) {
+        log::info("Deleted the audio of {} songs to stay within the storage budget, freed {:.2f}MB", evicted,
+                  static_cast<double>(freed) / 1024 / 1024);
+    }
+
+    if (total > budget) {
+        log::warn("Stored audio still takes {:.2f}MB, over the budget of {}MB",
+                  static_cast<double>(total) / 1024 / 1024, budgetMB);
+    }
+
+    return freed;
+}
+
+void StorageManager::collectGarbage(const bool dryRun, std::function<void(const GarbageReport&)> callback) {
+    NongManager& nongManager = NongManager::get();
+
+    GarbageScan scan{
+        .m_audioDirs = {blobs::basePath(), nongManager.baseNongsPath()},
+        .m_manifestDir = nongManager.baseManifestPath(),
+        .m_packed = nongManager.packedFileNames(),
+    };
+
+    const auto reference = [&scan](const Song* song) {
+        if (const std::optional<std::filesystem::path> path = song->path()) {
+            scan.m_referenced.insert(string::pathToString(path.value()));
+        }
+    };
+
+    for (const int id : nongManager.getLoadedSongIDs()) {
+        const Nongs* nongs = nongManager.getLoadedNongs(id).value();
+        reference(nongs->defaultSong());
+        for (const std::unique_ptr<LocalSong>& song : nongs->locals()) {
+            reference(song.get());
+        }
+        for (const std::unique_ptr<YTSong>& song : nongs->youtube()) {
+            reference(song.get());
+        }
+        for (const std::unique_ptr<HostedSong>& song : nongs->hosted()) {
+            reference(song.get());
+        }
+    }
+
+    async::spawn(findGarbage(std::move(scan)), [dryRun, callback = std::move(callback)](
+                                                   std::vector<GarbageFile> found) {
+        GarbageReport report{.m_reclaimed = !dryRun};
+
+        for (GarbageFile& file : found) {
+            // Songs may have been added while scanning, and downloads may
+            // have started
+            if ((file.m_audio && NongManager::get().isAudioReferenced(file.m_path)) ||
+                DownloadManager::get().isStaging(file.m_path)) {
+                continue;
+            }
+
+            if (!dryRun) {
+                std::error_code ec;
+                std::filesystem::remove(file.m_path, ec);
+                NongManager::get().pathCache().invalidate(file.m_path);
+                if (ec) {
+                    log::warn("Couldn't delete unused file {}: {}", file.m_path.filename(), ec.message());
+                    continue;
+                }
+            }
+
+            report.m_bytes += file.m_size;
+            report.m_files.push_back(std::move(file.m_path));
+        }
+
+        if (!report.m_files.empty()) {
+            log::info("{} {} unused files, {:.2f}MB", report.m_reclaimed ? "Deleted" : "Found", report.m_files.size(),
+                      static_cast<double>(report.m_bytes) / 1024 / 1024);
+        }
+
+        if (callback) {
+            callback(report);
+        }
+    });
+}
+
+}  // namespace jukebox
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jukebox {
+
+/**
+ * Keeps downloaded songs within the storage budget set by the user.
+ *
+ * Every time a song is played, the time is recorded for its audio file. Once
+ * stored audio takes more space than the budget, downloaded songs that were
+ * played the longest time ago get their audio deleted. Their metadata stays in
+ * the manifest, so they can be downloaded again.
+ *
+ * Local songs can't be downloaded again and active songs are about to be
+ * played, so audio used by either is never deleted.
+ *
+ * Files nothing uses anymore are found by collectGarbage.
+ */
+class StorageManager {
+public:
+    struct GarbageReport {
+        std::vector<std::filesystem::path> m_files;
+        uintmax_t m_bytes = 0;
+        // Whether the files were deleted, or only found
+        bool m_reclaimed = false;
+    };
+
+protected:
+    bool m_initialized = false;
+
+    // Audio file name -> when it was last played, in seconds since epoch
+    std::unordered_map<std::string, int64_t> m_lastUsed {};
+    // Size of stored audio the last time the budget was checked
+    uintmax_t m_storedBytes = 0;
+    bool m_scanning = false;
+    bool m_scanAgain = false;
+
+    StorageManager() = default;
+
+    // Stored audio file path -> its size and when it was written
+    using StoredFiles = std::unordered_map<std::string, std::pair<uintmax_t, std::filesystem::file_time_type>>;
+
+    /**
+     * Deletes the audio of the least recently played downloaded songs, given
+     * what a scan started at scannedAt found stored
+     *
+     * @return how many bytes were freed
+     */
+    uintmax_t evictOverBudget(uintmax_t total, const StoredFiles& stored, int64_t scannedAt);
+
+public:
+    StorageManager(const StorageManager&) = delete;
+    StorageManager(StorageManager&&) = delete;
+
+    StorageManager& operator=(const StorageManager&) = delete;
+    StorageManager& operator=(StorageManager&&) = delete;
+
+    bool init();
+
+    /**
+     * Records that an audio file is being played
+     */
+    void touch(const std::filesystem::path& path);
+
+    /**
+     * Writes the last played times to the mod's saved values
+     */
+    void save() const;
+
+    /**
+     * Deletes the audio of the least recently played downloaded songs until
+     * stored audio fits in the budget again. Stored audio is measured in the
+     * background, songs are evicted on the main thread once that's done.
+     */
+    void enforceBudget();
+
+    /**
+     * How much space stored audio took the last time the budget was checked.
+     * Only kept track of while a budget is set.
+     */
+    [[nodiscard]] uintmax_t storedBytes() const { return m_storedBytes; }
+
+    /**
+     * Looks for files nothing uses anymore in the background: audio no song
+     * points to, manifest files set aside because they couldn't be read, and
+     * leftovers from interrupted writes and downloads.
+     *
+     * @param dryRun only report what could be reclaimed, without deleting
+     * anything
+     * @param callback called on the main thread once done
+     */
+    void collectGarbage(bool dryRun, std::function<void(const GarbageReport&)> callback = {});
+
+    static StorageManager& get() {
+        static StorageManager instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
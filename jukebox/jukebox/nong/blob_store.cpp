@@ -0,0 +1,105 @@
+#include <jukebox/nong/blob_store.hpp>
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <Geode/loader/Mod.hpp>
+
+#include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/utils/path_cache.hpp>
+#include <jukebox/utils/sha256.hpp>
+
+using namespace geode::prelude;
+
+namespace jukebox::blobs {
+
+std::filesystem::path basePath() {
+    static std::filesystem::path path = Mod::get()->getSaveDir() / "blobs";
+    return path;
+}
+
+bool isBlob(const std::filesystem::path& path) { return path.parent_path() == basePath(); }
+
+std::filesystem::path pathFor(const std::string_view hash, const std::filesystem::path& extension) {
+    return basePath() / fmt::format("{}{}", hash, extension.string());
+}
+
+namespace {
+
+Result<std::filesystem::path> moveIntoStore(const std::filesystem::path& file, const std::filesystem::path& blob,
+                                            const bool keepSource) {
+    std::error_code ec;
+    std::filesystem::create_directories(basePath(), ec);
+    if (ec) {
+        return Err("Couldn't create the blob directory: {}", ec.message());
+    }
+
+    if (blob == file) {
+        return Ok(blob);
+    }
+
+    if (std::filesystem::exists(blob, ec)) {
+        if (!keepSource) {
+            std::filesystem::remove(file, ec);
+        }
+        return Ok(blob);
+    }
+
+    if (!keepSource) {
+        std::filesystem::rename(file, blob, ec);
+        if (!ec) {
+            return Ok(blob);
+        }
+        // Most likely on another drive, fall back to copying
+        ec.clear();
+    }
+
+    // Copy next to the blob first, so a failed copy never leaves a truncated
+    // blob behind
+    const std::filesystem::path temp = std::filesystem::path(blob).concat(".tmp");
+    std::filesystem::copy_file(file, temp, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        const std::string message = ec.message();
+        std::filesystem::remove(temp, ec);
+        return Err("Couldn't copy {} into the blob store: {}", file.filename(), message);
+    }
+
+    std::filesystem::rename(temp, blob, ec);
+    if (ec) {
+        const std::string message = ec.message();
+        std::filesystem::remove(temp, ec);
+        return Err("Couldn't move {} into the blob store: {}", file.filename(), message);
+    }
+
+    if (!keepSource) {
+        std::filesystem::remove(file, ec);
+    }
+
+    return Ok(blob);
+}
+
+}  // namespace
+
+Result<std::filesystem::path> commit(const std::filesystem::path& file, const std::string_view hash,
+                                     const std::filesystem::path& extension, const bool keepSource) {
+    const std::filesystem::path blob = pathFor(hash, extension);
+    Result<std::filesystem::path> res = moveIntoStore(file, blob, keepSource);
+
+    NongManager::get().pathCache().invalidate(blob);
+    if (!keepSource) {
+        NongManager::get().pathCache().invalidate(file);
+    }
+
+    return res;
+}
+
+Result<std::filesystem::path> store(const std::filesystem::path& file, const bool keepSource) {
+    GEODE_UNWRAP_INTO(const std::string hash, sha256File(file));
+    return commit(file, hash, file.extension(), keepSource);
+}
+
+}  // namespace jukebox::blobs
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include <Geode/Result.hpp>
+
+/**
+ * Song audio is stored once per distinct file, named after the SHA-256 of its
+ * contents. Songs using the same audio, whether under several song IDs or
+ * imported twice, point to the same blob.
+ *
+ * Blobs have no reference count of their own, references are the songs in the
+ * manifest pointing to them, see NongManager::releaseAudio.
+ *
+ * Hashing can happen on any thread, everything else in here must happen on
+ * the main thread so a blob can't be removed while it's being stored again.
+ */
+namespace jukebox::blobs {
+
+std::filesystem::path basePath();
+
+/**
+ * Whether the path points to a blob, as opposed to a file the user owns or one
+ * stored before blobs existed
+ */
+bool isBlob(const std::filesystem::path& path);
+
+std::filesystem::path pathFor(std::string_view hash, const std::filesystem::path& extension);
+
+/**
+ * Moves or copies a file into the store. If a blob with the same contents
+ * already exists, it's reused.
+ *
+ * @param file the file to store
+ * @param hash the SHA-256 of the file, see sha256File
+ * @param extension extension of the blob, including the leading dot
+ * @param keepSource whether to copy the file instead of moving it
+ * @return path of the blob
+ */
+geode::Result<std::filesystem::path> commit(const std::filesystem::path& file, std::string_view hash,
+                                            const std::filesystem::path& extension, bool keepSource);
+
+/**
+ * Hashes a file then commits it, keeping its extension. Hashing reads the whole
+ * file, so prefer hashing off the main thread and calling commit for big files.
+ */
+geode::Result<std::filesystem::path> store(const std::filesystem::path& file, bool keepSource);
+
+}  // namespace jukebox::blobs
@@ -1,14 +1,17 @@
 #pragma once
 
-#include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <fmt/core.h>
 #include <matjson.hpp>
 #include <vector>
 
+#include <jukebox/nong/index_arena.hpp>
+
 namespace jukebox {
 
 namespace index {
@@ -26,6 +29,15 @@ struct IndexSource final {
     }
 };
 
+// What was known about an index the last time it was fetched, used to make
+// conditional requests for it
+struct IndexValidators final {
+    std::optional<std::string> m_etag = std::nullopt;
+    std::optional<std::string> m_lastModified = std::nullopt;
+    std::optional<int> m_lastUpdate = std::nullopt;
+    std::optional<std::string> m_deltaUrl = std::nullopt;
+};
+
 struct IndexMetadata final {
     struct Links final {
         std::optional<std::string> m_discord = std::nullopt;
@@ -65,9 +77,10 @@ struct IndexMetadata final {
         std::optional<Report> m_report = std::nullopt;
     };
 
+    // Owned by m_arena
     struct Songs final {
-        std::vector<std::unique_ptr<IndexSongMetadata>> m_youtube;
-        std::vector<std::unique_ptr<IndexSongMetadata>> m_hosted;
+        std::vector<IndexSongMetadata*> m_youtube;
+        std::vector<IndexSongMetadata*> m_hosted;
     };
 
     int m_manifest;
@@ -76,19 +89,25 @@ struct IndexMetadata final {
     std::string m_name;
     std::optional<std::string> m_description;
     std::optional<int> m_lastUpdate;
+    // Where the host publishes deltas for this index, see applyIndexDelta
+    std::optional<std::string> m_deltaUrl;
     Links m_links;
     Features m_features;
     Songs m_songs;
+    IndexArena m_arena;
 };
 
+// Lives in the arena of its index, as does everything it points to, so it is
+// only valid as long as the index is loaded
 struct IndexSongMetadata final {
-    std::string uniqueID;
-    std::string name;
-    std::string artist;
-    std::optional<std::string> url;
-    std::optional<std::string> ytId;
-    std::vector<int> songIDs;
-    std::vector<int> verifiedLevelIDs;
+    std::string_view uniqueID;
+    std::string_view name;
+    // Interned, songs by the same artist share one copy
+    std::string_view artist;
+    std::optional<std::string_view> url;
+    std::optional<std::string_view> ytId;
+    std::span<const int> songIDs;
+    std::span<const int> verifiedLevelIDs;
     int startOffset = 0;
     IndexMetadata* parentID;
 };
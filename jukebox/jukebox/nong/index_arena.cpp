@@ -0,0 +1,85 @@
+#include <jukebox/nong/index_arena.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace jukebox::index {
+
+IndexArena::IndexArena(IndexArena&& other) noexcept
+    : m_blocks(std::move(other.m_blocks)),
+      m_cursor(std::exchange(other.m_cursor, nullptr)),
+      m_remaining(std::exchange(other.m_remaining, 0)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_interned(std::move(other.m_interned)) {}
+
+IndexArena& IndexArena::operator=(IndexArena&& other) noexcept {
+    if (this != &other) {
+        m_blocks = std::move(other.m_blocks);
+        m_cursor = std::exchange(other.m_cursor, nullptr);
+        m_remaining = std::exchange(other.m_remaining, 0);
+        m_size = std::exchange(other.m_size, 0);
+        m_interned = std::move(other.m_interned);
+    }
+    return *this;
+}
+
+void* IndexArena::allocate(const size_t size, const size_t align) {
+    void* ptr = m_cursor;
+    if (ptr && std::align(align, size, ptr, m_remaining)) {
+        m_cursor = static_cast<std::byte*>(ptr) + size;
+        m_remaining -= size;
+        return ptr;
+    }
+
+    // Big allocations get a block of their own instead of wasting what's left
+    // of the current one
+    if (size > s_blockSize / 4) {
+        m_blocks.emplace_back(new std::byte[size]);
+        m_size += size;
+        return m_blocks.back().get();
+    }
+
+    // new[] aligns to __STDCPP_DEFAULT_NEW_ALIGNMENT__, which covers anything
+    // an index stores
+    m_blocks.emplace_back(new std::byte[s_blockSize]);
+    m_size += s_blockSize;
+    m_cursor = m_blocks.back().get() + size;
+    m_remaining = s_blockSize - size;
+    return m_blocks.back().get();
+}
+
+std::string_view IndexArena::string(const std::string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+
+    auto* ptr = static_cast<char*>(this->allocate(str.size(), alignof(char)));
+    std::memcpy(ptr, str.data(), str.size());
+    return {ptr, str.size()};
+}
+
+std::string_view IndexArena::intern(const std::string_view str) {
+    if (const auto it = m_interned.find(str); it != m_interned.end()) {
+        return *it;
+    }
+
+    const std::string_view ret = this->string(str);
+    m_interned.insert(ret);
+    return ret;
+}
+
+std::span<const int> IndexArena::ints(const std::span<const int> values) {
+    if (values.empty()) {
+        return {};
+    }
+
+    auto* ptr = static_cast<int*>(this->allocate(values.size_bytes(), alignof(int)));
+    std::memcpy(ptr, values.data(), values.size_bytes());
+    return {ptr, values.size()};
+}
+
+}  // namespace jukebox::index
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace jukebox::index {
+
+/**
+ * Bump allocator owning the songs of an index and everything they point to.
+ * Memory is handed out from large blocks and only released when the arena is
+ * destroyed, so dropping an index frees all of its songs at once instead of
+ * one allocation per string and vector.
+ *
+ * Objects are never destroyed, only trivially destructible types can be
+ * allocated.
+ */
+class IndexArena final {
+private:
+    static constexpr size_t s_blockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::byte* m_cursor = nullptr;
+    size_t m_remaining = 0;
+    size_t m_size = 0;
+    std::unordered_set<std::string_view> m_interned;
+
+    void* allocate(size_t size, size_t align);
+
+public:
+    IndexArena() = default;
+    IndexArena(IndexArena&& other) noexcept;
+    IndexArena& operator=(IndexArena&& other) noexcept;
+    IndexArena(const IndexArena&) = delete;
+    IndexArena& operator=(const IndexArena&) = delete;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "Objects in an IndexArena are never destroyed");
+        return new (this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Copies a string into the arena
+     */
+    std::string_view string(std::string_view str);
+
+    /**
+     * Copies a string into the arena, unless an equal string was interned
+     * before, in which case that copy is returned
+     */
+    std::string_view intern(std::string_view str);
+
+    /**
+     * Copies integers into the arena
+     */
+    std::span<const int> ints(std::span<const int> values);
+
+    /**
+     * Bytes allocated for the arena's blocks
+     */
+    [[nodiscard]] size_t size() const { return m_size; }
+};
+
+}  // namespace jukebox::index
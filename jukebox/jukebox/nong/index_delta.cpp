@@ -0,0 +1,88 @@
+#include <jukebox/nong/index_delta.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <matjson.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Songs are parsed into their index's arena once the delta is applied, so
+// this only checks what would make parsing reject them
+Result<> validateSong(const matjson::Value& song) {
+    if (!song["name"].isString()) {
+        return Err("Missing or invalid \"name\" key");
+    }
+    if (!song["artist"].isString()) {
+        return Err("Missing or invalid \"artist\" key");
+    }
+    if (song.contains("verifiedLevelIDs") && !song["verifiedLevelIDs"].isArray()) {
+        return Err("Invalid \"verifiedLevelIDs\" key");
+    }
+    return Ok();
+}
+
+}  // namespace
+
+namespace jukebox::index {
+
+Result<> applyIndexDelta(matjson::Value& index, const matjson::Value& delta) {
+    GEODE_UNWRAP_INTO(std::intmax_t from, delta["from"].asInt());
+    GEODE_UNWRAP_INTO(std::intmax_t to, delta["to"].asInt());
+    GEODE_UNWRAP_INTO(std::intmax_t current, std::as_const(index)["lastUpdate"].asInt());
+
+    if (from != current) {
+        return Err("Delta applies to {}, but the cached index is at {}", from, current);
+    }
+
+    // Validate everything before touching the index, so a bad delta leaves it as is
+    const matjson::Value& add = delta["hosted"]["add"];
+    const matjson::Value& remove = delta["hosted"]["remove"];
+
+    if (delta["hosted"].contains("add") && !add.isObject()) {
+        return Err("Invalid \"add\" key");
+    }
+    if (delta["hosted"].contains("remove") && !remove.isArray()) {
+        return Err("Invalid \"remove\" key");
+    }
+
+    for (const auto& [key, song] : add) {
+        GEODE_UNWRAP(validateSong(song).mapErr(
+            [&key](std::string err) { return fmt::format("Invalid song {} in delta: {}", key, err); }));
+    }
+
+    for (const matjson::Value& id : remove) {
+        GEODE_UNWRAP(id.asString());
+    }
+
+    Result<matjson::Value&> nongs = index.get("nongs");
+    if (nongs.isErr()) {
+        return Err("Cached index has no songs");
+    }
+
+    Result<matjson::Value&> hosted = nongs.unwrap().get("hosted");
+    if (hosted.isErr()) {
+        return Err("Cached index has no hosted songs");
+    }
+
+    matjson::Value& songs = hosted.unwrap();
+
+    for (const matjson::Value& id : remove) {
+        songs.erase(id.asString().unwrap());
+    }
+
+    for (const auto& [key, song] : add) {
+        songs.set(key, song);
+    }
+
+    index.set("lastUpdate", to);
+
+    return Ok();
+}
+
+}  // namespace jukebox::index
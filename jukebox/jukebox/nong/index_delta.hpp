@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <matjson.hpp>
+
+namespace jukebox::index {
+
+/**
+ * Applies a delta document published by an index host to a cached copy of
+ * the index. An index advertises its delta with a top level "delta" url, and
+ * the document looks like this:
+ *
+ * {
+ *     "from": 1700000000,  // lastUpdate the delta applies on top of
+ *     "to": 1700086400,    // lastUpdate of the index after applying it
+ *     "hosted": {
+ *         "add": { "<unique id>": { ...song, same as in the index } },
+ *         "remove": [ "<unique id>" ]
+ *     }
+ * }
+ *
+ * Songs in "add" replace existing songs with the same unique ID. Fails
+ * without touching the index if the delta doesn't apply to it.
+ */
+geode::Result<> applyIndexDelta(matjson::Value& index, const matjson::Value& delta);
+
+}  // namespace jukebox::index
@@ -0,0 +1,533 @@
+#include <jukebox/nong/index_parser.hpp>
+
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <matjson.hpp>
+
+#include <jukebox/nong/index.hpp>
+#include <jukebox/nong/index_arena.hpp>
+#include <jukebox/nong/index_serialize.hpp>
+
+using namespace geode::prelude;
+using namespace jukebox::index;
+
+namespace {
+
+// Minimal pull parser over JSON text. Syntax errors are fatal, type errors are
+// left to the caller, which can peek at what comes next and skip it.
+class Reader {
+private:
+    std::string_view m_src;
+    size_t m_pos = 0;
+
+    void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    Result<uint32_t> hex4() {
+        if (m_pos + 4 > m_src.size()) {
+            return Err("Unexpected end of input in escape");
+        }
+
+        uint32_t value = 0;
+        const auto [ptr, ec] = std::from_chars(m_src.data() + m_pos, m_src.data() + m_pos + 4, value, 16);
+        if (ec != std::errc() || ptr != m_src.data() + m_pos + 4) {
+            return Err("Invalid unicode escape at offset {}", m_pos);
+        }
+
+        m_pos += 4;
+        return Ok(value);
+    }
+
+    Result<> literal(std::string_view word) {
+        if (m_src.substr(m_pos, word.size()) != word) {
+            return Err("Unexpected character at offset {}", m_pos);
+        }
+        m_pos += word.size();
+        return Ok();
+    }
+
+public:
+    explicit Reader(std::string_view src) : m_src(src) {}
+
+    [[nodiscard]] size_t position() const { return m_pos; }
+
+    void skipWhitespace() {
+        while (m_pos < m_src.size()) {
+            const char c = m_src[m_pos];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                break;
+            }
+            m_pos++;
+        }
+    }
+
+    char peek() {
+        this->skipWhitespace();
+        return m_pos < m_src.size() ? m_src[m_pos] : '\0';
+    }
+
+    bool atEnd() {
+        this->skipWhitespace();
+        return m_pos >= m_src.size();
+    }
+
+    Result<> expect(char c) {
+        if (this->peek() != c) {
+            return Err("Expected '{}' at offset {}", c, m_pos);
+        }
+        m_pos++;
+        return Ok();
+    }
+
+    Result<std::string> string() {
+        GEODE_UNWRAP(this->expect('"'));
+
+        std::string out;
+
+        while (true) {
+            // Copy plain runs in one go, most strings have no escapes at all
+            const size_t start = m_pos;
+            while (m_pos < m_src.size() && m_src[m_pos] != '"' && m_src[m_pos] != '\\') {
+                if (static_cast<unsigned char>(m_src[m_pos]) < 0x20) {
+                    return Err("Control character in string at offset {}", m_pos);
+                }
+                m_pos++;
+            }
+            out.append(m_src.substr(start, m_pos - start));
+
+            if (m_pos >= m_src.size()) {
+                return Err("Unterminated string");
+            }
+
+            if (m_src[m_pos++] == '"') {
+                return Ok(std::move(out));
+            }
+
+            if (m_pos >= m_src.size()) {
+                return Err("Unterminated string");
+            }
+
+            switch (const char c = m_src[m_pos++]) {
+                case '"':
+                case '\\':
+                case '/':
+                    out.push_back(c);
+                    break;
+                case 'b':
+                    out.push_back('\b');
+                    break;
+                case 'f':
+                    out.push_back('\f');
+                    break;
+                case 'n':
+                    out.push_back('\n');
+                    break;
+                case 'r':
+                    out.push_back('\r');
+                    break;
+                case 't':
+                    out.push_back('\t');
+                    break;
+                case 'u': {
+                    GEODE_UNWRAP_INTO(uint32_t cp, this->hex4());
+                    if (cp >= 0xD800 && cp <= 0xDBFF && m_src.substr(m_pos, 2) == "\\u") {
+                        m_pos += 2;
+                        GEODE_UNWRAP_INTO(uint32_t low, this->hex4());
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            return Err("Invalid surrogate pair at offset {}", m_pos);
+                        }
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    this->appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return Err("Invalid escape at offset {}", m_pos - 1);
+            }
+        }
+    }
+
+    /**
+     * Reads a number. Resolves to nullopt if it isn't an integer that fits
+     */
+    Result<std::optional<intmax_t>> number() {
+        this->skipWhitespace();
+        const size_t start = m_pos;
+        bool integral = true;
+
+        if (m_pos < m_src.size() && m_src[m_pos] == '-') {
+            m_pos++;
+        }
+
+        const auto digits = [this] {
+            const size_t from = m_pos;
+            while (m_pos < m_src.size() && m_src[m_pos] >= '0' && m_src[m_pos] <= '9') {
+                m_pos++;
+            }
+            return m_pos > from;
+        };
+
+        if (!digits()) {
+            return Err("Invalid number at offset {}", start);
+        }
+
+        if (m_pos < m_src.size() && m_src[m_pos] == '.') {
+            integral = false;
+            m_pos++;
+            if (!digits()) {
+                return Err("Invalid number at offset {}", start);
+            }
+        }
+
+        if (m_pos < m_src.size() && (m_src[m_pos] == 'e' || m_src[m_pos] == 'E')) {
+            integral = false;
+            m_pos++;
+            if (m_pos < m_src.size() && (m_src[m_pos] == '+' || m_src[m_pos] == '-')) {
+                m_pos++;
+            }
+            if (!digits()) {
+                return Err("Invalid number at offset {}", start);
+            }
+        }
+
+        if (!integral) {
+            return Ok(std::nullopt);
+        }
+
+        intmax_t value = 0;
+        const auto [ptr, ec] = std::from_chars(m_src.data() + start, m_src.data() + m_pos, value);
+        if (ec != std::errc()) {
+            return Ok(std::nullopt);
+        }
+
+        return Ok(std::optional<intmax_t>(value));
+    }
+
+    /**
+     * Calls member(key) for every member of an object. member has to consume
+     * the value.
+     */
+    template <typename F>
+    Result<> object(F&& member) {
+        GEODE_UNWRAP(this->expect('{'));
+
+        if (this->peek() == '}') {
+            m_pos++;
+            return Ok();
+        }
+
+        while (true) {
+            GEODE_UNWRAP_INTO(std::string key, this->string());
+            GEODE_UNWRAP(this->expect(':'));
+            GEODE_UNWRAP(member(std::move(key)));
+
+            const char c = this->peek();
+            m_pos++;
+
+            if (c == ',') {
+                continue;
+            }
+            if (c == '}') {
+                return Ok();
+            }
+
+            return Err("Expected ',' or '}}' at offset {}", m_pos - 1);
+        }
+    }
+
+    /**
+     * Calls element() for every element of an array. element has to consume
+     * the value.
+     */
+    template <typename F>
+    Result<> array(F&& element) {
+        GEODE_UNWRAP(this->expect('['));
+
+        if (this->peek() == ']') {
+            m_pos++;
+            return Ok();
+        }
+
+        while (true) {
+            GEODE_UNWRAP(element());
+
+            const char c = this->peek();
+            m_pos++;
+
+            if (c == ',') {
+                continue;
+            }
+            if (c == ']') {
+                return Ok();
+            }
+
+            return Err("Expected ',' or ']' at offset {}", m_pos - 1);
+        }
+    }
+
+    /**
+     * Skips over any value, returning its raw text
+     */
+    Result<std::string_view> skip() {
+        const char c = this->peek();
+        const size_t start = m_pos;
+
+        switch (c) {
+            case '"':
+                GEODE_UNWRAP(this->string());
+                break;
+            case '{':
+                GEODE_UNWRAP(this->object([this](std::string) -> Result<> {
+                    GEODE_UNWRAP(this->skip());
+                    return Ok();
+                }));
+                break;
+            case '[':
+                GEODE_UNWRAP(this->array([this]() -> Result<> {
+                    GEODE_UNWRAP(this->skip());
+                    return Ok();
+                }));
+                break;
+            case 't':
+                GEODE_UNWRAP(this->literal("true"));
+                break;
+            case 'f':
+                GEODE_UNWRAP(this->literal("false"));
+                break;
+            case 'n':
+                GEODE_UNWRAP(this->literal("null"));
+                break;
+            default:
+                GEODE_UNWRAP(this->number());
+                break;
+        }
+
+        return Ok(m_src.substr(start, m_pos - start));
+    }
+
+    // Helpers mirroring how index_serialize.hpp treats mistyped fields
+
+    Result<std::optional<std::string>> optionalString() {
+        if (this->peek() != '"') {
+            GEODE_UNWRAP(this->skip());
+            return Ok(std::nullopt);
+        }
+        return this->string().map([](std::string str) { return std::optional(std::move(str)); });
+    }
+
+    Result<std::optional<intmax_t>> optionalInt() {
+        const char c = this->peek();
+        if (c != '-' && (c < '0' || c > '9')) {
+            GEODE_UNWRAP(this->skip());
+            return Ok(std::nullopt);
+        }
+        return this->number();
+    }
+
+    /**
+     * Reads an array of integers, skipping elements that aren't integers.
+     * Resolves to nullopt if the value isn't an array.
+     */
+    Result<std::optional<std::vector<int>>> intArray() {
+        if (this->peek() != '[') {
+            GEODE_UNWRAP(this->skip());
+            return Ok(std::nullopt);
+        }
+
+        std::vector<int> values;
+        GEODE_UNWRAP(this->array([this, &values]() -> Result<> {
+            GEODE_UNWRAP_INTO(std::optional<intmax_t> value, this->optionalInt());
+            if (value) {
+                values.push_back(static_cast<int>(value.value()));
+            }
+            return Ok();
+        }));
+
+        return Ok(std::optional(std::move(values)));
+    }
+};
+
+// Reads one hosted song into the arena. Fails only on syntax errors, songs
+// that are invalid but well formed resolve to an error message instead.
+Result<std::variant<IndexSongMetadata*, std::string>> readSong(Reader& reader, IndexArena& arena,
+                                                              const std::string_view uniqueID) {
+    using Ret = std::variant<IndexSongMetadata*, std::string>;
+
+    if (reader.peek() != '{') {
+        GEODE_UNWRAP(reader.skip());
+        return Ok(Ret(std::string("Song is not an object")));
+    }
+
+    std::optional<std::string> name;
+    std::optional<std::string> artist;
+    std::optional<std::string> url;
+    std::optional<std::string> ytId;
+    std::vector<int> songIDs;
+    std::vector<int> verifiedLevelIDs;
+    int startOffset = 0;
+    bool badVerifiedLevelIDs = false;
+
+    GEODE_UNWRAP(reader.object([&](std::string key) -> Result<> {
+        if (key == "name") {
+            GEODE_UNWRAP_INTO(name, reader.optionalString());
+        } else if (key == "artist") {
+            GEODE_UNWRAP_INTO(artist, reader.optionalString());
+        } else if (key == "url") {
+            GEODE_UNWRAP_INTO(url, reader.optionalString());
+        } else if (key == "ytID") {
+            GEODE_UNWRAP_INTO(ytId, reader.optionalString());
+        } else if (key == "startOffset") {
+            GEODE_UNWRAP_INTO(std::optional<intmax_t> offset, reader.optionalInt());
+            startOffset = static_cast<int>(offset.value_or(0));
+        } else if (key == "songs") {
+            GEODE_UNWRAP_INTO(std::optional<std::vector<int>> ids, reader.intArray());
+            songIDs = std::move(ids).value_or(std::vector<int>{});
+        } else if (key == "verifiedLevelIDs") {
+            GEODE_UNWRAP_INTO(std::optional<std::vector<int>> ids, reader.intArray());
+            badVerifiedLevelIDs = !ids.has_value();
+            verifiedLevelIDs = std::move(ids).value_or(std::vector<int>{});
+        } else {
+            GEODE_UNWRAP(reader.skip());
+        }
+        return Ok();
+    }));
+
+    // Same checks, in the same order, as validateSong in index_delta.cpp
+    if (!name) {
+        return Ok(Ret(std::string("Missing or invalid \"name\" key")));
+    }
+    if (!artist) {
+        return Ok(Ret(std::string("Missing or invalid \"artist\" key")));
+    }
+    if (badVerifiedLevelIDs) {
+        return Ok(Ret(std::string("Invalid \"verifiedLevelIDs\" key")));
+    }
+
+    const auto optionalString = [&arena](const std::optional<std::string>& str) -> std::optional<std::string_view> {
+        if (!str) {
+            return std::nullopt;
+        }
+        return arena.string(str.value());
+    };
+
+    return Ok(Ret(arena.make<IndexSongMetadata>(IndexSongMetadata{
+        .uniqueID = arena.string(uniqueID),
+        .name = arena.string(name.value()),
+        .artist = arena.intern(artist.value()),
+        .url = optionalString(url),
+        .ytId = optionalString(ytId),
+        .songIDs = arena.ints(songIDs),
+        .verifiedLevelIDs = arena.ints(verifiedLevelIDs),
+        .startOffset = startOffset,
+        .parentID = nullptr})));
+}
+
+}  // namespace
+
+namespace jukebox::index {
+
+Result<ParsedIndex> parseIndexJson(const std::string_view json, const std::optional<std::string_view> url) {
+    Reader reader(json);
+
+    ParsedIndex ret;
+    IndexArena arena;
+    std::vector<IndexSongMetadata*> hosted;
+
+    std::string header = "{";
+    const auto appendMember = [&header](const std::string& key, const std::string_view raw) {
+        if (header.size() > 1) {
+            header.push_back(',');
+        }
+        header += matjson::Value(key).dump(matjson::NO_INDENTATION);
+        header.push_back(':');
+        header.append(raw);
+    };
+
+    GEODE_UNWRAP(reader.object([&](std::string key) -> Result<> {
+        if (key != "nongs") {
+            GEODE_UNWRAP_INTO(const std::string_view raw, reader.skip());
+            if (key != "url" || !url) {
+                appendMember(key, raw);
+            }
+            return Ok();
+        }
+
+        if (reader.peek() != '{') {
+            GEODE_UNWRAP(reader.skip());
+            return Ok();
+        }
+
+        // TODO: read youtube songs too, once youtube downloads are re-enabled
+        return reader.object([&](std::string type) -> Result<> {
+            if (type != "hosted" || reader.peek() != '{') {
+                GEODE_UNWRAP(reader.skip());
+                return Ok();
+            }
+
+            return reader.object([&](std::string uniqueID) -> Result<> {
+                GEODE_UNWRAP_INTO(auto song, readSong(reader, arena, uniqueID));
+
+                if (auto* err = std::get_if<std::string>(&song)) {
+                    ret.errors.push_back(fmt::format("Failed to parse index song: {}", *err));
+                } else {
+                    hosted.push_back(std::get<IndexSongMetadata*>(song));
+                }
+
+                return Ok();
+            });
+        });
+    }));
+
+    if (!reader.atEnd()) {
+        return Err("Unexpected data after index at offset {}", reader.position());
+    }
+
+    if (url) {
+        appendMember("url", matjson::Value(std::string(url.value())).dump(matjson::NO_INDENTATION));
+    }
+    header.push_back('}');
+
+    GEODE_UNWRAP_INTO(matjson::Value headerJson, matjson::parse(header).mapErr([](const matjson::ParseError& err) {
+        return err.message;
+    }));
+    GEODE_UNWRAP_INTO(IndexMetadata meta, matjson::Serialize<IndexMetadata>::fromJson(headerJson));
+
+    ret.index = std::make_unique<IndexMetadata>(std::move(meta));
+    ret.header = std::move(header);
+
+    for (IndexSongMetadata* song : hosted) {
+        song->parentID = ret.index.get();
+    }
+    ret.index->m_songs.m_hosted = std::move(hosted);
+    ret.index->m_arena = std::move(arena);
+
+    return Ok(std::move(ret));
+}
+
+}  // namespace jukebox::index
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+#include <jukebox/nong/index.hpp>
+
+namespace jukebox::index {
+
+struct ParsedIndex {
+    std::unique_ptr<IndexMetadata> index;
+    // JSON of the index without its songs, as stored in the sidecar
+    std::string header;
+    // Songs that failed to parse and were skipped
+    std::vector<std::string> errors;
+};
+
+/**
+ * Parses an index straight from its JSON text. Songs are read field by field
+ * into IndexSongMetadata without building a matjson DOM for the whole index,
+ * only the small header goes through matjson::Serialize<IndexMetadata>, so it
+ * is validated exactly like before.
+ *
+ * @param json the index JSON
+ * @param url overrides the "url" of the index, used for indexes fetched from
+ * the network which don't contain their own url
+ */
+geode::Result<ParsedIndex> parseIndexJson(std::string_view json, std::optional<std::string_view> url = std::nullopt);
+
+}  // namespace jukebox::index
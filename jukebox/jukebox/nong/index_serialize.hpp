@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <optional>
+#include <string>
+#include <string_view>
 
 #include <Geode/Result.hpp>
 #include <matjson.hpp>
@@ -142,63 +144,15 @@ struct matjson::Serialize<jukebox::index::IndexMetadata> {
                                 .asInt()
                                 .map([](auto i) { return std::optional(i); })
                                 .unwrapOr(std::nullopt),
+            .m_deltaUrl = value["delta"]
+                              .asString()
+                              .map([](auto i) { return std::optional(i); })
+                              .unwrapOr(std::nullopt),
             .m_links = std::move(links),
             .m_features = std::move(features)});
     }
 };
 
-template <>
-struct matjson::Serialize<jukebox::index::IndexSongMetadata> {
-    static geode::Result<jukebox::index::IndexSongMetadata> fromJson(
-        const matjson::Value& value) {
-        GEODE_UNWRAP_INTO(std::string name, value["name"].asString());
-        GEODE_UNWRAP_INTO(std::string artist, value["artist"].asString());
-
-        if (value.contains("verifiedLevelIDs") &&
-            !value["verifiedLevelIDs"].isArray()) {
-            return geode::Err("Invalid \"verifiedLevelIDs\" key");
-        }
-
-        std::vector<int> songs;
-        songs.reserve(value["songs"].size());
-        for (const matjson::Value& i : value["songs"]) {
-            geode::Result<std::intmax_t> id = i.asInt();
-            if (!id) {
-                continue;
-            }
-            songs.push_back(id.unwrap());
-        }
-
-        std::vector<int> verifiedLevelIDs;
-        verifiedLevelIDs.reserve(value["verifiedLevelIDs"].size());
-        for (const matjson::Value& i : value["verifiedLevelIDs"]) {
-            geode::Result<std::intmax_t> res = i.asInt();
-            if (!res) {
-                continue;
-            }
-            verifiedLevelIDs.push_back(res.unwrap());
-        }
-
-        return geode::Ok(jukebox::index::IndexSongMetadata{
-            .uniqueID = "",
-            .name = name,
-            .artist = artist,
-            .url = value["url"]
-                       .asString()
-                       .map([](auto i) { return std::optional(i); })
-                       .unwrapOr(std::nullopt),
-            .ytId = value["ytID"]
-                        .asString()
-                        .map([](auto i) { return std::optional(i); })
-                        .unwrapOr(std::nullopt),
-            .songIDs = std::move(songs),
-            .verifiedLevelIDs = std::move(verifiedLevelIDs),
-            .startOffset =
-                static_cast<int>(value["startOffset"].asInt().unwrapOr(0)),
-            .parentID = nullptr});
-    }
-};
-
 template <>
 struct matjson::Serialize<jukebox::index::IndexSource> {
     static geode::Result<jukebox::index::IndexSource> fromJson(
@@ -218,3 +172,45 @@ struct matjson::Serialize<jukebox::index::IndexSource> {
                                     {"enabled", value.m_enabled}});
     }
 };
+
+template <>
+struct matjson::Serialize<jukebox::index::IndexValidators> {
+    static geode::Result<jukebox::index::IndexValidators> fromJson(
+        matjson::Value const& value) {
+        const auto optionalString = [&value](std::string_view key) {
+            return value[key]
+                .asString()
+                .map([](auto i) { return std::optional(i); })
+                .unwrapOr(std::nullopt);
+        };
+
+        return geode::Ok(jukebox::index::IndexValidators{
+            .m_etag = optionalString("etag"),
+            .m_lastModified = optionalString("lastModified"),
+            .m_lastUpdate = value["lastUpdate"]
+                                .asInt()
+                                .map([](auto i) {
+                                    return std::optional(static_cast<int>(i));
+                                })
+                                .unwrapOr(std::nullopt),
+            .m_deltaUrl = optionalString("delta")});
+    }
+
+    static matjson::Value toJson(
+        jukebox::index::IndexValidators const& value) {
+        matjson::Value ret = matjson::Value::object();
+        if (value.m_etag) {
+            ret.set("etag", value.m_etag.value());
+        }
+        if (value.m_lastModified) {
+            ret.set("lastModified", value.m_lastModified.value());
+        }
+        if (value.m_lastUpdate) {
+            ret.set("lastUpdate", value.m_lastUpdate.value());
+        }
+        if (value.m_deltaUrl) {
+            ret.set("delta", value.m_deltaUrl.value());
+        }
+        return ret;
+    }
+};
@@ -0,0 +1,340 @@
+#include <jukebox/nong/index_sidecar.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <matjson.hpp>
+
+#include <jukebox/nong/index.hpp>
+#include <jukebox/nong/index_arena.hpp>
+#include <jukebox/nong/index_serialize.hpp>
+#include <jukebox/utils/file.hpp>
+#include <jukebox/utils/mapped_file.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Layout, all little endian:
+//   header:  char[4] magic, u32 version, u64 source hash, u32 song count,
+//            u32 lookup count, u32 int count, u32 pool size,
+//            u32 header offset, u32 header length, u32[2] reserved
+//   songs:   per song, (offset, length) into the pool for the unique ID, name,
+//            artist, url and YouTube ID, then i32 start offset, and
+//            (first, count) into the int table for song IDs and level IDs
+//   lookup:  i32 song ID, u32 song index
+//   ints:    i32 values
+//   pool:    string bytes
+constexpr std::array<char, 4> MAGIC = {'J', 'B', 'I', 'X'};
+constexpr size_t HEADER_SIZE = 48;
+constexpr size_t SONG_SIZE = 15 * sizeof(uint32_t);
+constexpr size_t LOOKUP_SIZE = 8;
+// String length marking a missing optional string
+constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+template <typename T>
+T readAt(const uint8_t* data, size_t offset) {
+    T ret;
+    std::memcpy(&ret, data + offset, sizeof(T));
+    return ret;
+}
+
+template <typename T>
+void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+class Writer {
+private:
+    std::string m_pool;
+    std::vector<int32_t> m_ints;
+    std::unordered_map<std::string_view, std::pair<uint32_t, uint32_t>> m_interned;
+
+public:
+    std::pair<uint32_t, uint32_t> string(const std::string_view str) {
+        const auto offset = static_cast<uint32_t>(m_pool.size());
+        m_pool.append(str);
+        return {offset, static_cast<uint32_t>(str.size())};
+    }
+
+    std::pair<uint32_t, uint32_t> string(const std::optional<std::string_view> str) {
+        if (!str) {
+            return {0, NONE};
+        }
+        return this->string(str.value());
+    }
+
+    // Artists are interned in the index arena, so they are stored once here
+    // too and stay shared when the sidecar is read back
+    std::pair<uint32_t, uint32_t> intern(const std::string_view str) {
+        if (const auto it = m_interned.find(str); it != m_interned.end()) {
+            return it->second;
+        }
+        return m_interned.emplace(str, this->string(str)).first->second;
+    }
+
+    std::pair<uint32_t, uint32_t> ints(const std::span<const int> values) {
+        const auto first = static_cast<uint32_t>(m_ints.size());
+        m_ints.insert(m_ints.end(), values.begin(), values.end());
+        return {first, static_cast<uint32_t>(values.size())};
+    }
+
+    const std::string& pool() const { return m_pool; }
+    const std::vector<int32_t>& intTable() const { return m_ints; }
+};
+
+// Reads songs out of a sidecar. The string pool and int table are copied into
+// the index arena up front, so songs point into those copies.
+class Reader {
+private:
+    const uint8_t* m_data;
+    size_t m_songs;
+    std::span<const int> m_ints;
+    std::string_view m_pool;
+
+public:
+    Reader(const uint8_t* data, size_t songs, std::span<const int> ints, std::string_view pool)
+        : m_data(data), m_songs(songs), m_ints(ints), m_pool(pool) {}
+
+    Result<std::optional<std::string_view>> string(const size_t field) const {
+        const auto offset = readAt<uint32_t>(m_data, field);
+        const auto length = readAt<uint32_t>(m_data, field + 4);
+
+        if (length == NONE) {
+            return Ok(std::nullopt);
+        }
+
+        if (static_cast<uint64_t>(offset) + length > m_pool.size()) {
+            return Err("String out of bounds");
+        }
+
+        return Ok(std::optional(m_pool.substr(offset, length)));
+    }
+
+    Result<std::string_view> requiredString(const size_t field) const {
+        GEODE_UNWRAP_INTO(std::optional<std::string_view> str, this->string(field));
+        if (!str) {
+            return Err("Missing required string");
+        }
+        return Ok(str.value());
+    }
+
+    Result<std::span<const int>> ints(const size_t field) const {
+        const auto first = readAt<uint32_t>(m_data, field);
+        const auto count = readAt<uint32_t>(m_data, field + 4);
+
+        if (static_cast<uint64_t>(first) + count > m_ints.size()) {
+            return Err("Integer list out of bounds");
+        }
+
+        return Ok(m_ints.subspan(first, count));
+    }
+
+    Result<jukebox::index::IndexSongMetadata> song(const size_t i) const {
+        const size_t base = m_songs + i * SONG_SIZE;
+
+        GEODE_UNWRAP_INTO(std::string_view uniqueID, this->requiredString(base));
+        GEODE_UNWRAP_INTO(std::string_view name, this->requiredString(base + 8));
+        GEODE_UNWRAP_INTO(std::string_view artist, this->requiredString(base + 16));
+        GEODE_UNWRAP_INTO(std::optional<std::string_view> url, this->string(base + 24));
+        GEODE_UNWRAP_INTO(std::optional<std::string_view> ytId, this->string(base + 32));
+        GEODE_UNWRAP_INTO(std::span<const int> songIDs, this->ints(base + 44));
+        GEODE_UNWRAP_INTO(std::span<const int> verifiedLevelIDs, this->ints(base + 52));
+
+        return Ok(jukebox::index::IndexSongMetadata{
+            .uniqueID = uniqueID,
+            .name = name,
+            .artist = artist,
+            .url = url,
+            .ytId = ytId,
+            .songIDs = songIDs,
+            .verifiedLevelIDs = verifiedLevelIDs,
+            .startOffset = readAt<int32_t>(m_data, base + 40),
+            .parentID = nullptr});
+    }
+};
+
+}  // namespace
+
+namespace jukebox::index {
+
+SongLookup buildSongLookup(const IndexMetadata& index) {
+    SongLookup lookup;
+
+    for (IndexSongMetadata* song : index.m_songs.m_hosted) {
+        for (const int id : song->songIDs) {
+            lookup.emplace_back(id, song);
+        }
+    }
+
+    std::ranges::stable_sort(lookup, {}, &SongLookup::value_type::first);
+
+    return lookup;
+}
+
+Result<> IndexSidecar::write(const std::filesystem::path& path, const IndexMetadata& index, const SongLookup& lookup,
+                             const std::string_view header, const uint64_t sourceHash) {
+    // YouTube songs aren't loaded from indexes yet, so only hosted ones are stored
+    const std::vector<IndexSongMetadata*>& songs = index.m_songs.m_hosted;
+
+    Writer writer;
+    std::string records;
+    records.reserve(songs.size() * SONG_SIZE);
+    std::unordered_map<const IndexSongMetadata*, uint32_t> songIndices;
+
+    for (size_t i = 0; i < songs.size(); i++) {
+        const IndexSongMetadata& song = *songs[i];
+        songIndices.emplace(&song, static_cast<uint32_t>(i));
+
+        for (const auto [first, second] : {
+                 writer.string(song.uniqueID),
+                 writer.string(song.name),
+                 writer.intern(song.artist),
+                 writer.string(song.url),
+                 writer.string(song.ytId),
+             }) {
+            append<uint32_t>(records, first);
+            append<uint32_t>(records, second);
+        }
+
+        append<int32_t>(records, song.startOffset);
+
+        for (const auto [first, count] : {writer.ints(song.songIDs), writer.ints(song.verifiedLevelIDs)}) {
+            append<uint32_t>(records, first);
+            append<uint32_t>(records, count);
+        }
+    }
+
+    const auto [headerOffset, headerLength] = writer.string(header);
+
+    std::string out;
+    out.reserve(HEADER_SIZE + records.size() + lookup.size() * LOOKUP_SIZE +
+                writer.intTable().size() * sizeof(int32_t) + writer.pool().size());
+
+    out.append(MAGIC.data(), MAGIC.size());
+    append<uint32_t>(out, s_version);
+    append<uint64_t>(out, sourceHash);
+    append<uint32_t>(out, static_cast<uint32_t>(songs.size()));
+    append<uint32_t>(out, static_cast<uint32_t>(lookup.size()));
+    append<uint32_t>(out, static_cast<uint32_t>(writer.intTable().size()));
+    append<uint32_t>(out, static_cast<uint32_t>(writer.pool().size()));
+    append<uint32_t>(out, headerOffset);
+    append<uint32_t>(out, headerLength);
+    append<uint32_t>(out, 0);
+    append<uint32_t>(out, 0);
+
+    out.append(records);
+
+    for (const auto& [id, song] : lookup) {
+        const auto it = songIndices.find(song);
+        if (it == songIndices.end()) {
+            return Err("Song lookup refers to a song outside of the index");
+        }
+
+        append<int32_t>(out, id);
+        append<uint32_t>(out, it->second);
+    }
+
+    for (const int32_t value : writer.intTable()) {
+        append<int32_t>(out, value);
+    }
+
+    out.append(writer.pool());
+
+    return utils::file::writeStringAtomic(path, out);
+}
+
+Result<IndexSidecar::Loaded> IndexSidecar::read(const std::filesystem::path& path, const uint64_t sourceHash) {
+    GEODE_UNWRAP_INTO(MappedFile file, MappedFile::open(path));
+
+    const uint8_t* data = file.data().data();
+
+    if (file.size() < HEADER_SIZE || std::memcmp(data, MAGIC.data(), MAGIC.size()) != 0) {
+        return Err("{} is not an index sidecar", path.filename());
+    }
+
+    if (const auto version = readAt<uint32_t>(data, 4); version != s_version) {
+        return Err("Unsupported index sidecar version {}", version);
+    }
+
+    if (readAt<uint64_t>(data, 8) != sourceHash) {
+        return Err("Index sidecar is out of date");
+    }
+
+    const auto songCount = readAt<uint32_t>(data, 16);
+    const auto lookupCount = readAt<uint32_t>(data, 20);
+    const auto intCount = readAt<uint32_t>(data, 24);
+    const auto poolSize = readAt<uint32_t>(data, 28);
+
+    const uint64_t songs = HEADER_SIZE;
+    const uint64_t lookup = songs + static_cast<uint64_t>(songCount) * SONG_SIZE;
+    const uint64_t ints = lookup + static_cast<uint64_t>(lookupCount) * LOOKUP_SIZE;
+    const uint64_t pool = ints + static_cast<uint64_t>(intCount) * sizeof(int32_t);
+
+    if (pool + poolSize != file.size()) {
+        return Err("Index sidecar is truncated");
+    }
+
+    // The mapping goes away once this returns, so the pool and int table are
+    // copied into the arena in one go each
+    IndexArena arena;
+    std::vector<int> intTable(intCount);
+    if (intCount > 0) {
+        std::memcpy(intTable.data(), data + ints, intCount * sizeof(int32_t));
+    }
+
+    const Reader reader(data, songs, arena.ints(intTable),
+                        arena.string(std::string_view(reinterpret_cast<const char*>(data + pool), poolSize)));
+
+    GEODE_UNWRAP_INTO(std::optional<std::string_view> header, reader.string(32));
+    if (!header) {
+        return Err("Index sidecar has no header");
+    }
+
+    GEODE_UNWRAP_INTO(matjson::Value headerJson, matjson::parse(header.value()).mapErr([](matjson::ParseError err) {
+        return err.message;
+    }));
+    GEODE_UNWRAP_INTO(IndexMetadata indexMeta, matjson::Serialize<IndexMetadata>::fromJson(headerJson));
+
+    auto index = std::make_unique<IndexMetadata>(std::move(indexMeta));
+    index->m_songs.m_hosted.reserve(songCount);
+
+    for (size_t i = 0; i < songCount; i++) {
+        GEODE_UNWRAP_INTO(IndexSongMetadata song, reader.song(i));
+        song.parentID = index.get();
+        index->m_songs.m_hosted.push_back(arena.make<IndexSongMetadata>(song));
+    }
+
+    SongLookup songLookup;
+    songLookup.reserve(lookupCount);
+
+    for (size_t i = 0; i < lookupCount; i++) {
+        const size_t entry = lookup + i * LOOKUP_SIZE;
+        const auto songIndex = readAt<uint32_t>(data, entry + 4);
+
+        if (songIndex >= songCount) {
+            return Err("Song lookup entry out of bounds");
+        }
+
+        songLookup.emplace_back(readAt<int32_t>(data, entry), index->m_songs.m_hosted[songIndex]);
+    }
+
+    index->m_arena = std::move(arena);
+
+    return Ok(Loaded{std::move(index), std::move(songLookup)});
+}
+
+}  // namespace jukebox::index
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+#include <jukebox/nong/index.hpp>
+
+namespace jukebox::index {
+
+// (song ID, index song) pairs, sorted by song ID. Songs sharing a song ID keep
+// the order they have in the index.
+using SongLookup = std::vector<std::pair<int, IndexSongMetadata*>>;
+
+SongLookup buildSongLookup(const IndexMetadata& index);
+
+/**
+ * Binary copy of a parsed index, stored next to its cached JSON so it can be
+ * loaded without parsing the JSON again.
+ *
+ * The file holds a fixed size record per song pointing into a shared string
+ * pool and integer table, the song lookup, and the hash of the JSON it was
+ * built from. A sidecar whose hash doesn't match the cached JSON is stale and
+ * gets rejected.
+ */
+class IndexSidecar final {
+public:
+    static constexpr uint32_t s_version = 1;
+
+    struct Loaded {
+        std::unique_ptr<IndexMetadata> index;
+        SongLookup lookup;
+    };
+
+    /**
+     * Writes a sidecar for an index
+     *
+     * @param path where to write the sidecar
+     * @param index the parsed index
+     * @param lookup the song lookup of the index, see buildSongLookup
+     * @param header JSON of the index without its songs
+     * @param sourceHash hash of the JSON the index was parsed from
+     */
+    static geode::Result<> write(const std::filesystem::path& path, const IndexMetadata& index,
+                                 const SongLookup& lookup, std::string_view header, uint64_t sourceHash);
+
+    /**
+     * Reads a sidecar, if it was built from JSON with the given hash
+     */
+    static geode::Result<Loaded> read(const std::filesystem::path& path, uint64_t sourceHash);
+};
+
+}  // namespace jukebox::index
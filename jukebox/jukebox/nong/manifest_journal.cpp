@@ -0,0 +1,167 @@
+#include <jukebox/nong/manifest_journal.hpp>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <Geode/utils/general.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Line layout: "<crc32 as 8 hex digits> <op> <song ID> <json>\n"
+// The checksum covers everything between the first space and the newline.
+constexpr std::array<std::string_view, 7> OP_NAMES = {"full",       "add",        "update",  "delete",
+                                                      "delete-all", "set-active", "metadata"};
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+uint32_t crc32(const std::string_view data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (const char c : data) {
+        crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+std::optional<jukebox::ManifestOp> parseOp(const std::string_view name) {
+    for (size_t i = 0; i < OP_NAMES.size(); i++) {
+        if (OP_NAMES[i] == name) {
+            return static_cast<jukebox::ManifestOp>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+// Splits the next space separated field off the front of line
+std::optional<std::string_view> nextField(std::string_view& line) {
+    const size_t space = line.find(' ');
+    if (space == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    std::string_view field = line.substr(0, space);
+    line.remove_prefix(space + 1);
+    return field;
+}
+
+std::optional<jukebox::ManifestJournal::Record> parseRecord(std::string_view line) {
+    const std::optional<std::string_view> checksum = nextField(line);
+    if (!checksum || checksum->size() != 8) {
+        return std::nullopt;
+    }
+
+    Result<uint32_t> expected = geode::utils::numFromString<uint32_t>(checksum.value(), 16);
+    if (expected.isErr() || expected.unwrap() != crc32(line)) {
+        return std::nullopt;
+    }
+
+    const std::optional<std::string_view> opName = nextField(line);
+    const std::optional<std::string_view> songID = nextField(line);
+    if (!opName || !songID) {
+        return std::nullopt;
+    }
+
+    const std::optional<jukebox::ManifestOp> op = parseOp(opName.value());
+    Result<int> id = geode::utils::numFromString<int>(songID.value());
+    if (!op || id.isErr()) {
+        return std::nullopt;
+    }
+
+    return jukebox::ManifestJournal::Record{op.value(), id.unwrap(), std::string(line)};
+}
+
+}  // namespace
+
+namespace jukebox {
+
+std::vector<ManifestJournal::Record> ManifestJournal::read(const std::filesystem::path& path) {
+    std::vector<Record> records;
+
+    std::ifstream input(path, std::ios_base::in | std::ios_base::binary);
+    if (!input.is_open()) {
+        return records;
+    }
+
+    const std::string contents{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    std::string_view remaining = contents;
+
+    while (!remaining.empty()) {
+        const size_t end = remaining.find('\n');
+        if (end == std::string_view::npos) {
+            // The last write never finished
+            break;
+        }
+
+        std::optional<Record> record = parseRecord(remaining.substr(0, end));
+        if (!record) {
+            break;
+        }
+
+        records.push_back(std::move(record).value());
+        remaining.remove_prefix(end + 1);
+    }
+
+    return records;
+}
+
+std::string ManifestJournal::format(const ManifestOp op, const int songID, const std::string_view payload) {
+    // Serialized JSON has no raw newlines, so it can't break the line format
+    const std::string body = fmt::format("{} {} {}", OP_NAMES[static_cast<size_t>(op)], songID, payload);
+    return fmt::format("{:08x} {}\n", crc32(body), body);
+}
+
+Result<> ManifestJournal::append(const std::string_view line) {
+    if (!m_stream.is_open()) {
+        m_stream.open(m_path, std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+        if (!m_stream.is_open()) {
+            return Err("Couldn't open file: {}", m_path);
+        }
+    }
+
+    m_stream.write(line.data(), static_cast<std::streamsize>(line.size()));
+    m_stream.flush();
+
+    if (m_stream.fail()) {
+        m_stream.close();
+        m_stream.clear();
+        return Err("Couldn't append to {}", m_path.filename());
+    }
+
+    return Ok();
+}
+
+Result<> ManifestJournal::truncate() {
+    m_stream.close();
+    m_stream.clear();
+
+    m_stream.open(m_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!m_stream.is_open()) {
+        return Err("Couldn't open file: {}", m_path);
+    }
+
+    return Ok();
+}
+
+}  // namespace jukebox
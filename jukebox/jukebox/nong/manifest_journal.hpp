@@ -0,0 +1,88 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+namespace jukebox {
+
+/**
+ * What kind of change a journal record describes. Apart from Full, records
+ * only carry what changed, and are replayed over the last Full record of
+ * their song ID.
+ */
+enum class ManifestOp {
+    // The whole song ID
+    Full,
+    // A song was added, or replaced by one with the same unique ID
+    Add,
+    // A song changed in place, like its audio being removed
+    Update,
+    Delete,
+    // Every song but the default one was removed
+    DeleteAll,
+    SetActive,
+    // The default song was renamed
+    Metadata,
+};
+
+/**
+ * Append-only log of manifest changes.
+ *
+ * Every change to a song ID appends one line describing it, prefixed with a
+ * CRC32 of the line. The first record of a song ID after the journal was
+ * emptied holds the whole song ID, later ones only what changed. Per-ID files
+ * are only written in the background, so on startup the journal is replayed
+ * over them. A record that was cut off by a crash fails its checksum and is
+ * ignored, along with anything after it.
+ *
+ * Records are formatted on the main thread, and written by the manifest
+ * writer on its own thread.
+ */
+class ManifestJournal final {
+public:
+    struct Record {
+        ManifestOp op;
+        int songID;
+        // JSON, see NongManager::saveNongs
+        std::string payload;
+    };
+
+private:
+    std::filesystem::path m_path;
+    std::ofstream m_stream;
+
+public:
+    explicit ManifestJournal(std::filesystem::path path) : m_path(std::move(path)) {}
+
+    ManifestJournal(const ManifestJournal&) = delete;
+    ManifestJournal& operator=(const ManifestJournal&) = delete;
+
+    /**
+     * Reads every intact record from a journal, in the order they were written
+     */
+    static std::vector<Record> read(const std::filesystem::path& path);
+
+    /**
+     * Formats a record as a line to append
+     */
+    static std::string format(ManifestOp op, int songID, std::string_view payload);
+
+    /**
+     * Appends a formatted record and flushes it to the OS before returning
+     */
+    geode::Result<> append(std::string_view line);
+
+    /**
+     * Empties the journal. Only call this once every recorded change has made
+     * it into the per-ID files.
+     */
+    geode::Result<> truncate();
+};
+
+}  // namespace jukebox
@@ -0,0 +1,174 @@
+#include <jukebox/nong/manifest_snapshot.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <matjson.hpp>
+
+#include <jukebox/nong/nong.hpp>
+#include <jukebox/nong/nong_serialize.hpp>
+#include <jukebox/utils/mapped_file.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Layout, all little endian:
+//   header: char[4] magic, u32 version, u32 count, u32 reserved
+//   entry:  i32 song ID, u32 length, u64 offset from the start of the file
+constexpr std::array<char, 4> MAGIC = {'J', 'B', 'M', 'S'};
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t ENTRY_SIZE = 16;
+
+template <typename T>
+T readAt(const uint8_t* data, size_t offset) {
+    T ret;
+    std::memcpy(&ret, data + offset, sizeof(T));
+    return ret;
+}
+
+template <typename T>
+void writeTo(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+namespace jukebox {
+
+Result<std::unique_ptr<ManifestSnapshot>> ManifestSnapshot::open(const std::filesystem::path& path) {
+    GEODE_UNWRAP_INTO(MappedFile file, MappedFile::open(path));
+
+    const uint8_t* data = file.data().data();
+
+    if (file.size() < HEADER_SIZE || std::memcmp(data, MAGIC.data(), MAGIC.size()) != 0) {
+        return Err("{} is not a manifest snapshot", path.filename());
+    }
+
+    if (const auto version = readAt<uint32_t>(data, 4); version != s_version) {
+        return Err("Unsupported manifest snapshot version {}", version);
+    }
+
+    const auto count = readAt<uint32_t>(data, 8);
+    if (HEADER_SIZE + static_cast<uint64_t>(count) * ENTRY_SIZE > file.size()) {
+        return Err("Manifest snapshot is truncated");
+    }
+
+    return Ok(std::unique_ptr<ManifestSnapshot>(new ManifestSnapshot(std::move(file), count)));
+}
+
+Result<> ManifestSnapshot::write(const std::filesystem::path& path, const std::map<int, std::string>& entries) {
+    std::ofstream out(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!out.is_open()) {
+        return Err("Couldn't open file: {}", path);
+    }
+
+    out.write(MAGIC.data(), MAGIC.size());
+    writeTo<uint32_t>(out, s_version);
+    writeTo<uint32_t>(out, static_cast<uint32_t>(entries.size()));
+    writeTo<uint32_t>(out, 0);
+
+    // std::map keeps the entries sorted by song ID, which lookups rely on
+    uint64_t offset = HEADER_SIZE + entries.size() * ENTRY_SIZE;
+    for (const auto& [id, json] : entries) {
+        writeTo<int32_t>(out, id);
+        writeTo<uint32_t>(out, static_cast<uint32_t>(json.size()));
+        writeTo<uint64_t>(out, offset);
+        offset += json.size();
+    }
+
+    for (const auto& [id, json] : entries) {
+        out.write(json.data(), static_cast<std::streamsize>(json.size()));
+    }
+
+    out.close();
+    if (out.fail()) {
+        return Err("Failed to write manifest snapshot to {}", path);
+    }
+
+    return Ok();
+}
+
+int ManifestSnapshot::songIDAt(size_t index) const {
+    return readAt<int32_t>(m_file.data().data(), HEADER_SIZE + index * ENTRY_SIZE);
+}
+
+std::optional<size_t> ManifestSnapshot::find(int songID) const {
+    size_t low = 0;
+    size_t high = m_count;
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const int id = this->songIDAt(mid);
+
+        if (id == songID) {
+            return mid;
+        }
+
+        if (id < songID) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::vector<int> ManifestSnapshot::songIDs() const {
+    std::vector<int> ret;
+    ret.reserve(m_count);
+    for (size_t i = 0; i < m_count; i++) {
+        ret.push_back(this->songIDAt(i));
+    }
+    return ret;
+}
+
+std::optional<std::string_view> ManifestSnapshot::raw(int songID) const {
+    const std::optional<size_t> index = this->find(songID);
+    if (!index) {
+        return std::nullopt;
+    }
+
+    const uint8_t* data = m_file.data().data();
+    const size_t entry = HEADER_SIZE + index.value() * ENTRY_SIZE;
+    const auto length = readAt<uint32_t>(data, entry + 4);
+    const auto offset = readAt<uint64_t>(data, entry + 8);
+
+    if (offset + length > m_file.size()) {
+        return std::nullopt;
+    }
+
+    return std::string_view(reinterpret_cast<const char*>(data + offset), length);
+}
+
+Result<std::unique_ptr<Nongs>> ManifestSnapshot::decode(int songID) const {
+    const std::optional<std::string_view> raw = this->raw(songID);
+    if (!raw) {
+        return Err("Song ID {} is not in the manifest snapshot", songID);
+    }
+
+    GEODE_UNWRAP_OR_ELSE(json, err, matjson::parse(raw.value())) {
+        return Err("Couldn't parse JSON for song ID {}: {}", songID, err.message);
+    }
+
+    GEODE_UNWRAP_INTO(Nongs nongs, matjson::Serialize<Nongs>::fromJson(json, songID).mapErr([](std::string err) {
+        return fmt::format("Failed to parse JSON: {}", err);
+    }));
+
+    return Ok(std::make_unique<Nongs>(std::move(nongs)));
+}
+
+}  // namespace jukebox
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+#include <jukebox/nong/nong.hpp>
+#include <jukebox/utils/mapped_file.hpp>
+
+namespace jukebox {
+
+/**
+ * The whole manifest packed into a single memory mapped file.
+ *
+ * The file starts with a table of (song ID, offset, length) entries sorted by
+ * song ID, followed by the serialized JSON of every song ID. Opening a
+ * snapshot only maps it, song IDs are decoded one by one when asked for.
+ */
+class ManifestSnapshot final {
+private:
+    MappedFile m_file;
+    uint32_t m_count;
+
+    ManifestSnapshot(MappedFile&& file, uint32_t count) : m_file(std::move(file)), m_count(count) {}
+
+    [[nodiscard]] int songIDAt(size_t index) const;
+    [[nodiscard]] std::optional<size_t> find(int songID) const;
+
+public:
+    static constexpr uint32_t s_version = 1;
+
+    static geode::Result<std::unique_ptr<ManifestSnapshot>> open(const std::filesystem::path& path);
+    /**
+     * Writes a snapshot to the given path
+     *
+     * @param path where to write the snapshot
+     * @param entries serialized JSON for every song ID
+     */
+    static geode::Result<> write(const std::filesystem::path& path, const std::map<int, std::string>& entries);
+
+    [[nodiscard]] bool contains(int songID) const { return this->find(songID).has_value(); }
+    [[nodiscard]] size_t size() const { return m_count; }
+    [[nodiscard]] std::vector<int> songIDs() const;
+
+    /**
+     * Gets the stored JSON for a song ID, without parsing it
+     */
+    [[nodiscard]] std::optional<std::string_view> raw(int songID) const;
+    geode::Result<std::unique_ptr<Nongs>> decode(int songID) const;
+};
+
+}  // namespace jukebox
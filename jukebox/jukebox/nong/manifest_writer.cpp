@@ -0,0 +1,189 @@
+#include <jukebox/nong/manifest_writer.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Geode/loader/Loader.hpp>
+#include <Geode/loader/Log.hpp>
+
+#include <jukebox/nong/manifest_journal.hpp>
+#include <jukebox/utils/file.hpp>
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+void ManifestWriter::start() {
+    if (!m_thread.joinable()) {
+        m_thread = std::thread([this] { this->run(); });
+    }
+}
+
+void ManifestWriter::schedule(std::function<void()> collect) {
+    std::lock_guard lock(m_mutex);
+    this->start();
+
+    if (m_armed) {
+        return;
+    }
+
+    m_collect = std::move(collect);
+    m_armed = true;
+    m_deadline = std::chrono::steady_clock::now() + s_window;
+    m_wake.notify_all();
+}
+
+void ManifestWriter::enqueue(Batch&& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    this->start();
+
+    for (auto& [path, contents] : batch) {
+        m_pending.insert_or_assign(path, std::move(contents));
+    }
+
+    m_wake.notify_all();
+}
+
+void ManifestWriter::attachJournal(std::unique_ptr<ManifestJournal> journal) {
+    std::lock_guard lock(m_mutex);
+    m_journal = std::move(journal);
+}
+
+void ManifestWriter::journal(std::string record) {
+    std::lock_guard lock(m_mutex);
+    this->start();
+
+    m_records.push_back(std::move(record));
+    m_wake.notify_all();
+}
+
+void ManifestWriter::truncateJournal() {
+    std::lock_guard lock(m_mutex);
+    this->start();
+
+    m_coveredRecords = m_records.size();
+    m_truncateJournal = true;
+    m_wake.notify_all();
+}
+
+void ManifestWriter::flush() {
+    std::unique_lock lock(m_mutex);
+
+    if (!m_thread.joinable()) {
+        // Nothing was ever queued
+        return;
+    }
+
+    // Give files that failed before one more try now
+    m_retryAt = {};
+    m_failed = false;
+    m_wake.notify_all();
+    m_idle.wait(lock, [this] { return (!this->hasWork() && !m_writing) || m_failed; });
+}
+
+void ManifestWriter::run() {
+    std::unique_lock lock(m_mutex);
+
+    while (true) {
+        if (m_armed) {
+            // Let changes pile up until the window is over, so bursts end up
+            // as one write. Queued files are written in the meantime without
+            // ending the window early.
+            if (!m_wake.wait_until(lock, m_deadline, [this] { return this->canWrite(); })) {
+                m_armed = false;
+                geode::queueInMainThread(std::move(m_collect));
+                m_collect = nullptr;
+            }
+        } else if (this->hasWork()) {
+            // Waiting to retry files that couldn't be written
+            m_wake.wait_until(lock, m_retryAt, [this] { return m_armed || this->canWrite(); });
+        } else {
+            m_wake.wait(lock, [this] { return m_armed || this->hasWork(); });
+        }
+
+        if (!this->canWrite()) {
+            continue;
+        }
+
+        Batch batch = std::exchange(m_pending, {});
+        std::vector<std::string> records = std::exchange(m_records, {});
+        const bool truncate = std::exchange(m_truncateJournal, false);
+        const size_t covered = std::exchange(m_coveredRecords, 0);
+        ManifestJournal* journal = m_journal.get();
+        m_writing = true;
+        lock.unlock();
+
+        const bool written = write(batch);
+
+        // The journal may only be emptied once everything it holds is in the
+        // files. Otherwise it's kept, and the records the files were meant to
+        // cover go in it too.
+        if (journal) {
+            size_t first = 0;
+            if (truncate && written) {
+                if (GEODE_UNWRAP_IF_ERR(err, journal->truncate())) {
+                    log::error("Failed to compact manifest journal: {}", err);
+                }
+                first = covered;
+            }
+
+            for (size_t i = first; i < records.size(); i++) {
+                if (GEODE_UNWRAP_IF_ERR(err, journal->append(records[i]))) {
+                    log::error("Failed to append to manifest journal: {}", err);
+                }
+            }
+        }
+
+        lock.lock();
+        m_writing = false;
+        m_failed = !written;
+
+        if (!written) {
+            // Files queued meanwhile are newer
+            for (auto& [path, contents] : batch) {
+                m_pending.try_emplace(path, std::move(contents));
+            }
+            m_truncateJournal = m_truncateJournal || truncate;
+            m_retryAt = std::chrono::steady_clock::now() + s_retryDelay;
+        }
+
+        m_idle.notify_all();
+    }
+}
+
+bool ManifestWriter::write(Batch& batch) {
+    std::erase_if(batch, [](const auto& entry) {
+        const auto& [path, contents] = entry;
+
+        if (!contents) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            if (ec && ec != std::errc::no_such_file_or_directory) {
+                log::error("Failed to remove {}: {}", path.filename(), ec.message());
+                return false;
+            }
+            return true;
+        }
+
+        if (GEODE_UNWRAP_IF_ERR(err, utils::file::writeStringAtomic(path, contents.value()))) {
+            log::error("Failed to write {}: {}", path.filename(), err);
+            return false;
+        }
+        return true;
+    });
+
+    return batch.empty();
+}
+
+}  // namespace jukebox
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <jukebox/nong/manifest_journal.hpp>
+
+namespace jukebox {
+
+/**
+ * Writes manifest files on a background thread.
+ *
+ * Saving is two-step: callers mark what changed, and once a short window has
+ * passed since the first change, the collect callback runs on the main thread
+ * to serialize everything that changed in one go. The serialized
+ * files are then written atomically on the writer thread.
+ *
+ * The writer also owns the manifest journal, so appending records and
+ * emptying it never blocks the main thread.
+ */
+class ManifestWriter final {
+public:
+    // path -> new contents, or nullopt if the file should be removed
+    using Batch = std::map<std::filesystem::path, std::optional<std::string>>;
+
+private:
+    static constexpr std::chrono::milliseconds s_window{750};
+    // Wait before writing files that failed to be written again
+    static constexpr std::chrono::seconds s_retryDelay{5};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::thread m_thread;
+
+    Batch m_pending;
+    std::function<void()> m_collect;
+    bool m_armed = false;
+    // When the armed collect runs
+    std::chrono::steady_clock::time_point m_deadline;
+    bool m_writing = false;
+    // Files failed to be written, they're queued again after s_retryDelay
+    std::chrono::steady_clock::time_point m_retryAt;
+    bool m_failed = false;
+
+    std::unique_ptr<ManifestJournal> m_journal;
+    // Formatted records that haven't been appended yet
+    std::vector<std::string> m_records;
+    bool m_truncateJournal = false;
+    // How many of m_records the files queued for the truncation cover. They
+    // are only appended if the truncation has to wait for a retry.
+    size_t m_coveredRecords = 0;
+
+    ManifestWriter() = default;
+
+    void start();
+    void run();
+    [[nodiscard]] bool hasWork() const { return !m_pending.empty() || !m_records.empty() || m_truncateJournal; }
+    [[nodiscard]] bool canWrite() const {
+        return this->hasWork() && std::chrono::steady_clock::now() >= m_retryAt;
+    }
+    /**
+     * Writes a batch, leaving the files that couldn't be written in it
+     *
+     * @return whether every file was written
+     */
+    static bool write(Batch& batch);
+
+public:
+    ManifestWriter(const ManifestWriter&) = delete;
+    ManifestWriter(ManifestWriter&&) = delete;
+
+    ManifestWriter& operator=(const ManifestWriter&) = delete;
+    ManifestWriter& operator=(ManifestWriter&&) = delete;
+
+    /**
+     * Runs collect on the main thread after the coalescing window. Calls made
+     * while a collect is already scheduled are merged into that one.
+     */
+    void schedule(std::function<void()> collect);
+
+    /**
+     * Queues files to be written. Newer contents for the same path replace
+     * queued ones that haven't been written yet.
+     */
+    void enqueue(Batch&& batch);
+
+    /**
+     * Sets the journal records get appended to, once on startup. Records
+     * queued before that are dropped.
+     */
+    void attachJournal(std::unique_ptr<ManifestJournal> journal);
+
+    /**
+     * Queues a record formatted with ManifestJournal::format to be appended
+     */
+    void journal(std::string record);
+
+    /**
+     * Empties the journal once the files queued so far are written. Records
+     * queued before this call are dropped, so they must all be covered by
+     * those files. If any of the files can't be written, the journal is kept
+     * along with those records until they are.
+     */
+    void truncateJournal();
+
+    /**
+     * Blocks until every queued file and record has been written, or until
+     * writing a file failed. The journal still has those changes then.
+     */
+    void flush();
+
+    static ManifestWriter& get() {
+        // Intentionally leaked, the writer thread may outlive static destructors
+        static ManifestWriter* instance = new ManifestWriter();
+        return *instance;
+    }
+};
+
+}  // namespace jukebox
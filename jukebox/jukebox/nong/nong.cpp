@@ -1,10 +1,11 @@
 #include <jukebox/nong/nong.hpp>
 
+#include <cstddef>
 #include <filesystem>
-#include <fstream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <utility>
 #include <vector>
@@ -24,6 +25,8 @@
 #include <jukebox/managers/nong_manager.hpp>
 #include <jukebox/nong/index.hpp>
 #include <jukebox/nong/nong_serialize.hpp>
+#include <jukebox/nong/song_slots.hpp>
+#include <jukebox/utils/file.hpp>
 #include <jukebox/utils/random_string.hpp>
 
 using namespace geode::prelude;
@@ -123,14 +126,15 @@ public:
     [[nodiscard]] std::optional<std::filesystem::path> path() const { return m_path; }
     [[nodiscard]] std::string youtubeID() const { return m_youtubeID; }
     [[nodiscard]] std::optional<std::string> indexID() const { return m_indexID; }
-    Future<Result<ByteVector>> startDownload() const {
+    Future<Result<>> startDownload(std::filesystem::path destination) const {
         if (std::error_code ec; m_path.has_value() && std::filesystem::exists(m_path.value(), ec)) {
             co_return Err("Song already is downloaded");
         }
 
-        co_return co_await download::startYoutubeDownload(m_youtubeID);
+        co_return co_await download::startYoutubeDownload(m_youtubeID, std::move(destination));
     }
     void setPath(std::filesystem::path&& p) { m_path = p; }
+    void clearPath() { m_path = std::nullopt; }
 };
 
 YTSong::YTSong(SongMetadata&& metadata, std::string youtubeID, std::optional<std::string> indexID,
@@ -165,8 +169,11 @@ void YTSong::setIndexID(const std::string& id) { m_impl->m_indexID = id; }
 
 std::optional<std::filesystem::path> YTSong::path() const { return m_impl->path(); }
 void YTSong::setPath(std::filesystem::path p) { m_impl->setPath(std::move(p)); }
+void YTSong::clearPath() { m_impl->clearPath(); }
 
-Future<Result<ByteVector>> YTSong::startDownload() const { return m_impl->startDownload(); }
+Future<Result<>> YTSong::startDownload(std::filesystem::path destination) const {
+    return m_impl->startDownload(std::move(destination));
+}
 
 class HostedSong::Impl {
 private:
@@ -201,14 +208,16 @@ public:
     [[nodiscard]] std::string url() const noexcept { return m_url; }
     [[nodiscard]] std::optional<std::string> indexID() const noexcept { return m_indexID; }
     [[nodiscard]] std::optional<std::filesystem::path> path() const noexcept { return m_path; }
-    Future<Result<ByteVector>> startDownload() const {
+    Future<Result<>> startDownload(std::filesystem::path destination) const {
         if (std::error_code ec; m_path.has_value() && std::filesystem::exists(m_path.value(), ec)) {
             co_return Err("Song already is downloaded");
         }
 
-        co_return co_await download::startHostedDownload(m_url);
+        ARC_CO_UNWRAP(co_await download::startHostedDownload(m_url, std::move(destination)));
+        co_return Ok();
     }
     void setPath(std::filesystem::path&& p) { m_path = p; }
+    void clearPath() { m_path = std::nullopt; }
 };
 
 HostedSong::HostedSong(SongMetadata&& metadata, std::string url, std::optional<std::string> indexID,
@@ -235,8 +244,11 @@ std::optional<std::string> HostedSong::indexID() const { return m_impl->indexID(
 void HostedSong::setIndexID(const std::string& id) { m_impl->m_indexID = id; }
 std::optional<std::filesystem::path> HostedSong::path() const { return m_impl->path(); }
 void HostedSong::setPath(std::filesystem::path p) { m_impl->setPath(std::move(p)); }
+void HostedSong::clearPath() { m_impl->clearPath(); }
 
-Future<Result<ByteVector>> HostedSong::startDownload() const { return m_impl->startDownload(); }
+Future<Result<>> HostedSong::startDownload(std::filesystem::path destination) const {
+    return m_impl->startDownload(std::move(destination));
+}
 
 HostedSong::HostedSong(HostedSong&& other) noexcept = default;
 HostedSong& HostedSong::operator=(HostedSong&& other) noexcept = default;
@@ -255,14 +267,58 @@ private:
 
     std::vector<IndexSongMetadata*> m_indexSongs;
 
+    struct Slot {
+        NongType type;
+        size_t index;
+    };
+
+    // uniqueID -> where the song sits in its list, lists in NongType order.
+    // The lists can also be filled through locals() and friends, which the
+    // slots notice by themselves.
+    mutable SongSlots m_slots;
+
+public:
+    // For SongSlots
+    [[nodiscard]] size_t listSize(const size_t list) const {
+        switch (static_cast<NongType>(list)) {
+            case NongType::LOCAL:
+                return m_locals.size();
+            case NongType::YOUTUBE:
+                return m_youtube.size();
+            case NongType::HOSTED:
+                return m_hosted.size();
+        }
+        return 0;
+    }
+
+    [[nodiscard]] std::string_view idAt(const size_t list, const size_t index) const {
+        return this->songAt(Slot{static_cast<NongType>(list), index})->metadata()->uniqueID;
+    }
+
+private:
+    [[nodiscard]] Song* songAt(const Slot slot) const {
+        switch (slot.type) {
+            case NongType::LOCAL:
+                return slot.index < m_locals.size() ? m_locals[slot.index].get() : nullptr;
+            case NongType::YOUTUBE:
+                return slot.index < m_youtube.size() ? m_youtube[slot.index].get() : nullptr;
+            case NongType::HOSTED:
+                return slot.index < m_hosted.size() ? m_hosted[slot.index].get() : nullptr;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] std::optional<Slot> slotOf(const std::string_view uniqueID) const {
+        return m_slots.find(*this, uniqueID).transform([](const SongSlots::Slot slot) {
+            return Slot{static_cast<NongType>(slot.list), slot.index};
+        });
+    }
+
+    // Must be called once the song using the path is gone from the lists,
+    // otherwise it still counts as a reference to its blob
     void deletePath(const std::optional<std::filesystem::path>& path) {
-        std::error_code ec;
-        if (path.has_value() && std::filesystem::exists(path.value(), ec)) {
-            std::filesystem::remove(path.value(), ec);
-            if (ec) {
-                log::error("Couldn't delete nong. Category: {}, message: {}", ec.category().name(),
-                           ec.category().message(ec.value()));
-            }
+        if (path.has_value()) {
+            NongManager::get().releaseAudio(path.value());
         }
     }
 
@@ -272,11 +328,24 @@ public:
 
     explicit Impl(const int songID) : Impl(songID, std::make_unique<LocalSong>(LocalSong::createUnknown(songID))) {}
 
-    Result<> commit(Nongs* self) {
-        const std::filesystem::path path = NongManager::get().baseManifestPath() / fmt::format("{}.json", m_songID);
+    [[nodiscard]] std::filesystem::path manifestPath() const {
+        return NongManager::get().baseManifestPath() / fmt::format("{}.json", m_songID);
+    }
 
+    std::optional<std::string> serialize(Nongs* self) const {
         // Don't save manifest for songs with no nongs
         if (m_locals.empty() && m_youtube.empty() && m_hosted.empty()) {
+            return std::nullopt;
+        }
+
+        return matjson::Serialize<Nongs>::toJson(*self).dump(matjson::NO_INDENTATION);
+    }
+
+    Result<> commit(Nongs* self) const {
+        const std::filesystem::path path = this->manifestPath();
+        const std::optional<std::string> json = this->serialize(self);
+
+        if (!json) {
             if (std::error_code ec; std::filesystem::exists(path, ec)) {
                 std::filesystem::remove(path, ec);
             }
@@ -284,17 +353,7 @@ public:
             return Ok();
         }
 
-        matjson::Value json = matjson::Serialize<Nongs>::toJson(*self);
-
-        std::ofstream output(path);
-        if (!output.is_open()) {
-            return Err("Couldn't open file: {}", path);
-        }
-
-        output << json.dump(matjson::NO_INDENTATION);
-        output.close();
-
-        return Ok();
+        return utils::file::writeStringAtomic(path, json.value());
     }
 
     Result<> canSetActive(const std::string& uniqueID, const std::filesystem::path& path) const {
@@ -304,7 +363,7 @@ public:
             return Ok();
         }
 
-        if (std::error_code ec; !std::filesystem::exists(path, ec)) {
+        if (!NongManager::get().pathCache().exists(path)) {
             return Err("Song doesn't exist on disk");
         }
 
@@ -312,54 +371,24 @@ public:
     }
 
     Result<> setActive(const std::string& uniqueID, Nongs* self) {
-        if (const std::optional<LocalSong*> song = this->getLocalFromID(uniqueID)) {
-            Result<> res = this->canSetActive(uniqueID, song.value()->path().value());
-            if (res.isErr()) {
-                return res;
-            }
-
-            m_active = song.value();
-
-            if (NongManager::get().initialized()) {
-                event::SongStateChanged().send(event::SongStateChangedData{self});
-            }
-
-            return Ok();
+        const std::optional<Song*> song = this->findSong(uniqueID);
+        if (!song) {
+            return Err("No song found with given path for song ID");
         }
 
-        if (const std::optional<YTSong*> song = this->getYTFromID(uniqueID)) {
-            if (!song.value()->path()) {
-                return Err("Song is not downloaded");
-            }
-            Result<> res = this->canSetActive(uniqueID, song.value()->path().value());
-            if (res.isErr()) {
-                return res;
-            }
-
-            m_active = song.value();
-            if (NongManager::get().initialized()) {
-                event::SongStateChanged().send(event::SongStateChangedData{self});
-            }
-            return Ok();
+        if (!song.value()->path()) {
+            return Err("Song is not downloaded");
         }
-
-        if (const std::optional<HostedSong*> song = this->getHostedFromID(uniqueID)) {
-            if (!song.value()->path()) {
-                return Err("Song is not downloaded");
-            }
-            Result<> res = this->canSetActive(uniqueID, song.value()->path().value());
-            if (res.isErr()) {
-                return res;
-            }
-
-            m_active = song.value();
-            if (NongManager::get().initialized()) {
-                event::SongStateChanged().send(event::SongStateChangedData{self});
-            }
-            return Ok();
+        Result<> res = this->canSetActive(uniqueID, song.value()->path().value());
+        if (res.isErr()) {
+            return res;
         }
 
-        return Err("No song found with given path for song ID");
+        m_active = song.value();
+        if (NongManager::get().shouldSendEvents()) {
+            event::SongStateChanged().send(event::SongStateChangedData{self});
+        }
+        return Ok();
     }
 
     Result<> merge(Nongs&& other) {
@@ -372,35 +401,47 @@ public:
                 continue;
             }
             m_locals.emplace_back(std::make_unique<LocalSong>(*i));
+            m_slots.appended(*this, static_cast<size_t>(NongType::LOCAL));
         }
 
         for (const auto& i : other.youtube()) {
             m_youtube.emplace_back(std::make_unique<YTSong>(*i));
+            m_slots.appended(*this, static_cast<size_t>(NongType::YOUTUBE));
         }
 
         for (const auto& i : other.hosted()) {
             m_hosted.emplace_back(std::make_unique<HostedSong>(*i));
+            m_slots.appended(*this, static_cast<size_t>(NongType::HOSTED));
         }
 
         return Ok();
     }
 
     Result<> deleteAllSongs(Nongs* self) {
+        std::vector<std::optional<std::filesystem::path>> paths;
+        paths.reserve(m_locals.size() + m_youtube.size() + m_hosted.size());
+
         for (std::unique_ptr<LocalSong>& local : m_locals) {
-            this->deletePath(local->path());
+            paths.push_back(local->path());
         }
         m_locals.clear();
 
         for (std::unique_ptr<YTSong>& youtube : m_youtube) {
-            this->deletePath(youtube->path());
+            paths.push_back(youtube->path());
         }
         m_youtube.clear();
 
         for (std::unique_ptr<HostedSong>& hosted : m_hosted) {
-            this->deletePath(hosted->path());
+            paths.push_back(hosted->path());
         }
         m_hosted.clear();
 
+        m_slots.clear();
+
+        for (const std::optional<std::filesystem::path>& path : paths) {
+            this->deletePath(path);
+        }
+
         m_active = m_default.get();
         event::SongStateChanged().send(event::SongStateChangedData{self});
 
@@ -416,46 +457,52 @@ public:
             (void)this->setActive(m_default->metadata()->uniqueID, self);
         }
 
-        for (auto i = m_locals.begin(); i != m_locals.end(); ++i) {
-            if ((*i)->metadata()->uniqueID == uniqueID) {
-                if (audio) {
-                    this->deletePath((*i)->path());
-                }
-                m_locals.erase(i);
-                if (NongManager::get().initialized()) {
-                    event::NongDeleted(m_songID).send(event::NongDeletedData{m_songID, uniqueID});
-                }
-                return Ok();
-            }
+        const std::optional<Slot> slot = this->slotOf(uniqueID);
+        if (!slot) {
+            return Err("No song found with given path for song ID");
         }
 
-        for (auto i = m_youtube.begin(); i != m_youtube.end(); ++i) {
-            if ((*i)->metadata()->uniqueID == uniqueID) {
-                if (audio) {
-                    this->deletePath((*i)->path());
-                }
-                m_youtube.erase(i);
-                if (NongManager::get().initialized()) {
-                    event::NongDeleted(m_songID).send(event::NongDeletedData{m_songID, uniqueID});
-                }
-                return Ok();
-            }
+        const std::optional<std::filesystem::path> path = this->songAt(slot.value())->path();
+        // The caller's ID may be the erased song's own
+        const std::string erasedID = uniqueID;
+        const auto index = static_cast<std::ptrdiff_t>(slot->index);
+        switch (slot->type) {
+            case NongType::LOCAL:
+                m_locals.erase(m_locals.begin() + index);
+                break;
+            case NongType::YOUTUBE:
+                m_youtube.erase(m_youtube.begin() + index);
+                break;
+            case NongType::HOSTED:
+                m_hosted.erase(m_hosted.begin() + index);
+                break;
         }
+        m_slots.erased(*this, static_cast<size_t>(slot->type), slot->index, erasedID);
 
-        for (auto i = m_hosted.begin(); i != m_hosted.end(); ++i) {
-            if ((*i)->metadata()->uniqueID == uniqueID) {
-                if (audio) {
-                    this->deletePath((*i)->path());
-                }
-                m_hosted.erase(i);
-                if (NongManager::get().initialized()) {
-                    event::NongDeleted(m_songID).send(event::NongDeletedData{m_songID, uniqueID});
-                }
-                return Ok();
-            }
+        if (audio) {
+            this->deletePath(path);
+        }
+        if (NongManager::get().shouldSendEvents()) {
+            event::NongDeleted(m_songID).send(event::NongDeletedData{m_songID, erasedID});
         }
+        return Ok();
+    }
 
-        return Err("No song found with given path for song ID");
+    // Clears the song's path before releasing its audio, so it shows as not
+    // downloaded even if other songs keep the blob alive
+    void releaseSongAudio(Song* song) {
+        const std::optional<std::filesystem::path> path = song->path();
+        switch (song->type()) {
+            case NongType::YOUTUBE:
+                static_cast<YTSong*>(song)->clearPath();
+                break;
+            case NongType::HOSTED:
+                static_cast<HostedSong*>(song)->clearPath();
+                break;
+            case NongType::LOCAL:
+                return;
+        }
+        this->deletePath(path);
     }
 
     Result<> deleteSongAudio(const std::string& uniqueID) {
@@ -467,87 +514,30 @@ public:
             m_active = m_default.get();
         }
 
-        for (const auto& m_local : m_locals) {
-            if (m_local->metadata()->uniqueID == uniqueID) {
-                return Err("Cannot delete audio of local songs");
-            }
-        }
-
-        for (const auto& i : m_youtube) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                this->deletePath(i->path());
-                return Ok();
-            }
-        }
-
-        for (const auto& i : m_hosted) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                this->deletePath(i->path());
-                return Ok();
-            }
-        }
-
-        return Err("No song found with given path for song ID");
-    }
-
-    [[nodiscard]] std::optional<LocalSong*> getLocalFromID(const std::string_view uniqueID) const {
-        if (m_default->metadata()->uniqueID == uniqueID) {
-            return m_default.get();
-        }
-
-        for (const std::unique_ptr<LocalSong>& i : m_locals) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
+        const std::optional<Slot> slot = this->slotOf(uniqueID);
+        if (!slot) {
+            return Err("No song found with given path for song ID");
         }
 
-        return std::nullopt;
-    }
-
-    [[nodiscard]] std::optional<YTSong*> getYTFromID(const std::string_view uniqueID) const {
-        for (const std::unique_ptr<YTSong>& i : m_youtube) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
-        }
-
-        return std::nullopt;
-    }
-
-    [[nodiscard]] std::optional<HostedSong*> getHostedFromID(const std::string_view uniqueID) const {
-        for (const std::unique_ptr<HostedSong>& i : m_hosted) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
+        if (slot->type == NongType::LOCAL) {
+            return Err("Cannot delete audio of local songs");
         }
 
-        return std::nullopt;
+        this->releaseSongAudio(this->songAt(slot.value()));
+        return Ok();
     }
 
-    [[nodiscard]] std::optional<Song*> findSong(const std::string& uniqueID) const {
+    [[nodiscard]] std::optional<Song*> findSong(const std::string_view uniqueID) const {
         if (m_default->metadata()->uniqueID == uniqueID) {
             return m_default.get();
         }
 
-        for (const auto& i : m_locals) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
-        }
-
-        for (const auto& i : m_youtube) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
-        }
-
-        for (const auto& i : m_hosted) {
-            if (i->metadata()->uniqueID == uniqueID) {
-                return i.get();
-            }
+        const std::optional<Slot> slot = this->slotOf(uniqueID);
+        if (!slot) {
+            return std::nullopt;
         }
 
-        return std::nullopt;
+        return this->songAt(slot.value());
     }
 
     Result<> replaceSong(const std::string& id, LocalSong&& song, Nongs* self) {
@@ -637,6 +627,7 @@ public:
         auto ptr = std::make_unique<LocalSong>(std::move(song));
         LocalSong* ret = ptr.get();
         m_locals.push_back(std::move(ptr));
+        m_slots.appended(*this, static_cast<size_t>(NongType::LOCAL));
 
         return Ok(ret);
     }
@@ -645,6 +636,7 @@ public:
         auto s = std::make_unique<YTSong>(std::move(song));
         auto ret = s.get();
         m_youtube.push_back(std::move(s));
+        m_slots.appended(*this, static_cast<size_t>(NongType::YOUTUBE));
 
         return Ok(ret);
     }
@@ -661,6 +653,7 @@ public:
         HostedSong* ret = s.get();
 
         m_hosted.push_back(std::move(s));
+        m_slots.appended(*this, static_cast<size_t>(NongType::HOSTED));
 
         return Ok(ret);
     }
@@ -705,6 +698,8 @@ Nongs::Nongs(int songID) : m_impl(std::make_unique<Impl>(songID)) {}
 
 std::optional<Song*> Nongs::findSong(const std::string& uniqueID) const { return m_impl->findSong(uniqueID); }
 Result<> Nongs::commit() { return m_impl->commit(this); }
+std::optional<std::string> Nongs::serialize() { return m_impl->serialize(this); }
+std::filesystem::path Nongs::manifestPath() const { return m_impl->manifestPath(); }
 Result<> Nongs::replaceSong(const std::string& id, LocalSong&& song) {
     return m_impl->replaceSong(id, std::move(song), this);
 }
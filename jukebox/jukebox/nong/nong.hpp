@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -107,7 +108,9 @@ public:
     void setIndexID(const std::string& id) override;
     [[nodiscard]] std::optional<std::filesystem::path> path() const override;
     void setPath(std::filesystem::path p) override;
-    [[nodiscard]] arc::Future<geode::Result<geode::ByteVector>> startDownload() const;
+    // Marks the song as not downloaded
+    void clearPath();
+    [[nodiscard]] arc::Future<geode::Result<>> startDownload(std::filesystem::path destination) const;
 };
 
 class HostedSong final : public Song {
@@ -134,7 +137,9 @@ public:
     void setIndexID(const std::string& id) override;
     [[nodiscard]] std::optional<std::filesystem::path> path() const override;
     void setPath(std::filesystem::path p) override;
-    [[nodiscard]] arc::Future<geode::Result<geode::ByteVector>> startDownload() const;
+    // Marks the song as not downloaded
+    void clearPath();
+    [[nodiscard]] arc::Future<geode::Result<>> startDownload(std::filesystem::path destination) const;
 };
 
 class Nongs final {
@@ -162,7 +167,17 @@ public:
 
     [[nodiscard]] bool isDefaultActive() const;
 
+    /**
+     * Writes the manifest file for this song ID right away. Prefer
+     * NongManager::saveNongs, which batches writes in the background.
+     */
     geode::Result<> commit();
+    /**
+     * Serializes this song ID for its manifest file. Returns nullopt if there
+     * are no nongs worth storing, in which case the file should not exist.
+     */
+    [[nodiscard]] std::optional<std::string> serialize();
+    [[nodiscard]] std::filesystem::path manifestPath() const;
     /**
      * Returns Err if there is no NONG with the given path for the song ID
      * Otherwise, returns ok
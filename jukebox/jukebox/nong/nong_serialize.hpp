@@ -90,7 +90,8 @@ struct matjson::Serialize<jukebox::YTSong> {
                                        err);
                 }));
 
-        if (!value["path"].isString()) {
+        // Songs that aren't downloaded have no path
+        if (value.contains("path") && !value["path"].isString()) {
             return geode::Err(
                 "YouTube song {} is invalid. Reason: invalid path",
                 value.dump(matjson::NO_INDENTATION));
@@ -102,8 +103,10 @@ struct matjson::Serialize<jukebox::YTSong> {
                 value.dump(matjson::NO_INDENTATION));
         }
 
-        GEODE_UNWRAP_INTO(std::filesystem::path path,
-                          value["path"].as<std::filesystem::path>());
+        std::optional<std::filesystem::path> path;
+        if (value.contains("path")) {
+            GEODE_UNWRAP_INTO(path, value["path"].as<std::filesystem::path>());
+        }
 
         return geode::Ok(jukebox::YTSong{
             std::move(metadata), value["youtube_id"].asString().unwrap(),
@@ -119,9 +122,11 @@ struct matjson::Serialize<jukebox::YTSong> {
             matjson::makeObject({{"name", value.metadata()->name},
                                  {"unique_id", value.metadata()->uniqueID},
                                  {"artist", value.metadata()->artist},
-                                 {"path", value.path().value()},
                                  {"offset", value.metadata()->startOffset},
                                  {"youtube_id", value.youtubeID()}});
+        if (value.path().has_value()) {
+            ret["path"] = value.path().value();
+        }
         if (value.indexID().has_value()) {
             ret["index_id"] = value.indexID().value();
         }
@@ -146,7 +151,8 @@ struct matjson::Serialize<jukebox::HostedSong> {
                                        err);
                 }));
 
-        if (!value["path"].isString()) {
+        // Songs that aren't downloaded have no path
+        if (value.contains("path") && !value["path"].isString()) {
             return geode::Err("Hosted song {} is invalid. Reason: invalid path",
                               value.dump(matjson::NO_INDENTATION));
         }
@@ -156,8 +162,10 @@ struct matjson::Serialize<jukebox::HostedSong> {
                               value.dump(matjson::NO_INDENTATION));
         }
 
-        GEODE_UNWRAP_INTO(std::filesystem::path path,
-                          value["path"].as<std::filesystem::path>());
+        std::optional<std::filesystem::path> path;
+        if (value.contains("path")) {
+            GEODE_UNWRAP_INTO(path, value["path"].as<std::filesystem::path>());
+        }
 
         return geode::Ok(jukebox::HostedSong{
             std::move(metadata), value["url"].asString().unwrap(),
@@ -173,9 +181,11 @@ struct matjson::Serialize<jukebox::HostedSong> {
             matjson::makeObject({{"name", value.metadata()->name},
                                  {"unique_id", value.metadata()->uniqueID},
                                  {"artist", value.metadata()->artist},
-                                 {"path", value.path().value()},
                                  {"offset", value.metadata()->startOffset},
                                  {"url", value.url()}});
+        if (value.path().has_value()) {
+            ret["path"] = value.path().value();
+        }
         if (value.indexID().has_value()) {
             ret["index_id"] = value.indexID().value();
         }
@@ -207,9 +217,6 @@ struct matjson::Serialize<jukebox::Nongs> {
 
         matjson::Value youtubes = matjson::Value::array();
         for (std::unique_ptr<jukebox::YTSong>& youtube : value.youtube()) {
-            if (!youtube->path().has_value()) {
-                continue;
-            }
             youtubes.push(
                 matjson::Serialize<jukebox::YTSong>::toJson(*youtube));
         }
@@ -217,9 +224,6 @@ struct matjson::Serialize<jukebox::Nongs> {
 
         matjson::Value hosteds = matjson::Value::array();
         for (std::unique_ptr<jukebox::HostedSong>& hosted : value.hosted()) {
-            if (!hosted->path().has_value()) {
-                continue;
-            }
             hosteds.push(
                 matjson::Serialize<jukebox::HostedSong>::toJson(*hosted));
         }
@@ -0,0 +1,291 @@
+#include <jukebox/nong/song_search.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+#include <jukebox/nong/index.hpp>
+#include <jukebox/utils/file.hpp>
+#include <jukebox/utils/mapped_file.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Layout, all little endian:
+//   header:     char[4] magic, u32 version, u64 source hash, u32 song count,
+//               u32 trigram count, u32 posting count, u32 reserved
+//   trigrams:   u32 per trigram, sorted
+//   offsets:    u32 per trigram plus one, where its songs start in postings
+//   postings:   u32 song positions
+//   song grams: u16 distinct trigrams per song
+constexpr std::array<char, 4> MAGIC = {'J', 'B', 'S', 'S'};
+constexpr size_t HEADER_SIZE = 32;
+
+template <typename T>
+T readAt(const uint8_t* data, size_t offset) {
+    T ret;
+    std::memcpy(&ret, data + offset, sizeof(T));
+    return ret;
+}
+
+template <typename T>
+void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void appendAll(std::string& out, const std::vector<T>& values) {
+    out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+std::vector<T> readAll(const uint8_t* data, size_t offset, size_t count) {
+    std::vector<T> ret(count);
+    if (count > 0) {
+        std::memcpy(ret.data(), data + offset, count * sizeof(T));
+    }
+    return ret;
+}
+
+// Lowercases ASCII, drops characters joining words like "F-777" or "don't",
+// and turns every run of other ASCII characters that aren't letters or digits
+// into a single space. Bytes of non-ASCII UTF-8 characters are kept as they are.
+std::string normalize(const std::string_view text) {
+    std::string ret;
+    ret.reserve(text.size());
+
+    for (const char c : text) {
+        const auto byte = static_cast<uint8_t>(c);
+
+        if (byte >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) {
+            ret.push_back(c);
+        } else if (c >= 'A' && c <= 'Z') {
+            ret.push_back(static_cast<char>(c - 'A' + 'a'));
+        } else if (c == '-' || c == '\'' || c == '.') {
+            continue;
+        } else if (!ret.empty() && ret.back() != ' ') {
+            ret.push_back(' ');
+        }
+    }
+
+    if (!ret.empty() && ret.back() == ' ') {
+        ret.pop_back();
+    }
+
+    return ret;
+}
+
+// Appends the trigrams of every word of normalized text, padded with a space
+// on both sides. If openEnded, the last word isn't padded at the end, so it
+// only has to be a prefix of a word to match.
+void appendGrams(const std::string_view text, const bool openEnded, std::vector<uint32_t>& out) {
+    std::string padded;
+
+    for (size_t start = 0; start < text.size();) {
+        size_t end = text.find(' ', start);
+        const bool last = end == std::string_view::npos;
+        if (last) {
+            end = text.size();
+        }
+
+        padded.assign(1, ' ');
+        padded.append(text.substr(start, end - start));
+        if (!last || !openEnded) {
+            padded.push_back(' ');
+        }
+
+        for (size_t i = 0; i + 3 <= padded.size(); i++) {
+            out.push_back(static_cast<uint32_t>(static_cast<uint8_t>(padded[i])) << 16 |
+                          static_cast<uint32_t>(static_cast<uint8_t>(padded[i + 1])) << 8 |
+                          static_cast<uint32_t>(static_cast<uint8_t>(padded[i + 2])));
+        }
+
+        start = end + 1;
+    }
+}
+
+void sortUnique(std::vector<uint32_t>& values) {
+    std::ranges::sort(values);
+    values.erase(std::ranges::unique(values).begin(), values.end());
+}
+
+}  // namespace
+
+namespace jukebox::index {
+
+SongSearch SongSearch::build(const IndexMetadata& index) {
+    const std::vector<IndexSongMetadata*>& songs = index.m_songs.m_hosted;
+
+    SongSearch ret;
+    ret.m_songGrams.reserve(songs.size());
+
+    // (trigram, song) pairs, sorted below to group songs by trigram
+    std::vector<uint64_t> pairs;
+    std::vector<uint32_t> grams;
+
+    for (size_t i = 0; i < songs.size(); i++) {
+        grams.clear();
+        appendGrams(normalize(songs[i]->name), false, grams);
+        appendGrams(normalize(songs[i]->artist), false, grams);
+        sortUnique(grams);
+
+        ret.m_songGrams.push_back(
+            static_cast<uint16_t>(std::min<size_t>(grams.size(), std::numeric_limits<uint16_t>::max())));
+
+        for (const uint32_t gram : grams) {
+            pairs.push_back(static_cast<uint64_t>(gram) << 32 | i);
+        }
+    }
+
+    std::ranges::sort(pairs);
+
+    ret.m_postings.reserve(pairs.size());
+
+    for (const uint64_t pair : pairs) {
+        const auto gram = static_cast<uint32_t>(pair >> 32);
+
+        if (ret.m_grams.empty() || ret.m_grams.back() != gram) {
+            ret.m_grams.push_back(gram);
+            ret.m_offsets.push_back(static_cast<uint32_t>(ret.m_postings.size()));
+        }
+
+        ret.m_postings.push_back(static_cast<uint32_t>(pair));
+    }
+
+    ret.m_offsets.push_back(static_cast<uint32_t>(ret.m_postings.size()));
+
+    return ret;
+}
+
+Result<SongSearch> SongSearch::read(const std::filesystem::path& path, const uint64_t sourceHash,
+                                    const size_t songCount) {
+    GEODE_UNWRAP_INTO(MappedFile file, MappedFile::open(path));
+
+    const uint8_t* data = file.data().data();
+
+    if (file.size() < HEADER_SIZE || std::memcmp(data, MAGIC.data(), MAGIC.size()) != 0) {
+        return Err("{} is not a song search", path.filename());
+    }
+
+    if (const auto version = readAt<uint32_t>(data, 4); version != s_version) {
+        return Err("Unsupported song search version {}", version);
+    }
+
+    if (readAt<uint64_t>(data, 8) != sourceHash) {
+        return Err("Song search is out of date");
+    }
+
+    if (readAt<uint32_t>(data, 16) != songCount) {
+        return Err("Song search was built for a different amount of songs");
+    }
+
+    const auto gramCount = readAt<uint32_t>(data, 20);
+    const auto postingCount = readAt<uint32_t>(data, 24);
+
+    const uint64_t grams = HEADER_SIZE;
+    const uint64_t offsets = grams + static_cast<uint64_t>(gramCount) * sizeof(uint32_t);
+    const uint64_t postings = offsets + (static_cast<uint64_t>(gramCount) + 1) * sizeof(uint32_t);
+    const uint64_t songGrams = postings + static_cast<uint64_t>(postingCount) * sizeof(uint32_t);
+
+    if (songGrams + songCount * sizeof(uint16_t) != file.size()) {
+        return Err("Song search is truncated");
+    }
+
+    SongSearch ret;
+    ret.m_grams = readAll<uint32_t>(data, grams, gramCount);
+    ret.m_offsets = readAll<uint32_t>(data, offsets, gramCount + 1);
+    ret.m_postings = readAll<uint32_t>(data, postings, postingCount);
+    ret.m_songGrams = readAll<uint16_t>(data, songGrams, songCount);
+
+    if (!std::ranges::is_sorted(ret.m_grams) || !std::ranges::is_sorted(ret.m_offsets) ||
+        ret.m_offsets.front() != 0 || ret.m_offsets.back() != postingCount) {
+        return Err("Song search is corrupted");
+    }
+
+    if (std::ranges::any_of(ret.m_postings, [songCount](const uint32_t song) { return song >= songCount; })) {
+        return Err("Song search entry out of bounds");
+    }
+
+    return Ok(std::move(ret));
+}
+
+Result<> SongSearch::write(const std::filesystem::path& path, const uint64_t sourceHash) const {
+    std::string out;
+    out.reserve(HEADER_SIZE + (m_grams.size() + m_offsets.size() + m_postings.size()) * sizeof(uint32_t) +
+                m_songGrams.size() * sizeof(uint16_t));
+
+    out.append(MAGIC.data(), MAGIC.size());
+    append<uint32_t>(out, s_version);
+    append<uint64_t>(out, sourceHash);
+    append<uint32_t>(out, static_cast<uint32_t>(m_songGrams.size()));
+    append<uint32_t>(out, static_cast<uint32_t>(m_grams.size()));
+    append<uint32_t>(out, static_cast<uint32_t>(m_postings.size()));
+    append<uint32_t>(out, 0);
+
+    appendAll(out, m_grams);
+    appendAll(out, m_offsets);
+    appendAll(out, m_postings);
+    appendAll(out, m_songGrams);
+
+    return utils::file::writeStringAtomic(path, out);
+}
+
+void SongSearch::search(const IndexMetadata& index, const std::string_view query, std::vector<SongMatch>& out) const {
+    const std::vector<IndexSongMetadata*>& songs = index.m_songs.m_hosted;
+    if (songs.size() != this->songCount()) {
+        return;
+    }
+
+    std::vector<uint32_t> grams;
+    appendGrams(normalize(query), true, grams);
+    sortUnique(grams);
+
+    if (grams.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> hits(songs.size(), 0);
+    std::vector<uint32_t> touched;
+
+    for (const uint32_t gram : grams) {
+        const auto it = std::ranges::lower_bound(m_grams, gram);
+        if (it == m_grams.end() || *it != gram) {
+            continue;
+        }
+
+        const auto i = static_cast<size_t>(it - m_grams.begin());
+        for (uint32_t p = m_offsets[i]; p < m_offsets[i + 1]; p++) {
+            if (hits[m_postings[p]]++ == 0) {
+                touched.push_back(m_postings[p]);
+            }
+        }
+    }
+
+    // A typo costs up to three trigrams. Short queries have to match exactly,
+    // or nearly everything would.
+    const size_t typos = grams.size() <= 3 ? 0 : grams.size() <= 7 ? 1 : 2;
+    const size_t required = std::max<size_t>(1, grams.size() - typos * 3);
+
+    for (const uint32_t song : touched) {
+        if (hits[song] < required) {
+            continue;
+        }
+
+        out.push_back(SongMatch{
+            .m_song = songs[song],
+            .m_score = 2.f * static_cast<float>(hits[song]) / static_cast<float>(grams.size() + m_songGrams[song]),
+        });
+    }
+}
+
+}  // namespace jukebox::index
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+#include <jukebox/nong/index.hpp>
+
+namespace jukebox::index {
+
+struct SongMatch {
+    IndexSongMetadata* m_song;
+    // Between 0 and 1, higher is a better match
+    float m_score;
+};
+
+/**
+ * Trigram index over the names and artists of the songs of an index, for
+ * searching songs without knowing their song ID.
+ *
+ * Words are lowercased and padded with a space on both sides before being cut
+ * into trigrams, so a word that's still being typed matches as a prefix. A
+ * song matches if it has most of the trigrams of the query, which lets a typo
+ * or two through, and matches are scored by how much of both the query and
+ * the song they share.
+ *
+ * Songs are referred to by their position in the hosted songs of the index,
+ * so a search is only valid for the index it was built from.
+ */
+class SongSearch final {
+private:
+    // Sorted trigrams, and where their songs start in m_postings
+    std::vector<uint32_t> m_grams;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_postings;
+    // Distinct trigrams of every song
+    std::vector<uint16_t> m_songGrams;
+
+public:
+    static constexpr uint32_t s_version = 1;
+
+    static SongSearch build(const IndexMetadata& index);
+
+    /**
+     * Reads a search written for the index parsed from JSON with the given
+     * hash, which must have the given amount of hosted songs
+     */
+    static geode::Result<SongSearch> read(const std::filesystem::path& path, uint64_t sourceHash, size_t songCount);
+
+    geode::Result<> write(const std::filesystem::path& path, uint64_t sourceHash) const;
+
+    /**
+     * Appends the songs of the index matching the query to out, unsorted
+     */
+    void search(const IndexMetadata& index, std::string_view query, std::vector<SongMatch>& out) const;
+
+    [[nodiscard]] size_t songCount() const { return m_songGrams.size(); }
+};
+
+}  // namespace jukebox::index
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace jukebox {
+
+/**
+ * Index from unique ID to where a song sits in one of the song lists of a
+ * song ID, kept up to date as songs are appended and erased. With duplicate
+ * IDs the first one in list order wins, same as a linear search.
+ *
+ * The lists are passed in as anything with listSize(list) and idAt(list,
+ * index), so this doesn't need to know about songs. They can also be changed
+ * from outside, so the index gets rebuilt when their sizes aren't the ones it
+ * knows of, or when a slot points to the wrong song.
+ */
+class SongSlots final {
+public:
+    static constexpr size_t s_lists = 3;
+
+    struct Slot {
+        size_t list;
+        size_t index;
+    };
+
+private:
+    struct IDHash {
+        using is_transparent = void;
+        size_t operator()(const std::string_view id) const { return std::hash<std::string_view>{}(id); }
+    };
+
+    std::unordered_map<std::string, Slot, IDHash, std::equal_to<>> m_slots;
+    std::array<size_t, s_lists> m_sizes = {};
+
+    template <typename Lists>
+    [[nodiscard]] bool inSync(const Lists& lists) const {
+        for (size_t list = 0; list < s_lists; list++) {
+            if (m_sizes[list] != lists.listSize(list)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Lists>
+    [[nodiscard]] static std::optional<Slot> firstSlot(const Lists& lists, const std::string_view id) {
+        for (size_t list = 0; list < s_lists; list++) {
+            for (size_t i = 0; i < lists.listSize(list); i++) {
+                if (lists.idAt(list, i) == id) {
+                    return Slot{list, i};
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+public:
+    template <typename Lists>
+    void rebuild(const Lists& lists) {
+        m_slots.clear();
+
+        size_t total = 0;
+        for (size_t list = 0; list < s_lists; list++) {
+            m_sizes[list] = lists.listSize(list);
+            total += m_sizes[list];
+        }
+        m_slots.reserve(total);
+
+        for (size_t list = 0; list < s_lists; list++) {
+            for (size_t i = 0; i < m_sizes[list]; i++) {
+                m_slots.try_emplace(std::string(lists.idAt(list, i)), Slot{list, i});
+            }
+        }
+    }
+
+    void clear() {
+        m_slots.clear();
+        m_sizes = {};
+    }
+
+    template <typename Lists>
+    [[nodiscard]] std::optional<Slot> find(const Lists& lists, const std::string_view id) {
+        if (!this->inSync(lists)) {
+            this->rebuild(lists);
+        }
+
+        auto it = m_slots.find(id);
+        if (it == m_slots.end()) {
+            return std::nullopt;
+        }
+
+        // A song's ID or position was changed from outside, start over
+        const Slot slot = it->second;
+        if (slot.index >= lists.listSize(slot.list) || lists.idAt(slot.list, slot.index) != id) {
+            this->rebuild(lists);
+            it = m_slots.find(id);
+            if (it == m_slots.end()) {
+                return std::nullopt;
+            }
+        }
+
+        return it->second;
+    }
+
+    /**
+     * Records the song that was just appended to a list
+     */
+    template <typename Lists>
+    void appended(const Lists& lists, const size_t list) {
+        m_sizes[list]++;
+        if (!this->inSync(lists)) {
+            this->rebuild(lists);
+            return;
+        }
+
+        const size_t index = m_sizes[list] - 1;
+        const auto [it, inserted] = m_slots.try_emplace(std::string(lists.idAt(list, index)), Slot{list, index});
+        // A duplicate in an earlier list comes first
+        if (!inserted && it->second.list > list) {
+            it->second = Slot{list, index};
+        }
+    }
+
+    /**
+     * Records that the song with the given ID was erased from a list. The ID
+     * must not point into the erased song.
+     */
+    template <typename Lists>
+    void erased(const Lists& lists, const size_t list, const size_t index, const std::string_view id) {
+        if (m_sizes[list] == 0) {
+            this->rebuild(lists);
+            return;
+        }
+
+        m_sizes[list]--;
+        if (!this->inSync(lists)) {
+            this->rebuild(lists);
+            return;
+        }
+
+        // Everything after the erased song moved down a slot
+        for (size_t i = index; i < m_sizes[list]; i++) {
+            const auto it = m_slots.find(lists.idAt(list, i));
+            if (it != m_slots.end() && it->second.list == list && it->second.index == i + 1) {
+                it->second.index = i;
+            }
+        }
+
+        const auto it = m_slots.find(id);
+        if (it == m_slots.end() || it->second.list != list || it->second.index != index) {
+            // A later duplicate was erased, the first one is still there
+            return;
+        }
+
+        m_slots.erase(it);
+        if (const std::optional<Slot> duplicate = firstSlot(lists, id)) {
+            m_slots.try_emplace(std::string(id), duplicate.value());
+        }
+    }
+};
+
+}  // namespace jukebox
@@ -16,6 +16,7 @@
 #include <jukebox/events/song_download_finished.hpp>
 #include <jukebox/events/song_state_changed.hpp>
 #include <jukebox/events/start_download.hpp>
+#include <jukebox/managers/download_manager.hpp>
 #include <jukebox/managers/index_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
 #include <jukebox/nong/index.hpp>
@@ -135,9 +136,9 @@ bool NongCell::initLocal() {
                        : false;
     m_isDefault = nongs.value()->defaultSong()->metadata()->uniqueID == m_uniqueID;
     m_isActive = nongs.value()->active()->metadata()->uniqueID == m_uniqueID;
-    m_isDownloaded = songInfo->path().has_value() && std::filesystem::exists(songInfo->path().value());
+    m_isDownloaded = songInfo->path().has_value() && NongManager::get().pathCache().exists(songInfo->path().value());
     m_isDownloadable = songInfo->type() != NongType::LOCAL;
-    m_isDownloading = false;
+    m_isDownloading = DownloadManager::get().isDownloading(m_songID, m_uniqueID);
     m_nongCell->m_showEditButton = !m_isDefault && !songInfo->indexID().has_value();
 
     return true;
@@ -179,7 +180,7 @@ bool NongCell::initIndex() {
     m_isActive = false;
     m_isDownloaded = false;
     m_isDownloadable = true;
-    m_isDownloading = false;
+    m_isDownloading = DownloadManager::get().isDownloading(m_songID, m_uniqueID);
     m_nongCell->m_showEditButton = false;
 
     return true;
@@ -210,7 +211,13 @@ void NongCell::onTrash() { deleteSong(false); }
 
 void NongCell::onDownload() {
     if (m_nongCell->m_isDownloading) {
-        log::warn("Canceling downloads is not currently implemented.");
+        // The cell may be showing another song by the time this is answered
+        createQuickPopup("Cancel download", "Do you want to <cr>cancel</c> downloading this song?", "No", "Yes",
+                         [songID = m_songID, uniqueID = m_uniqueID](FLAlertLayer* alert, bool btn2) {
+                             if (btn2) {
+                                 DownloadManager::get().cancel(songID, uniqueID);
+                             }
+                         });
         return;
     }
     event::StartDownload().send(event::StartDownloadData{m_songID, m_uniqueID});
@@ -343,6 +350,7 @@ NongCell* NongCell::create(int gdSongID, const std::string& uniqueID, const coco
                            std::optional<int> levelID, std::optional<index::IndexSongMetadata*> indexSongMetadataOpt) {
     auto ret = new NongCell();
     if (ret->init(gdSongID, uniqueID, size, levelID, indexSongMetadataOpt)) {
+        ret->autorelease();
         return ret;
     }
 
@@ -350,6 +358,19 @@ NongCell* NongCell::create(int gdSongID, const std::string& uniqueID, const coco
     return nullptr;
 }
 
+bool NongCell::reuse(const std::string& uniqueID, std::optional<index::IndexSongMetadata*> indexSongMetadataOpt) {
+    m_uniqueID = uniqueID;
+    m_indexSongMetadataOpt = indexSongMetadataOpt;
+    m_nongCell->m_downloadProgress = 0.f;
+
+    if (!(this->isIndex() ? this->initIndex() : this->initLocal())) {
+        return false;
+    }
+
+    this->build();
+    return true;
+}
+
 bool NongCell::isIndex() { return m_indexSongMetadataOpt.has_value(); }
 
 }  // namespace jukebox
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <optional>
+#include <string>
 
 #include <Geode/cocos/base_nodes/CCNode.h>
 #include <Geode/loader/Event.hpp>
@@ -64,6 +65,14 @@ protected:
     bool isIndex();
 
 public:
+    [[nodiscard]] int songID() const { return m_songID; }
+
+    /**
+     * Points the cell to another song of the same song ID, so lists can reuse
+     * cells instead of creating new ones
+     */
+    bool reuse(const std::string& uniqueID, std::optional<index::IndexSongMetadata*> indexSongMetadataOpt);
+
     static NongCell* create(int gdSongID, const std::string& uniqueID, const cocos2d::CCSize& size,
                             std::optional<int> levelID, std::optional<index::IndexSongMetadata*> indexSongMetadataOpt);
 };
@@ -1,9 +1,21 @@
 #include <jukebox/ui/list/nong_list.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <GUI/CCControlExtension/CCScale9Sprite.h>
 #include <Geode/cocos/base_nodes/CCNode.h>
@@ -21,16 +33,133 @@
 
 #include <jukebox/events/nong_deleted.hpp>
 #include <jukebox/events/song_download_finished.hpp>
+#include <jukebox/managers/index_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
 #include <jukebox/nong/index.hpp>
 #include <jukebox/nong/nong.hpp>
+#include <jukebox/nong/song_search.hpp>
 #include <jukebox/ui/list/nong_cell.hpp>
 #include <jukebox/ui/list/song_cell.hpp>
+#include <jukebox/utils/hash.hpp>
 
 using namespace geode::prelude;
 
 namespace jukebox {
 
+namespace {
+
+// Sort keys are worked out once per song, comparisons only compare them.
+// Lower sorts first: verified, then downloaded, then by source, then by name.
+struct RankedSong {
+    int m_unverified;
+    int m_notDownloaded;
+    int m_source;
+    std::string_view m_name;
+    Song* m_song;
+
+    [[nodiscard]] auto key() const { return std::tie(m_unverified, m_notDownloaded, m_source, m_name); }
+
+    static RankedSong rank(Song* song, const std::unordered_set<std::string_view>& verified) {
+        int source = 3;
+        switch (song->type()) {
+            case NongType::LOCAL:
+                source = 0;
+                break;
+            case NongType::HOSTED:
+                source = 1;
+                break;
+            case NongType::YOUTUBE:
+                source = 2;
+                break;
+        }
+
+        const std::optional<std::filesystem::path> path = song->path();
+        const bool downloaded = path.has_value() && NongManager::get().pathCache().exists(path.value());
+
+        return RankedSong{
+            .m_unverified = verified.contains(song->metadata()->uniqueID) ? 0 : 1,
+            .m_notDownloaded = downloaded ? 0 : 1,
+            .m_source = source,
+            .m_name = song->metadata()->name,
+            .m_song = song,
+        };
+    }
+};
+
+// Position of each index in the "indexes" setting, by url
+std::unordered_map<std::string, size_t> indexOrder() {
+    const std::vector<index::IndexSource> indexes = IndexManager::get().getIndexes().unwrapOrDefault();
+
+    std::unordered_map<std::string, size_t> order;
+    order.reserve(indexes.size());
+    for (size_t i = 0; i < indexes.size(); i++) {
+        order.try_emplace(indexes[i].m_url, i);
+    }
+    return order;
+}
+
+struct RankedIndexSong {
+    int m_unverified;
+    // Songs of indexes listed first in the settings go first
+    size_t m_index;
+    std::string_view m_name;
+    index::IndexSongMetadata* m_song;
+
+    [[nodiscard]] auto key() const { return std::tie(m_unverified, m_index, m_name); }
+
+    static RankedIndexSong rank(index::IndexSongMetadata* song, const std::optional<int> levelID,
+                                const std::unordered_map<std::string, size_t>& order) {
+        const bool verified = levelID.has_value() && std::ranges::find(song->verifiedLevelIDs, levelID.value()) !=
+                                                         song->verifiedLevelIDs.end();
+
+        const auto position = order.find(song->parentID->m_url);
+
+        return RankedIndexSong{
+            .m_unverified = verified ? 0 : 1,
+            .m_index = position != order.end() ? position->second : order.size(),
+            .m_name = song->name,
+            .m_song = song,
+        };
+    }
+};
+
+uint64_t indexSongKey(const NongType type, const std::string_view indexID, const std::string_view uniqueID) {
+    return fnv1a64(indexID) ^ (fnv1a64(uniqueID) * 0x9e3779b97f4a7c15ull) ^ static_cast<uint64_t>(type);
+}
+
+// Whether the index song was downloaded or added already. Keys may collide,
+// so matches are compared for real.
+bool isStored(const index::IndexSongMetadata* song, const std::unordered_multimap<uint64_t, Song*>& stored) {
+    NongType type;
+    if (song->ytId.has_value()) {
+        type = NongType::YOUTUBE;
+    } else if (song->url.has_value()) {
+        type = NongType::HOSTED;
+    } else {
+        return false;
+    }
+
+    const auto [begin, end] = stored.equal_range(indexSongKey(type, song->parentID->m_id, song->uniqueID));
+    return std::any_of(begin, end, [song, type](const auto& entry) {
+        const Song* match = entry.second;
+        return match->type() == type && match->metadata()->uniqueID == song->uniqueID &&
+               match->indexID() == song->parentID->m_id;
+    });
+}
+
+// Whether the index song is stored for a song ID already
+bool isStoredFor(const index::IndexSongMetadata* song, const int songID) {
+    const std::optional<Nongs*> nongs = NongManager::get().getNongs(songID);
+    if (!nongs.has_value()) {
+        return false;
+    }
+
+    const std::optional<Song*> stored = nongs.value()->findSong(std::string(song->uniqueID));
+    return stored.has_value() && stored.value()->indexID() == song->parentID->m_id;
+}
+
+}  // namespace
+
 bool NongList::init(std::vector<int> songIds, const CCSize& size, const std::optional<int> levelID,
                     std::function<void(std::optional<int>)> onListTypeChange) {
     if (!CCNode::init()) {
@@ -77,13 +206,8 @@ bool NongList::init(std::vector<int> songIds, const CCSize& size, const std::opt
     menu->setID("back-menu");
     this->addChildAtPosition(menu, Anchor::Left, CCPoint{-10.0f, 0.0f});
 
+    // Rows are positioned by hand, see relayout
     m_list = ScrollLayer::create({size.width, size.height - s_padding});
-    m_list->m_contentLayer->setLayout(SimpleColumnLayout::create()
-                                          ->setMainAxisDirection(AxisDirection::TopToBottom)
-                                          ->setMainAxisAlignment(MainAxisAlignment::Start)
-                                          ->setMainAxisScaling(AxisScaling::Grow)
-                                          ->ignoreInvisibleChildren(false)
-                                          ->setGap(s_padding / 2));
     m_list->setID("list");
 
     this->addChildAtPosition(m_list, Anchor::Center, -m_list->getScaledContentSize() / 2);
@@ -91,36 +215,36 @@ bool NongList::init(std::vector<int> songIds, const CCSize& size, const std::opt
     m_onListTypeChange(m_currentSong);
 
     this->build();
+    this->scheduleUpdate();
     return true;
 }
 
 void NongList::build() {
-    if (m_list->m_contentLayer->getChildrenCount() > 0) {
-        m_list->m_contentLayer->removeAllChildrenWithCleanup(true);
-    }
+    this->clearRows();
 
     if (m_songIds.empty()) {
+        this->relayout();
         return;
     }
 
-    CCSize itemSize = {m_list->getScaledContentSize().width - s_padding, s_itemSize};
-
     if (m_onListTypeChange) {
         m_onListTypeChange(m_currentSong);
     }
 
+    if (!m_query.empty()) {
+        this->addSearchResults();
+        this->relayout();
+        this->scrollToTop();
+        return;
+    }
+
     if (!m_currentSong) {
         for (int id : m_songIds) {
-            std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
-
-            if (!nongs) {
+            if (!NongManager::get().getNongs(id)) {
                 continue;
             }
 
-            Song* active = nongs.value()->active();
-
-            m_list->m_contentLayer->addChild(
-                SongCell::create(id, active->metadata(), itemSize, [this, id]() { this->onSelectSong(id); }));
+            m_rows.push_back(Row{.m_kind = RowKind::Song, .m_songID = id, .m_height = s_itemSize});
         }
     } else {
         // Single item
@@ -128,195 +252,157 @@ void NongList::build() {
 
         std::optional<Nongs*> optNongs = NongManager::get().getNongs(id);
         if (!optNongs) {
+            this->relayout();
             return;
         }
 
         Nongs* nongs = optNongs.value();
         LocalSong* defaultSong = nongs->defaultSong();
         std::string defaultID = defaultSong->metadata()->uniqueID;
-        Song* active = nongs->active();
 
-        m_list->m_contentLayer->addChild(NongCell::create(id, defaultID, itemSize, m_levelID, std::nullopt));
+        m_rows.push_back(
+            Row{.m_kind = RowKind::Nong, .m_id = defaultID, .m_songID = id, .m_uniqueID = defaultID,
+                .m_height = s_itemSize});
 
         CCLabelBMFont* localSongs = CCLabelBMFont::create("Stored nongs", "goldFont.fnt");
         localSongs->setID("local-section");
         localSongs->setScale(0.5f);
-        m_list->m_contentLayer->addChild(localSongs);
-
-        std::unordered_set<std::string> localYt;
-        std::unordered_set<std::string> localHosted;
+        this->addLabelRow(localSongs, m_rows.end());
 
         if (nongs->locals().empty() && nongs->youtube().empty() && nongs->hosted().empty()) {
             this->addNoLocalSongsNotice();
         }
 
-        std::vector<Song*> allLocalNongs;
+        const std::vector<std::string_view> verifiedList =
+            m_levelID.has_value()
+                ? NongManager::get().getVerifiedNongsForLevel(m_levelID.value(), {m_currentSong.value()})
+                : std::vector<std::string_view>{};
+        const std::unordered_set<std::string_view> verifiedNongs(verifiedList.begin(), verifiedList.end());
+
+        std::vector<RankedSong> allLocalNongs;
         allLocalNongs.reserve(nongs->locals().size() + nongs->youtube().size() + nongs->hosted().size());
+        // Index songs that are already stored only show up once, as the stored song
+        std::unordered_multimap<uint64_t, Song*> storedIndexSongs;
+
+        auto addLocal = [&](Song* nong) {
+            allLocalNongs.push_back(RankedSong::rank(nong, verifiedNongs));
+            if (const std::optional<std::string> indexID = nong->indexID()) {
+                storedIndexSongs.emplace(indexSongKey(nong->type(), indexID.value(), nong->metadata()->uniqueID), nong);
+            }
+        };
 
         for (std::unique_ptr<LocalSong>& nong : nongs->locals()) {
-            allLocalNongs.push_back(nong.get());
+            addLocal(nong.get());
         }
-
         for (std::unique_ptr<YTSong>& nong : nongs->youtube()) {
-            allLocalNongs.push_back(nong.get());
-            if (nong->indexID().has_value()) {
-                localYt.insert(fmt::format("{}|{}", nong->indexID().value(), nong->metadata()->uniqueID));
-            }
+            addLocal(nong.get());
         }
-
         for (std::unique_ptr<HostedSong>& nong : nongs->hosted()) {
-            allLocalNongs.push_back(nong.get());
-            if (nong->indexID().has_value()) {
-                localHosted.insert(fmt::format("{}|{}", nong->indexID().value(), nong->metadata()->uniqueID));
-            }
+            addLocal(nong.get());
         }
 
-        std::vector<std::string> verifiedNongs = m_levelID.has_value() ? NongManager::get().getVerifiedNongsForLevel(
-                                                                             m_levelID.value(), {m_currentSong.value()})
-                                                                       : std::vector<std::string>{};
+        std::ranges::sort(allLocalNongs, std::less{}, &RankedSong::key);
 
-        std::ranges::sort(allLocalNongs, [verifiedNongs](Song* a, Song* b) {
-            auto sourcePriority = [](Song* s) {
-                if (typeinfo_cast<LocalSong*>(s)) {
-                    return 0;
-                }
-                if (typeinfo_cast<HostedSong*>(s)) {
-                    return 1;
-                }
-                if (typeinfo_cast<YTSong*>(s)) {
-                    return 2;
-                }
-                return 3;
-            };
-
-            bool aVerified =
-                std::ranges::find(verifiedNongs, a->metadata()->uniqueID) != verifiedNongs.end();
-            bool bVerified =
-                std::ranges::find(verifiedNongs, b->metadata()->uniqueID) != verifiedNongs.end();
-
-            // Sort by Verified
-            if (aVerified != bVerified) {
-                return aVerified;
-            }
-
-            // Then by source priority
-            int sourceA = sourcePriority(a);
-            int sourceB = sourcePriority(b);
-            if (sourceA != sourceB) {
-                return sourceA < sourceB;
-            }
-
-            // Then by name
-            return a->metadata()->name < b->metadata()->name;
-        });
-
-        for (Song* nong : allLocalNongs) {
-            this->addSongToList(nong, nongs);
+        for (const RankedSong& nong : allLocalNongs) {
+            this->addSongToList(nong.m_song, nongs);
         }
 
         if (!nongs->indexSongs().empty()) {
             CCLabelBMFont* indexLabel = CCLabelBMFont::create("Download nongs", "goldFont.fnt");
             indexLabel->setID("index-section");
             indexLabel->setScale(0.5f);
-            m_list->m_contentLayer->addChild(indexLabel);
+            this->addLabelRow(indexLabel, m_rows.end());
         }
 
-        std::vector<index::IndexSongMetadata*> allIndexNongs;
+        std::vector<RankedIndexSong> allIndexNongs;
         // Might reserve more than needed, still fine imo
         allIndexNongs.reserve(nongs->indexSongs().size());
 
+        const std::unordered_map<std::string, size_t> order = indexOrder();
         for (index::IndexSongMetadata* index : nongs->indexSongs()) {
-            const std::string id = fmt::format("{}|{}", index->parentID->m_id, index->uniqueID);
-
-            if (index->ytId.has_value() && localYt.contains(id)) {
-                continue;
+            if (!isStored(index, storedIndexSongs)) {
+                allIndexNongs.push_back(RankedIndexSong::rank(index, m_levelID, order));
             }
-
-            if (index->url.has_value() && localHosted.contains(id)) {
-                continue;
-            }
-
-            allIndexNongs.push_back(index);
         }
 
-        std::sort(allIndexNongs.begin(), allIndexNongs.end(),
-                  [this](index::IndexSongMetadata* a, index::IndexSongMetadata* b) {
-                      auto sourcePriority = [](index::IndexSongMetadata* s) {
-                          if (s->url.has_value()) {
-                              return 0;
-                          }
-                          if (s->ytId.has_value()) {
-                              return 1;
-                          }
-                          return 2;
-                      };
-
-                      bool aVerified = m_levelID.has_value()
-                                           ? std::find(a->verifiedLevelIDs.begin(), a->verifiedLevelIDs.end(),
-                                                       m_levelID.value()) != a->verifiedLevelIDs.end()
-                                           : false;
-                      bool bVerified = m_levelID.has_value()
-                                           ? std::find(b->verifiedLevelIDs.begin(), b->verifiedLevelIDs.end(),
-                                                       m_levelID.value()) != b->verifiedLevelIDs.end()
-                                           : false;
-
-                      // Sort by Verified
-                      if (aVerified != bVerified) {
-                          return aVerified;
-                      }
-
-                      // Then by source priority
-                      int sourceA = sourcePriority(a);
-                      int sourceB = sourcePriority(b);
-                      if (sourceA != sourceB) {
-                          return sourceA < sourceB;
-                      }
-
-                      // Then by name
-                      return a->name < b->name;
-                  });
-
-        for (index::IndexSongMetadata* indexNong : allIndexNongs) {
-            this->addIndexSongToList(indexNong, nongs);
+        std::ranges::sort(allIndexNongs, std::less{}, &RankedIndexSong::key);
+
+        for (const RankedIndexSong& indexNong : allIndexNongs) {
+            this->addIndexSongToList(indexNong.m_song, nongs);
         }
     }
-    m_list->m_contentLayer->updateLayout();
+
+    this->relayout();
     this->scrollToTop();
 }
 
 void NongList::addSongToList(Song* nong, Nongs* parent, bool liveInsert) {
-    int id = m_currentSong.value();
-    Song* defaultSong = parent->defaultSong();
-    Song* active = parent->active();
-
-    CCSize itemSize = {m_list->getScaledContentSize().width - s_padding, s_itemSize};
-
-    std::string uniqueID = nong->metadata()->uniqueID;
-    std::optional<std::filesystem::path> path = nong->path();
-    bool isFromIndex = nong->indexID().has_value();
-    bool isDownloaded = path.has_value() && std::filesystem::exists(path.value());
-    NongCell* cell = NongCell::create(id, uniqueID, itemSize, m_levelID, std::nullopt);
-    cell->setID(uniqueID);
+    const std::string& uniqueID = nong->metadata()->uniqueID;
+    Row row{.m_kind = RowKind::Nong,
+            .m_id = uniqueID,
+            .m_songID = parent->songID(),
+            .m_uniqueID = uniqueID,
+            .m_height = s_itemSize};
 
     if (!liveInsert) {
-        m_list->m_contentLayer->addChild(cell);
+        m_rows.push_back(std::move(row));
         return;
     }
 
-    CCNode* indexSection = m_list->m_contentLayer->getChildByID("index-section");
-
-    if (indexSection) {
-        m_list->m_contentLayer->insertBefore(cell, indexSection);
-    } else {
-        m_list->m_contentLayer->addChild(cell);
-    }
+    // Downloaded and added songs go at the end of the stored section
+    m_rows.insert(this->findRow("index-section"), std::move(row));
 }
 
 void NongList::addIndexSongToList(index::IndexSongMetadata* song, Nongs* parent) {
-    const CCSize itemSize = {m_list->getScaledContentSize().width - s_padding, s_itemSize};
-    NongCell* cell = NongCell::create(m_currentSong.value(), song->uniqueID, itemSize, m_levelID, song);
-    cell->setID(fmt::format("{}-{}", song->parentID->m_id, song->uniqueID));
-    m_list->m_contentLayer->addChild(cell);
+    m_rows.push_back(Row{
+        .m_kind = RowKind::IndexNong,
+        .m_id = fmt::format("{}-{}", song->parentID->m_id, song->uniqueID),
+        .m_songID = parent->songID(),
+        .m_uniqueID = std::string(song->uniqueID),
+        .m_indexSong = song,
+        .m_height = s_itemSize,
+    });
+}
+
+void NongList::addSearchResults() {
+    const std::vector<index::SongMatch> matches = IndexManager::get().searchSongs(m_query);
+
+    if (matches.empty()) {
+        CCLabelBMFont* label = CCLabelBMFont::create("No songs found", "bigFont.fnt");
+        label->setID("no-search-results");
+        label->limitLabelWidth(150.0f, 0.7f, 0.1f);
+        this->addLabelRow(label, m_rows.end());
+        return;
+    }
+
+    for (const index::SongMatch& match : matches) {
+        const std::span<const int> ids = match.m_song->songIDs;
+        if (ids.empty()) {
+            continue;
+        }
+
+        // Downloads go to the song ID being looked at if the song replaces it,
+        // else to another song of the level, else to the first it replaces
+        auto id = std::ranges::find_if(ids, [this](const int songID) { return m_currentSong == songID; });
+        if (id == ids.end()) {
+            id = std::ranges::find_first_of(ids, m_songIds);
+        }
+        if (id == ids.end()) {
+            id = ids.begin();
+        }
+
+        // Songs stored already show up as the stored song, so they can be
+        // picked instead of downloaded again
+        const bool stored = isStoredFor(match.m_song, *id);
+        m_rows.push_back(Row{
+            .m_kind = stored ? RowKind::Nong : RowKind::IndexNong,
+            .m_id = fmt::format("{}-{}", match.m_song->parentID->m_id, match.m_song->uniqueID),
+            .m_songID = *id,
+            .m_uniqueID = std::string(match.m_song->uniqueID),
+            .m_indexSong = match.m_song,
+            .m_height = s_itemSize,
+        });
+    }
 }
 
 void NongList::addNoLocalSongsNotice(bool liveInsert) {
@@ -325,19 +411,200 @@ void NongList::addNoLocalSongsNotice(bool liveInsert) {
     label->limitLabelWidth(150.0f, 0.7f, 0.1f);
 
     if (!liveInsert) {
-        m_list->m_contentLayer->addChild(label);
+        this->addLabelRow(label, m_rows.end());
+        return;
+    }
+
+    auto section = this->findRow("local-section");
+    if (section == m_rows.end()) {
+        log::error("Couldn't insert no local songs notice. Section not found");
     } else {
-        CCNode* section = m_list->m_contentLayer->getChildByID("local-section");
-        if (!section) {
-            log::error("Couldn't insert no local songs notice. Section not found");
-        } else {
-            m_list->m_contentLayer->insertAfter(label, section);
+        this->addLabelRow(label, std::next(section));
+    }
+}
+
+void NongList::addLabelRow(CCLabelBMFont* label, std::vector<Row>::iterator at) {
+    m_list->m_contentLayer->addChild(label);
+    m_rows.insert(at, Row{
+                          .m_kind = RowKind::Label,
+                          .m_id = label->getID(),
+                          .m_height = label->getScaledContentHeight(),
+                          .m_node = label,
+                      });
+}
+
+std::vector<NongList::Row>::iterator NongList::findRow(std::string_view id) {
+    return std::ranges::find_if(m_rows, [id](const Row& row) { return !row.m_id.empty() && row.m_id == id; });
+}
+
+void NongList::removeRow(std::string_view id) {
+    auto found = this->findRow(id);
+    if (found == m_rows.end()) {
+        return;
+    }
+
+    if (found->m_node) {
+        this->releaseRow(*found);
+    }
+    m_rows.erase(found);
+}
+
+void NongList::clearRows() {
+    m_rows.clear();
+    // Cells listen to events of the song ID they were made for, so they can't
+    // be reused for another one
+    m_pool.clear();
+
+    if (m_list->m_contentLayer->getChildrenCount() > 0) {
+        m_list->m_contentLayer->removeAllChildrenWithCleanup(true);
+    }
+}
+
+void NongList::relayout() {
+    auto* content = m_list->m_contentLayer;
+    const float viewHeight = m_list->getContentHeight();
+    const float scrolled = viewHeight - content->getPositionY() - content->getContentHeight();
+
+    float total = 0.f;
+    for (Row& row : m_rows) {
+        if (total > 0.f) {
+            total += s_padding / 2;
+        }
+        row.m_top = total;
+        total += row.m_height;
+    }
+
+    const float height = std::max(total, viewHeight);
+    content->setContentHeight(height);
+
+    for (const Row& row : m_rows) {
+        if (row.m_node) {
+            this->placeRow(row);
+        }
+    }
+
+    // Setting the position also makes the content layer update which of its
+    // children are visible
+    const float maxScroll = height - viewHeight;
+    content->setPositionY(viewHeight - height - std::clamp(scrolled, 0.f, maxScroll));
+
+    this->refreshVisibleRows();
+}
+
+void NongList::refreshVisibleRows() {
+    auto* content = m_list->m_contentLayer;
+    const float viewHeight = m_list->getContentHeight();
+
+    // Visible part of the list, measured from its top. Rows a cell away from
+    // it are created too, so they are ready before they scroll in.
+    const float viewTop = content->getContentHeight() + content->getPositionY() - viewHeight - s_itemSize;
+    const float viewBottom = viewTop + viewHeight + 2 * s_itemSize;
+
+    // Release first, so the cells can be reused right away
+    for (Row& row : m_rows) {
+        const bool inView = row.m_top + row.m_height >= viewTop && row.m_top <= viewBottom;
+        if (!inView && row.m_node && row.m_kind != RowKind::Label) {
+            this->releaseRow(row);
+        }
+    }
+
+    for (Row& row : m_rows) {
+        const bool inView = row.m_top + row.m_height >= viewTop && row.m_top <= viewBottom;
+        if (inView && !row.m_node) {
+            this->materializeRow(row);
         }
     }
+
+    m_lastScrollY = content->getPositionY();
+}
+
+void NongList::materializeRow(Row& row) {
+    const CCSize itemSize = {m_list->getScaledContentSize().width - s_padding, s_itemSize};
+
+    switch (row.m_kind) {
+        case RowKind::Song: {
+            std::optional<Nongs*> nongs = NongManager::get().getNongs(row.m_songID);
+            if (!nongs) {
+                return;
+            }
+
+            const int id = row.m_songID;
+            row.m_node = SongCell::create(id, nongs.value()->active()->metadata(), itemSize,
+                                          [this, id]() { this->onSelectSong(id); });
+            break;
+        }
+        case RowKind::Nong:
+        case RowKind::IndexNong: {
+            const std::optional<index::IndexSongMetadata*> indexSong =
+                row.m_kind == RowKind::IndexNong ? std::optional(row.m_indexSong) : std::nullopt;
+            // Search results can be for any song ID
+            const int songID = row.m_songID;
+
+            while (!row.m_node) {
+                const auto pooled = std::ranges::find_if(
+                    m_pool, [songID](const geode::Ref<NongCell>& cell) { return cell->songID() == songID; });
+                if (pooled == m_pool.end()) {
+                    break;
+                }
+
+                geode::Ref<NongCell> cell = std::move(*pooled);
+                m_pool.erase(pooled);
+                if (cell->reuse(row.m_uniqueID, indexSong)) {
+                    row.m_node = cell.data();
+                }
+            }
+
+            if (!row.m_node) {
+                row.m_node = NongCell::create(songID, row.m_uniqueID, itemSize, m_levelID, indexSong);
+            }
+            break;
+        }
+        case RowKind::Label:
+            return;
+    }
+
+    if (!row.m_node) {
+        return;
+    }
+
+    if (!row.m_id.empty()) {
+        row.m_node->setID(row.m_id);
+    }
+    // The content layer hides children out of view, reused cells may still be
+    // hidden from where they were before
+    row.m_node->setVisible(true);
+    m_list->m_contentLayer->addChild(row.m_node);
+    this->placeRow(row);
+}
+
+void NongList::releaseRow(Row& row) {
+    if (row.m_kind == RowKind::Nong || row.m_kind == RowKind::IndexNong) {
+        m_pool.emplace_back(static_cast<NongCell*>(row.m_node.data()));
+        // Keep its listeners, the cell is going to be used again
+        row.m_node->removeFromParentAndCleanup(false);
+    } else {
+        row.m_node->removeFromParentAndCleanup(true);
+    }
+
+    row.m_node = nullptr;
+}
+
+void NongList::placeRow(const Row& row) const {
+    auto* content = m_list->m_contentLayer;
+    row.m_node->setAnchorPoint({0.5f, 0.5f});
+    row.m_node->setPosition(
+        {content->getContentWidth() / 2.f, content->getContentHeight() - row.m_top - row.m_height / 2.f});
+}
+
+void NongList::update(float dt) {
+    if (m_list->m_contentLayer->getPositionY() != m_lastScrollY) {
+        this->refreshVisibleRows();
+    }
 }
 
 void NongList::scrollToTop() {
     m_list->m_contentLayer->setPositionY(-m_list->m_contentLayer->getContentHeight() + m_list->getContentHeight());
+    this->refreshVisibleRows();
 }
 
 void NongList::onBack(cocos2d::CCObject* target) {
@@ -351,6 +618,15 @@ void NongList::onBack(cocos2d::CCObject* target) {
     m_backBtn->setVisible(false);
 }
 
+void NongList::search(std::string query) {
+    if (query == m_query) {
+        return;
+    }
+
+    m_query = std::move(query);
+    this->build();
+}
+
 void NongList::setCurrentSong(int songId) {
     if (std::find(m_songIds.begin(), m_songIds.end(), songId) != m_songIds.end()) {
         m_currentSong = songId;
@@ -369,6 +645,11 @@ void NongList::onSelectSong(int songId) {
 }
 
 ListenerResult NongList::onDownloadFinish(const event::SongDownloadFinishedData& e) {
+    if (m_list && !m_query.empty()) {
+        this->onSearchResultStored(e);
+        return ListenerResult::Propagate;
+    }
+
     if (!m_list || !m_currentSong.has_value() || !e.indexSource().has_value()) {
         return ListenerResult::Propagate;
     }
@@ -381,37 +662,38 @@ ListenerResult NongList::onDownloadFinish(const event::SongDownloadFinishedData&
 
     Nongs* nongs = std::move(optNongs).value();
 
-    if (!nongs->findSong(e.destination()->metadata()->uniqueID)) {
+    // Index songs can replace several song IDs, and only downloads for the
+    // one being shown belong in the list
+    if (e.destination()->metadata()->gdID != nongs->songID() ||
+        !nongs->findSong(e.destination()->metadata()->uniqueID)) {
         return ListenerResult::Propagate;
     }
 
     index::IndexSongMetadata* meta = e.indexSource().value();
-    if (CCNode* i = m_list->m_contentLayer->getChildByID(fmt::format("{}-{}", meta->parentID->m_id, meta->uniqueID))) {
-        i->removeFromParentAndCleanup(true);
-    }
+    this->removeRow(fmt::format("{}-{}", meta->parentID->m_id, meta->uniqueID));
 
     this->addSongToList(e.destination(), nongs, true);
 
     // Remove "you have no local songs label"
-    if (auto node = m_list->m_contentLayer->getChildByID("no-local-songs")) {
-        node->removeFromParentAndCleanup(true);
-    }
+    this->removeRow("no-local-songs");
 
-    this->updateLayoutAndFixWeirdDisplay();
+    this->relayout();
 
     return ListenerResult::Propagate;
 }
 
 ListenerResult NongList::onNongDeleted(const event::NongDeletedData& e) {
-    if (!m_list || !m_currentSong.has_value() || m_currentSong.value() != e.gdId()) {
+    if (m_list && !m_query.empty()) {
+        this->onSearchResultDeleted(e);
         return ListenerResult::Propagate;
     }
 
-    if (CCNode* found = m_list->m_contentLayer->getChildByID(e.uniqueId())) {
-        found->removeFromParentAndCleanup(true);
-        this->updateLayoutAndFixWeirdDisplay();
+    if (!m_list || !m_currentSong.has_value() || m_currentSong.value() != e.gdId()) {
+        return ListenerResult::Propagate;
     }
 
+    this->removeRow(e.uniqueId());
+
     std::optional<Nongs*> optNongs = NongManager::get().getNongs(m_currentSong.value());
 
     if (!optNongs.has_value()) {
@@ -425,42 +707,75 @@ ListenerResult NongList::onNongDeleted(const event::NongDeletedData& e) {
             continue;
         }
 
-        if (!m_list->m_contentLayer->getChildByID("index-section")) {
+        if (this->findRow("index-section") == m_rows.end()) {
             CCLabelBMFont* indexLabel = CCLabelBMFont::create("Download nongs", "goldFont.fnt");
             indexLabel->setID("index-section");
             indexLabel->setScale(0.5f);
-            m_list->m_contentLayer->addChild(indexLabel);
+            this->addLabelRow(indexLabel, m_rows.end());
         }
 
         this->addIndexSongToList(i, nongs);
     }
 
-    this->updateLayoutAndFixWeirdDisplay();
+    this->relayout();
 
     return ListenerResult::Propagate;
 }
 
+void NongList::onSearchResultStored(const event::SongDownloadFinishedData& e) {
+    if (!e.indexSource().has_value()) {
+        return;
+    }
+
+    const int songID = e.destination()->metadata()->gdID;
+    const auto row = std::ranges::find_if(m_rows, [&e, songID](const Row& row) {
+        return row.m_kind == RowKind::IndexNong && row.m_indexSong == e.indexSource().value() &&
+               row.m_songID == songID;
+    });
+    if (row == m_rows.end()) {
+        return;
+    }
+
+    // Search results aren't split into sections, the result becomes the
+    // stored song in place
+    if (row->m_node) {
+        this->releaseRow(*row);
+    }
+    row->m_kind = RowKind::Nong;
+    this->refreshVisibleRows();
+}
+
+void NongList::onSearchResultDeleted(const event::NongDeletedData& e) {
+    const auto row = std::ranges::find_if(m_rows, [&e](const Row& row) {
+        return row.m_kind == RowKind::Nong && row.m_indexSong && row.m_songID == e.gdId() &&
+               row.m_uniqueID == e.uniqueId();
+    });
+    if (row == m_rows.end()) {
+        return;
+    }
+
+    // The result can be downloaded again
+    if (row->m_node) {
+        this->releaseRow(*row);
+    }
+    row->m_kind = RowKind::IndexNong;
+    this->refreshVisibleRows();
+}
+
 ListenerResult NongList::onSongAdded(const event::ManualSongAddedData& e) {
-    if (!m_list || !m_currentSong.has_value() || m_currentSong.value() != e.nongs()->songID()) {
+    if (!m_list || !m_query.empty() || !m_currentSong.has_value() || m_currentSong.value() != e.nongs()->songID()) {
         return ListenerResult::Propagate;
     }
 
     this->addSongToList(e.song(), e.nongs(), true);
 
     // Remove "you have no local songs label"
-    if (auto node = m_list->m_contentLayer->getChildByID("no-local-songs")) {
-        node->removeFromParentAndCleanup(true);
-    }
+    this->removeRow("no-local-songs");
 
-    this->updateLayoutAndFixWeirdDisplay();
+    this->relayout();
     return ListenerResult::Propagate;
 }
 
-void NongList::updateLayoutAndFixWeirdDisplay() const {
-    m_list->m_contentLayer->updateLayout();
-    m_list->m_contentLayer->setPositionY(m_list->m_contentLayer->getPositionY() + 0.00001f);
-}
-
 NongList* NongList::create(std::vector<int> songIds, const cocos2d::CCSize& size, std::optional<int> levelID,
                            std::function<void(std::optional<int>)> onListTypeChange) {
     auto ret = new NongList();
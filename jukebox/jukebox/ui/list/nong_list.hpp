@@ -2,12 +2,15 @@
 
 #include <functional>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <GUI/CCControlExtension/CCScale9Sprite.h>
 #include <Geode/cocos/base_nodes/CCNode.h>
 #include <Geode/cocos/cocoa/CCGeometry.h>
 #include <Geode/cocos/cocoa/CCObject.h>
+#include <Geode/cocos/label_nodes/CCLabelBMFont.h>
 #include <Geode/binding/CCMenuItemSpriteExtra.hpp>
 #include <Geode/loader/Event.hpp>
 #include <Geode/ui/ScrollLayer.hpp>
@@ -20,21 +23,50 @@
 
 namespace jukebox {
 
+/**
+ * Only rows near the visible part of the list get a node. Cells of rows that
+ * scroll out of view are kept and reused for the rows scrolling in, so
+ * opening a song with hundreds of nongs creates only a handful of cells.
+ */
 class NongList final : public cocos2d::CCNode {
 public:
     enum class ListType { Single = 0, Multiple = 1 };
 
 protected:
+    enum class RowKind { Song, Nong, IndexNong, Label };
+
+    struct Row {
+        RowKind m_kind;
+        // ID of the row's node, used to find rows again for live updates
+        std::string m_id;
+        int m_songID = 0;
+        std::string m_uniqueID;
+        // Also set on search results that are stored already
+        index::IndexSongMetadata* m_indexSong = nullptr;
+        float m_height = 0.f;
+        // Distance from the top of the list
+        float m_top = 0.f;
+        // Labels always have one, cells only while they're near the view
+        geode::Ref<cocos2d::CCNode> m_node = nullptr;
+    };
+
     std::vector<int> m_songIds;
     geode::Ref<geode::ScrollLayer> m_list = nullptr;
     geode::Ref<cocos2d::extension::CCScale9Sprite> m_bg = nullptr;
     std::optional<int> m_currentSong = std::nullopt;
     std::optional<int> m_levelID;
+    // Searched across every index instead of listing songs while not empty
+    std::string m_query;
 
     geode::Ref<CCMenuItemSpriteExtra> m_backBtn = nullptr;
 
     std::function<void(std::optional<int>)> m_onListTypeChange;
 
+    std::vector<Row> m_rows;
+    // Cells that scrolled out of view, waiting to be reused
+    std::vector<geode::Ref<NongCell>> m_pool;
+    float m_lastScrollY = 0.f;
+
     geode::ListenerHandle m_downloadFinishedListener;
     geode::ListenerHandle m_nongDeletedListener;
     geode::ListenerHandle m_nongAddedListener;
@@ -45,15 +77,37 @@ protected:
     void addNoLocalSongsNotice(bool liveInsert = false);
     void addSongToList(Song* nong, Nongs* parent, bool liveInsert = false);
     void addIndexSongToList(index::IndexSongMetadata* song, Nongs* parent);
+    void addSearchResults();
     geode::ListenerResult onDownloadFinish(const event::SongDownloadFinishedData& e);
     geode::ListenerResult onNongDeleted(const event::NongDeletedData& e);
+    // Search results switch between stored and index cells in place
+    void onSearchResultStored(const event::SongDownloadFinishedData& e);
+    void onSearchResultDeleted(const event::NongDeletedData& e);
     geode::ListenerResult onSongAdded(const event::ManualSongAddedData& e);
-    // This just moves the list up by 0.00001. That's it. Don't ask.
-    void updateLayoutAndFixWeirdDisplay() const;
+
+    void addLabelRow(cocos2d::CCLabelBMFont* label, std::vector<Row>::iterator at);
+    void removeRow(std::string_view id);
+    std::vector<Row>::iterator findRow(std::string_view id);
+    void clearRows();
+    /**
+     * Positions rows after some were added or removed, keeping the list
+     * scrolled as far from the top as it was
+     */
+    void relayout();
+    void refreshVisibleRows();
+    void materializeRow(Row& row);
+    void releaseRow(Row& row);
+    void placeRow(const Row& row) const;
 
 public:
+    void update(float dt) override;
     void scrollToTop();
     void setCurrentSong(int songId);
+    /**
+     * Lists the index songs matching the query instead, or the songs again if
+     * it's empty
+     */
+    void search(std::string query);
     void build();
     void onBack(cocos2d::CCObject*);
     void onSelectSong(int songId);
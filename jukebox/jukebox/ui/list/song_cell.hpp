@@ -31,6 +31,7 @@ public:
                             std::function<void()> selectCallback) {
         auto ret = new SongCell();
         if (ret->init(id, songInfo, size, std::move(selectCallback))) {
+            ret->autorelease();
             return ret;
         }
 
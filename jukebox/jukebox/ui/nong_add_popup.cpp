@@ -8,7 +8,6 @@
 #include <optional>
 #include <regex>
 #include <sstream>
-#include <system_error>
 #include <utility>
 
 #include <Geode/cocos/base_nodes/CCNode.h>
@@ -23,6 +22,7 @@
 #include <Geode/binding/FLAlertLayer.hpp>
 #include <Geode/binding/FLAlertLayerProtocol.hpp>
 #include <Geode/binding/FMODAudioEngine.hpp>
+#include <Geode/loader/Log.hpp>
 #include <Geode/loader/Mod.hpp>
 #include <Geode/ui/Layout.hpp>
 #include <Geode/ui/Popup.hpp>
@@ -31,14 +31,18 @@
 #include <Geode/utils/file.hpp>
 #include <Geode/utils/general.hpp>
 #include <Geode/utils/string.hpp>
+#include <arc/future/Future.hpp>
 #include <fmod.hpp>
 
 #include <jukebox/events/manual_song_added.hpp>
 #include <jukebox/managers/index_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
+#include <jukebox/nong/blob_store.hpp>
 #include <jukebox/nong/nong.hpp>
 #include <jukebox/ui/index_choose_popup.hpp>
+#include <jukebox/utils/audio_tags.hpp>
 #include <jukebox/utils/random_string.hpp>
+#include <jukebox/utils/sha256.hpp>
 
 using namespace geode::prelude;
 using namespace jukebox::index;
@@ -49,19 +53,11 @@ void setInputProps(TextInput* i) {
     i->getInputNode()->setLabelPlaceholderScale(0.7f);
 }
 
-std::optional<std::string> parseFromFMODTag(const FMOD_TAG& tag) {
-    std::string ret;
-#ifdef GEODE_IS_WINDOWS
-    if (tag.datatype == FMOD_TAGDATATYPE_STRING_UTF16) {
-        return string::wideToUtf8(reinterpret_cast<const wchar_t*>(tag.data));
-    } else if (tag.datatype == FMOD_TAGDATATYPE_STRING_UTF16BE) {
-        // I'm a big endian hater, whachu gonna do?
-        return std::nullopt;
-    }
-#endif
+namespace {
 
-    return std::string(reinterpret_cast<const char*>(tag.data), tag.datalen);
-}
+arc::Future<Result<std::string>> hashFile(std::filesystem::path path) { co_return jukebox::sha256File(path); }
+
+}  // namespace
 
 class IndexDisclaimerPopup : public FLAlertLayer, public FLAlertLayerProtocol {
 protected:
@@ -408,49 +404,63 @@ void NongAddPopup::onFileOpen(Result<std::optional<std::filesystem::path>> resul
         return;
     }
 
+    m_localPath = path;
+    m_specialInput->setString(strPath);
+
     if (Mod::get()->getSettingValue<bool>("autocomplete-metadata")) {
-        if (auto meta = this->tryParseMetadata(path); meta && (meta->artist.has_value() || meta->name.has_value())) {
-            auto artistName = m_artistNameInput->getString();
-            auto songName = m_songNameInput->getString();
+        async::spawn(readAudioTagsAsync(path), [self = Ref(this), path](Result<AudioTags> tags) {
+            // The popup may have been closed, or another file picked meanwhile
+            if (self->getParent() == nullptr || self->m_songType != SongType::LOCAL || self->m_localPath != path) {
+                return;
+            }
 
-            if (!artistName.empty() || !songName.empty()) {
-                // We should ask before replacing stuff
-                std::stringstream ss;
+            if (tags.isErr()) {
+                log::info("Couldn't read tags of {}: {}", path.filename(), tags.unwrapErr());
+                return;
+            }
 
-                ss << "Found metadata for the imported song: ";
-                if (meta->name.has_value()) {
-                    ss << fmt::format("Name: \"{}\". ", meta->name.value());
-                }
-                if (meta->artist.has_value()) {
-                    ss << fmt::format("Artist: \"{}\". ", meta->artist.value());
-                }
+            self->onTagsRead(tags.unwrap());
+        });
+    }
+}
 
-                ss << "Do you want to set those values for the song?";
-
-                createQuickPopup("Metadata found", ss.str(), "No", "Yes", [this, meta](auto, bool btn2) {
-                    if (!btn2) {
-                        return;
-                    }
-                    if (meta->artist.has_value()) {
-                        m_artistNameInput->setString(meta->artist.value());
-                    }
-                    if (meta->name.has_value()) {
-                        m_songNameInput->setString(meta->name.value());
-                    }
-                });
-            } else {
-                if (meta->artist.has_value()) {
-                    m_artistNameInput->setString(meta->artist.value());
-                }
-                if (meta->name.has_value()) {
-                    m_songNameInput->setString(meta->name.value());
-                }
-            }
+void NongAddPopup::onTagsRead(const AudioTags& tags) {
+    if (tags.empty()) {
+        return;
+    }
+
+    const auto apply = [this, tags]() {
+        if (tags.m_artist.has_value()) {
+            m_artistNameInput->setString(tags.m_artist.value());
+        }
+        if (tags.m_title.has_value()) {
+            m_songNameInput->setString(tags.m_title.value());
         }
+    };
+
+    if (m_artistNameInput->getString().empty() && m_songNameInput->getString().empty()) {
+        apply();
+        return;
     }
 
-    m_localPath = path;
-    m_specialInput->setString(strPath);
+    // We should ask before replacing stuff
+    std::stringstream ss;
+
+    ss << "Found metadata for the imported song: ";
+    if (tags.m_title.has_value()) {
+        ss << fmt::format("Name: \"{}\". ", tags.m_title.value());
+    }
+    if (tags.m_artist.has_value()) {
+        ss << fmt::format("Artist: \"{}\". ", tags.m_artist.value());
+    }
+
+    ss << "Do you want to set those values for the song?";
+
+    createQuickPopup("Metadata found", ss.str(), "No", "Yes", [apply](auto, bool btn2) {
+        if (btn2) {
+            apply();
+        }
+    });
 }
 
 void NongAddPopup::setSongType(SongType type, bool memorizePrevious) {
@@ -533,10 +543,10 @@ void NongAddPopup::onPublish(CCObject* target) {
                 Song* replacedNong = m_replacedNong.value();
 
                 std::string songSpecificParams;
-                const auto pathStr = string::pathToString(replacedNong->path().value());
                 switch (replacedNong->type()) {
                     case NongType::LOCAL:
-                        songSpecificParams = fmt::format("&path={}&source=local", pathStr);
+                        songSpecificParams = fmt::format("&path={}&source=local",
+                                                         string::pathToString(replacedNong->path().value()));
                         break;
                     case NongType::YOUTUBE:
                         songSpecificParams =
@@ -589,11 +599,12 @@ void NongAddPopup::addSong(CCObject* target) {
     }
 
     if (m_songType == SongType::LOCAL) {
+        // Finished by onLocalSongHashed
         auto res = this->addLocalSong(songName, artistName, levelName, startOffset);
         if (res.isErr()) {
             FLAlertLayer::create("Error", res.unwrapErr(), "Ok")->show();
-            return;
         }
+        return;
     } else if (m_songType == SongType::YOUTUBE) {
         auto res = this->addYTSong(songName, artistName, levelName, startOffset);
         if (res.isErr()) {
@@ -635,8 +646,6 @@ Result<> NongAddPopup::addLocalSong(const std::string& songName, const std::stri
         return Err("You selected a directory.");
     }
 
-    std::string extension = path.extension().string();
-
     if (songName.empty()) {
         return Err("Song name is empty");
     }
@@ -645,54 +654,71 @@ Result<> NongAddPopup::addLocalSong(const std::string& songName, const std::stri
         return Err("Artist name is empty");
     }
 
-    std::string id =
-        m_replacedNong.has_value() ? m_replacedNong.value()->metadata()->uniqueID : jukebox::random_string(16);
-    std::string unique = fmt::format("{}{}", id, extension);
-    std::filesystem::path destination = Mod::get()->getSaveDir() / "nongs";
-    std::error_code error_code;
-    if (!std::filesystem::exists(destination, error_code)) {
-        if (!std::filesystem::create_directory(destination, error_code)) {
-            return Err("Failed to create nongs directory.");
-        }
-    }
-    destination /= unique;
+    std::optional<std::string> replacedID =
+        m_replacedNong.has_value() ? std::optional(m_replacedNong.value()->metadata()->uniqueID) : std::nullopt;
+    SongMetadata metadata{m_songID, replacedID.value_or(jukebox::random_string(16)), songName, artistName, levelName,
+                          offset};
 
-    if (destination.compare(path) != 0) {
-        bool result = std::filesystem::copy_file(path, destination, std::filesystem::copy_options::overwrite_existing,
-                                                 error_code);
-        if (error_code) {
-            return Err(
-                fmt::format("Failed to save song. Please try again! Error category: {}, "
-                            "message: {}",
-                            error_code.category().name(), error_code.category().message(error_code.value())));
+    // Hashing reads the whole file, which takes a while for long songs
+    m_addSongButton->setEnabled(false);
+    async::spawn(hashFile(path), [self = Ref(this), path, metadata = std::move(metadata),
+                                  replacedID = std::move(replacedID)](Result<std::string> hash) mutable {
+        self->m_addSongButton->setEnabled(true);
+
+        // The popup may have been closed meanwhile
+        if (self->getParent() == nullptr) {
+            return;
         }
-        if (!result) {
-            return Err(
-                "Failed to copy song to Jukebox's songs folder. Please try "
-                "again.");
+
+        Result<> res = self->onLocalSongHashed(path, std::move(hash), std::move(metadata), replacedID);
+        if (res.isErr()) {
+            FLAlertLayer::create("Error", res.unwrapErr(), "Ok")->show();
+            return;
         }
+
+        FLAlertLayer::create("Success", "Song was added successfuly!", "Ok")->show();
+        self->onClose(self.data());
+    });
+
+    return Ok();
+}
+
+Result<> NongAddPopup::onLocalSongHashed(const std::filesystem::path& path, Result<std::string>&& hash,
+                                         SongMetadata&& metadata, const std::optional<std::string>& replacedID) {
+    if (hash.isErr()) {
+        return Err(fmt::format("Failed to save song. Please try again! {}", hash.unwrapErr()));
+    }
+
+    Result<std::filesystem::path> stored = blobs::commit(path, hash.unwrap(), path.extension(), true);
+    if (stored.isErr()) {
+        return Err(fmt::format("Failed to save song. Please try again! {}", stored.unwrapErr()));
     }
+    std::filesystem::path destination = std::move(stored).unwrap();
 
-    LocalSong song = LocalSong{SongMetadata{m_songID, id, songName, artistName, levelName, offset}, destination};
+    const std::string id = metadata.uniqueID;
+    LocalSong song = LocalSong{std::move(metadata), destination};
 
     Nongs* nongs = NongManager::get().getNongs(m_songID).value();
 
-    if (m_replacedNong.has_value()) {
-        Result<> res = nongs->replaceSong(m_replacedNong.value()->metadata()->uniqueID, std::move(song));
+    if (replacedID.has_value()) {
+        Result<> res = nongs->replaceSong(replacedID.value(), std::move(song));
 
         if (res.isErr()) {
+            NongManager::get().releaseAudio(destination);
             return Err(fmt::format("Failed to add song: {}", res.unwrapErr()));
         }
     } else {
         Result<LocalSong*> res = nongs->add(std::move(song));
         if (res.isErr()) {
+            NongManager::get().releaseAudio(destination);
             return Err(fmt::format("Failed to add song: {}", res.unwrapErr()));
         }
 
         event::ManualSongAdded().send(event::ManualSongAddedData{nongs, res.unwrap()});
     }
 
-    (void)nongs->commit();
+    // Replaced songs keep their unique ID but move to the end, like added ones
+    (void)NongManager::get().saveNongs(m_songID, ManifestOp::Add, id);
 
     return Ok();
 }
@@ -812,7 +838,7 @@ geode::Result<> NongAddPopup::addHostedSong(const std::string& songName, const s
             return Err(fmt::format("Failed to create song: {}", res.unwrapErr()));
         }
 
-        (void)nongs->commit();
+        (void)NongManager::get().saveNongs(m_songID, ManifestOp::Add, id);
 
         event::ManualSongAdded().send(event::ManualSongAddedData{nongs, res.unwrap()});
     }
@@ -835,56 +861,6 @@ bool NongAddPopup::isPathValidSong(const std::filesystem::path& song) const {
     return false;
 }
 
-std::optional<NongAddPopup::ParsedMetadata> NongAddPopup::tryParseMetadata(std::filesystem::path path) {
-    const char* MP3_NAME_TAG = "TIT2";
-    const char* MP3_ARTIST_TAG = "TPE1";
-
-    const char* OGG_FLAC_NAME_TAG = "TITLE";
-    const char* OGG_FLAC_ARTIST_TAG = "ARTIST";
-
-    const char* WAV_NAME_TAG = "INAM";
-    const char* WAV_ARTIST_TAG = "IART";
-
-    // Thanks to undefined06855 for most of this stuff
-    // https://github.com/undefined06855/EditorMusic/blob/main/src/AudioManager.cpp
-
-    NongAddPopup::ParsedMetadata ret{};
-    FMOD::Sound* sound;
-    FMOD::System* system = FMODAudioEngine::sharedEngine()->m_system;
-
-    system->createSound(path.string().c_str(), FMOD_CREATESTREAM | FMOD_OPENONLY, nullptr, &sound);
-
-    if (!sound) {
-        return std::nullopt;
-    }
-
-    FMOD_TAG nameTag = {};
-    FMOD_TAG artistTag = {};
-    FMOD_RESULT nameResult = FMOD_OK;
-    FMOD_RESULT artistResult = FMOD_OK;
-
-    const std::string extension = path.extension().string();
-    if (extension == ".mp3") {
-        nameResult = sound->getTag(MP3_NAME_TAG, 0, &nameTag);
-        artistResult = sound->getTag(MP3_ARTIST_TAG, 0, &artistTag);
-    } else if (extension == ".ogg" || extension == ".flac") {
-        nameResult = sound->getTag(OGG_FLAC_NAME_TAG, 0, &nameTag);
-        artistResult = sound->getTag(OGG_FLAC_ARTIST_TAG, 0, &artistTag);
-    } else if (extension == ".wav") {
-        nameResult = sound->getTag(WAV_NAME_TAG, 0, &nameTag);
-        artistResult = sound->getTag(WAV_ARTIST_TAG, 0, &artistTag);
-    }
-
-    if (nameResult != FMOD_ERR_TAGNOTFOUND) {
-        ret.name = parseFromFMODTag(nameTag);
-    }
-    if (artistResult != FMOD_ERR_TAGNOTFOUND) {
-        ret.artist = parseFromFMODTag(artistTag);
-    }
-
-    return ret;
-}
-
 NongAddPopup* NongAddPopup::create(int songID, std::optional<Song*> replacedNong) {
     auto ret = new NongAddPopup();
     if (ret->init(songID, replacedNong)) {
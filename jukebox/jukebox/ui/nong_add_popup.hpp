@@ -18,6 +18,7 @@
 
 #include <jukebox/nong/nong.hpp>
 #include <jukebox/ui/nong_dropdown_layer.hpp>
+#include <jukebox/utils/audio_tags.hpp>
 
 namespace jukebox {
 
@@ -31,11 +32,6 @@ protected:
         HOSTED,
     };
 
-    struct ParsedMetadata {
-        std::optional<std::string> name;
-        std::optional<std::string> artist;
-    };
-
     int m_songID = 0;
 
     std::vector<std::string> m_publishableIndexes;
@@ -91,12 +87,14 @@ protected:
     bool isPathValidSong(const std::filesystem::path& song) const;
     geode::Result<> addLocalSong(const std::string& songName, const std::string& artistName,
                                  std::optional<std::string> levelName, int offset);
+    geode::Result<> onLocalSongHashed(const std::filesystem::path& path, geode::Result<std::string>&& hash,
+                                      SongMetadata&& metadata, const std::optional<std::string>& replacedID);
     geode::Result<> addYTSong(const std::string& songName, const std::string& artistName,
                               std::optional<std::string> levelName, int offset);
     geode::Result<> addHostedSong(const std::string& songName, const std::string& artistName,
                                   std::optional<std::string> levelName, int offset);
     void onPublish(cocos2d::CCObject*);
-    std::optional<ParsedMetadata> tryParseMetadata(std::filesystem::path path);
+    void onTagsRead(const AudioTags& tags);
 
 public:
     static NongAddPopup* create(int songID, std::optional<Song*> nong = std::nullopt);
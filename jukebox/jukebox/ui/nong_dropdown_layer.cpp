@@ -21,11 +21,13 @@
 #include <Geode/ui/Layout.hpp>
 #include <Geode/ui/Popup.hpp>
 #include <Geode/ui/SimpleAxisLayout.hpp>
+#include <Geode/ui/TextInput.hpp>
 #include <Geode/utils/web.hpp>
 
 #include <jukebox/events/get_song_info.hpp>
 #include <jukebox/events/song_download_failed.hpp>
 #include <jukebox/events/song_error.hpp>
+#include <jukebox/managers/download_manager.hpp>
 #include <jukebox/managers/index_manager.hpp>
 #include <jukebox/managers/nong_manager.hpp>
 #include <jukebox/nong/nong.hpp>
@@ -135,6 +137,16 @@ bool NongDropdownLayer::init(float width, float height, std::vector<int> ids, Cu
     m_mainLayer->addChildAtPosition(topRightArt, Anchor::TopRight);
 
     this->createList();
+
+    // Searching every index is cheap enough to do on every keystroke
+    m_searchInput = TextInput::create(this->getCellSize().width / 0.8f, "Search all indexes", "chatFont.fnt");
+    m_searchInput->setScale(0.8f);
+    m_searchInput->setCommonFilter(CommonFilter::Any);
+    m_searchInput->setMaxCharCount(100);
+    m_searchInput->setCallback([this](const std::string& query) { m_list->search(query); });
+    m_searchInput->setID("search-input");
+    m_mainLayer->addChildAtPosition(m_searchInput, Anchor::Top, CCPoint{0.0f, -40.0f});
+
     CCSprite* title = CCSprite::createWithSpriteFrameName("JB_ListLogo.png"_spr);
     title->setPosition(ccp(contentSize.width / 2, contentSize.height - 10.f));
     title->setScale(0.75f);
@@ -163,7 +175,8 @@ bool NongDropdownLayer::init(float width, float height, std::vector<int> ids, Cu
     });
 
     m_downloadFailedListener = event::SongDownloadFailed().listen([this](const event::SongDownloadFailedData& event) {
-        if (!m_list || m_currentSongID != event.gdId()) {
+        // The user cancelled it themselves
+        if (!m_list || m_currentSongID != event.gdId() || event.error() == DownloadManager::s_cancelled) {
             return ListenerResult::Propagate;
         }
 
@@ -191,7 +204,7 @@ void NongDropdownLayer::openAddPopup(CCObject* target) {
 
 void NongDropdownLayer::createList() {
     if (!m_list) {
-        m_list = NongList::create(m_songIDS, CCSize{this->getCellSize().width, 220.f}, m_levelID,
+        m_list = NongList::create(m_songIDS, CCSize{this->getCellSize().width, 195.f}, m_levelID,
                                   [this](std::optional<int> currentSongID) {
                                       m_currentSongID = currentSongID;
                                       bool multiple = !currentSongID.has_value();
@@ -205,7 +218,8 @@ void NongDropdownLayer::createList() {
                                           m_bottomRightMenu->updateLayout();
                                       }
                                   });
-        m_mainLayer->addChildAtPosition(m_list, Anchor::Center);
+        // Leaves room for the search input above
+        m_mainLayer->addChildAtPosition(m_list, Anchor::Center, CCPoint{0.0f, -12.5f});
         return;
     }
 
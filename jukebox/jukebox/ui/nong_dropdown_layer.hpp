@@ -9,6 +9,7 @@
 #include <Geode/binding/CustomSongWidget.hpp>
 #include <Geode/loader/Event.hpp>
 #include <Geode/ui/Popup.hpp>
+#include <Geode/ui/TextInput.hpp>
 #include <Geode/utils/cocos.hpp>
 
 #include <jukebox/nong/nong.hpp>
@@ -24,6 +25,7 @@ protected:
     int m_defaultSongID = 0;
     geode::Ref<CustomSongWidget> m_parentWidget;
     NongList* m_list = nullptr;
+    geode::TextInput* m_searchInput = nullptr;
     std::optional<int> m_levelID;
 
     CCMenuItemSpriteExtra* m_addBtn = nullptr;
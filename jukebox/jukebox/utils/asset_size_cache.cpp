@@ -0,0 +1,134 @@
+#include <jukebox/utils/asset_size_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <Geode/loader/Mod.hpp>
+#include <Geode/utils/string.hpp>
+#include <matjson.hpp>
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+void AssetSizeCache::load() {
+    const auto saved = Mod::get()->getSavedValue<matjson::Value>("asset-sizes", matjson::Value::object());
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& [file, value] : saved) {
+        const std::optional<std::intmax_t> size = value[0].asInt().ok();
+        const std::optional<std::intmax_t> modified = value[1].asInt().ok();
+        if (!size || !modified || size.value() < 0) {
+            continue;
+        }
+
+        m_entries[file] = Entry{
+            .m_size = static_cast<uintmax_t>(size.value()),
+            .m_modified = static_cast<int64_t>(modified.value()),
+        };
+    }
+}
+
+void AssetSizeCache::save() {
+    std::lock_guard lock(m_mutex);
+    if (!m_dirty) {
+        return;
+    }
+
+    if (m_entries.size() > s_maxSaved) {
+        std::vector<std::string> unchecked;
+        for (const auto& [file, entry] : m_entries) {
+            if (!entry.m_checked) {
+                unchecked.push_back(file);
+            }
+        }
+
+        for (size_t i = 0; i < unchecked.size() && m_entries.size() > s_maxSaved; i++) {
+            m_entries.erase(unchecked[i]);
+        }
+    }
+
+    size_t saved = 0;
+    matjson::Value json = matjson::Value::object();
+    for (const auto& [file, entry] : m_entries) {
+        if (saved++ == s_maxSaved) {
+            break;
+        }
+
+        matjson::Value pair = matjson::Value::array();
+        pair.push(static_cast<int64_t>(entry.m_size));
+        pair.push(entry.m_modified);
+        json.set(file, std::move(pair));
+    }
+    Mod::get()->setSavedValue("asset-sizes", json);
+    m_dirty = false;
+}
+
+std::optional<uintmax_t> AssetSizeCache::size(const std::filesystem::path& path) {
+    const std::string key = string::pathToString(path);
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (const auto found = m_entries.find(key); found != m_entries.end() && found->second.m_checked) {
+            return found->second.m_size;
+        }
+        if (m_missing.contains(key)) {
+            return std::nullopt;
+        }
+    }
+
+    std::error_code ec;
+    const std::filesystem::file_time_type time = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        std::lock_guard lock(m_mutex);
+        if (m_entries.erase(key) > 0) {
+            m_dirty = true;
+        }
+        m_missing.insert(key);
+        return std::nullopt;
+    }
+    const int64_t modified = time.time_since_epoch().count();
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (const auto found = m_entries.find(key); found != m_entries.end() && found->second.m_modified == modified) {
+            found->second.m_checked = true;
+            return found->second.m_size;
+        }
+    }
+
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_entries.insert_or_assign(key, Entry{.m_size = size, .m_modified = modified, .m_checked = true});
+    m_dirty = true;
+
+    return size;
+}
+
+void AssetSizeCache::invalidate(const std::filesystem::path& path) {
+    const std::string key = string::pathToString(path);
+
+    std::lock_guard lock(m_mutex);
+    if (m_entries.erase(key) > 0) {
+        m_dirty = true;
+    }
+    m_missing.erase(key);
+}
+
+void AssetSizeCache::forgetMissing() {
+    std::lock_guard lock(m_mutex);
+    m_missing.clear();
+}
+
+}  // namespace jukebox
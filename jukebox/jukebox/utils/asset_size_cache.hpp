@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace jukebox {
+
+/**
+ * Sizes of song and SFX files, kept across sessions so the size of levels with
+ * lots of assets can be shown without reading every file's size again.
+ *
+ * Entries remember when the file was last written. The first lookup of a file
+ * in a session compares that against the disk, later ones don't touch it.
+ * Files we change ourselves should be invalidated.
+ *
+ * Missing files are remembered too, but only for the session, and forgotten
+ * whenever songs or SFX get downloaded. Only so many files are saved, the
+ * ones not looked up this session are dropped first.
+ *
+ * Safe to use from any thread.
+ */
+class AssetSizeCache final {
+private:
+    struct Entry {
+        uintmax_t m_size = 0;
+        int64_t m_modified = 0;
+        // Whether the entry was compared against the disk this session
+        bool m_checked = false;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::unordered_set<std::string> m_missing;
+    bool m_dirty = false;
+
+public:
+    static constexpr size_t s_maxSaved = 4096;
+
+    AssetSizeCache() = default;
+
+    AssetSizeCache(const AssetSizeCache&) = delete;
+    AssetSizeCache& operator=(const AssetSizeCache&) = delete;
+
+    AssetSizeCache(AssetSizeCache&&) = delete;
+    AssetSizeCache& operator=(AssetSizeCache&&) = delete;
+
+    /**
+     * Reads the sizes stored in the mod's saved values
+     */
+    void load();
+
+    /**
+     * Writes the sizes to the mod's saved values, if any changed
+     */
+    void save();
+
+    /**
+     * @return the size of the file, or nullopt if it doesn't exist
+     */
+    std::optional<uintmax_t> size(const std::filesystem::path& path);
+
+    void invalidate(const std::filesystem::path& path);
+
+    /**
+     * Forgets which files were missing, for when new ones may have appeared
+     */
+    void forgetMissing();
+};
+
+}  // namespace jukebox
@@ -0,0 +1,607 @@
+#include <jukebox/utils/audio_tags.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <Geode/utils/string.hpp>
+#include <arc/future/Future.hpp>
+
+#include <jukebox/utils/parallel.hpp>
+#include <jukebox/utils/trim.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+// Text frames bigger than this aren't a title or an artist
+constexpr uint32_t MAX_TEXT_SIZE = 64 * 1024;
+// Vorbis comments can hold cover art, only this much of them is read
+constexpr uint32_t MAX_COMMENTS_SIZE = 1024 * 1024;
+// Ogg pages to look through for the comment header
+constexpr int MAX_OGG_PAGES = 32;
+
+// An input file, where every read either gets all the bytes it asked for or
+// nothing
+class TagFile {
+private:
+    std::ifstream m_in;
+
+public:
+    explicit TagFile(const std::filesystem::path& path) : m_in(path, std::ios_base::in | std::ios_base::binary) {}
+
+    [[nodiscard]] bool isOpen() const { return m_in.is_open(); }
+
+    std::optional<std::string> read(const size_t size) {
+        std::string ret(size, '\0');
+        m_in.read(ret.data(), static_cast<std::streamsize>(size));
+
+        if (static_cast<size_t>(m_in.gcount()) != size) {
+            m_in.clear();
+            return std::nullopt;
+        }
+        return ret;
+    }
+
+    bool skip(const uint64_t size) {
+        m_in.seekg(static_cast<std::streamoff>(size), std::ios_base::cur);
+        return static_cast<bool>(m_in);
+    }
+
+    bool seek(const uint64_t pos) {
+        m_in.clear();
+        m_in.seekg(static_cast<std::streamoff>(pos), std::ios_base::beg);
+        return static_cast<bool>(m_in);
+    }
+
+    bool seekFromEnd(const uint64_t offset) {
+        m_in.clear();
+        m_in.seekg(-static_cast<std::streamoff>(offset), std::ios_base::end);
+        return static_cast<bool>(m_in);
+    }
+
+    uint64_t tell() { return static_cast<uint64_t>(m_in.tellg()); }
+};
+
+uint8_t byteAt(const std::string_view data, const size_t offset) { return static_cast<uint8_t>(data[offset]); }
+
+uint32_t readBE(const std::string_view data, const size_t offset, const size_t size) {
+    uint32_t ret = 0;
+    for (size_t i = 0; i < size; i++) {
+        ret = ret << 8 | byteAt(data, offset + i);
+    }
+    return ret;
+}
+
+uint32_t readLE32(const std::string_view data, const size_t offset) {
+    return byteAt(data, offset) | byteAt(data, offset + 1) << 8 | byteAt(data, offset + 2) << 16 |
+           static_cast<uint32_t>(byteAt(data, offset + 3)) << 24;
+}
+
+// ID3v2 sizes only use the lower 7 bits of every byte
+uint32_t readSyncsafe(const std::string_view data, const size_t offset) {
+    uint32_t ret = 0;
+    for (size_t i = 0; i < 4; i++) {
+        ret = ret << 7 | (byteAt(data, offset + i) & 0x7f);
+    }
+    return ret;
+}
+
+void appendUtf8(std::string& out, const char32_t c) {
+    if (c < 0x80) {
+        out.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | c >> 6));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | c >> 12));
+        out.push_back(static_cast<char>(0x80 | (c >> 6 & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | c >> 18));
+        out.push_back(static_cast<char>(0x80 | (c >> 12 & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (c >> 6 & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    }
+}
+
+std::string latin1ToUtf8(const std::string_view text) {
+    std::string ret;
+    ret.reserve(text.size());
+    for (const char c : text) {
+        appendUtf8(ret, static_cast<uint8_t>(c));
+    }
+    return ret;
+}
+
+std::string utf16ToUtf8(const std::string_view text, const bool bigEndian) {
+    const auto unit = [text, bigEndian](const size_t i) -> char16_t {
+        const uint8_t first = byteAt(text, i * 2);
+        const uint8_t second = byteAt(text, i * 2 + 1);
+        return bigEndian ? first << 8 | second : second << 8 | first;
+    };
+
+    const size_t units = text.size() / 2;
+    std::string ret;
+    ret.reserve(units);
+
+    for (size_t i = 0; i < units; i++) {
+        const char16_t c = unit(i);
+
+        if (c >= 0xd800 && c < 0xdc00 && i + 1 < units && unit(i + 1) >= 0xdc00 && unit(i + 1) < 0xe000) {
+            appendUtf8(ret, 0x10000 + ((c - 0xd800) << 10) + (unit(i + 1) - 0xdc00));
+            i++;
+        } else if (c >= 0xd800 && c < 0xe000) {
+            appendUtf8(ret, 0xfffd);
+        } else {
+            appendUtf8(ret, c);
+        }
+    }
+
+    return ret;
+}
+
+bool isValidUtf8(const std::string_view text) {
+    for (size_t i = 0; i < text.size();) {
+        const uint8_t c = byteAt(text, i);
+        const size_t length = c < 0x80              ? 1
+                              : (c & 0xe0) == 0xc0 ? 2
+                              : (c & 0xf0) == 0xe0 ? 3
+                              : (c & 0xf8) == 0xf0 ? 4
+                                                   : 0;
+
+        if (length == 0 || i + length > text.size()) {
+            return false;
+        }
+        for (size_t j = 1; j < length; j++) {
+            if ((byteAt(text, i + j) & 0xc0) != 0x80) {
+                return false;
+            }
+        }
+
+        i += length;
+    }
+
+    return true;
+}
+
+// Text that should be UTF-8, but plenty of taggers write Latin-1 anyway
+std::string lenientUtf8(const std::string_view text) {
+    return isValidUtf8(text) ? std::string(text) : latin1ToUtf8(text);
+}
+
+std::string_view untilNull(const std::string_view text) { return text.substr(0, text.find('\0')); }
+
+std::optional<std::string> clean(std::string text) {
+    jukebox::trim(text);
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    return text;
+}
+
+// Only the first value of frames holding several is used
+std::optional<std::string> decodeID3Text(const std::string_view data) {
+    if (data.empty()) {
+        return std::nullopt;
+    }
+
+    const std::string_view text = data.substr(1);
+
+    switch (byteAt(data, 0)) {
+        case 0:
+            return clean(latin1ToUtf8(untilNull(text)));
+        case 1:
+        case 2: {
+            bool bigEndian = byteAt(data, 0) == 2;
+            size_t start = 0;
+
+            if (text.size() >= 2 && byteAt(text, 0) == 0xff && byteAt(text, 1) == 0xfe) {
+                bigEndian = false;
+                start = 2;
+            } else if (text.size() >= 2 && byteAt(text, 0) == 0xfe && byteAt(text, 1) == 0xff) {
+                bigEndian = true;
+                start = 2;
+            }
+
+            size_t end = start;
+            while (end + 1 < text.size() && (text[end] != '\0' || text[end + 1] != '\0')) {
+                end += 2;
+            }
+
+            return clean(utf16ToUtf8(text.substr(start, end - start), bigEndian));
+        }
+        case 3:
+            return clean(lenientUtf8(untilNull(text)));
+        default:
+            return std::nullopt;
+    }
+}
+
+// Undoes ID3v2 unsynchronisation, which puts a zero after every 0xff that
+// could be mistaken for an MPEG frame sync
+void removeUnsync(std::string& data) {
+    size_t out = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        data[out++] = data[i];
+        if (byteAt(data, i) == 0xff && i + 1 < data.size() && data[i + 1] == '\0') {
+            i++;
+        }
+    }
+    data.resize(out);
+}
+
+// Reads an ID3v2 tag at the current position, if there is one. Leaves the file
+// right after the tag.
+bool readID3v2(TagFile& file, jukebox::AudioTags& tags) {
+    const uint64_t start = file.tell();
+
+    const std::optional<std::string> header = file.read(10);
+    if (!header || !header->starts_with("ID3")) {
+        file.seek(start);
+        return false;
+    }
+
+    const uint8_t version = byteAt(*header, 3);
+    const uint8_t flags = byteAt(*header, 5);
+    const bool unsync = flags & 0x80;
+    // A footer repeats the header at the end of the tag
+    const uint64_t end = start + 10 + readSyncsafe(*header, 6) + (version == 4 && flags & 0x10 ? 10 : 0);
+
+    if (version < 2 || version > 4) {
+        file.seek(end);
+        return true;
+    }
+
+    if (version >= 3 && flags & 0x40) {
+        const std::optional<std::string> extended = file.read(4);
+        if (!extended) {
+            return true;
+        }
+        // The size of the extended header includes itself in 2.4, but not in 2.3
+        file.skip(version == 4 ? readSyncsafe(*extended, 0) - 4 : readBE(*extended, 0, 4));
+    }
+
+    const size_t idSize = version == 2 ? 3 : 4;
+    const size_t frameHeaderSize = version == 2 ? 6 : 10;
+    // Compression, encryption and grouping, none of which are used on text
+    const uint16_t unsupportedFlags = version == 4 ? 0x004c : 0x00e0;
+
+    while ((!tags.m_title || !tags.m_artist) && file.tell() + frameHeaderSize <= end) {
+        const std::optional<std::string> frame = file.read(frameHeaderSize);
+        // Padding
+        if (!frame || frame->front() == '\0') {
+            break;
+        }
+
+        const std::string_view id = std::string_view(*frame).substr(0, idSize);
+        const uint32_t size = version == 2   ? readBE(*frame, 3, 3)
+                              : version == 4 ? readSyncsafe(*frame, 4)
+                                             : readBE(*frame, 4, 4);
+        const uint16_t frameFlags = version == 2 ? 0 : static_cast<uint16_t>(readBE(*frame, 8, 2));
+
+        std::optional<std::string>* target = nullptr;
+        if (id == "TIT2" || id == "TT2") {
+            target = &tags.m_title;
+        } else if (id == "TPE1" || id == "TP1") {
+            target = &tags.m_artist;
+        }
+
+        if (target == nullptr || target->has_value() || size > MAX_TEXT_SIZE || frameFlags & unsupportedFlags) {
+            if (!file.skip(size)) {
+                break;
+            }
+            continue;
+        }
+
+        std::optional<std::string> data = file.read(size);
+        if (!data) {
+            break;
+        }
+
+        if (version == 4 && frameFlags & 0x0001) {
+            // Data length indicator
+            data->erase(0, std::min<size_t>(4, data->size()));
+        }
+        if (unsync || (version == 4 && frameFlags & 0x0002)) {
+            removeUnsync(*data);
+        }
+
+        *target = decodeID3Text(*data);
+    }
+
+    file.seek(end);
+    return true;
+}
+
+// The 128 byte tag at the very end of old MP3s, Latin-1 only
+void readID3v1(TagFile& file, jukebox::AudioTags& tags) {
+    if (!file.seekFromEnd(128)) {
+        return;
+    }
+
+    const std::optional<std::string> tag = file.read(128);
+    if (!tag || !tag->starts_with("TAG")) {
+        return;
+    }
+
+    const std::string_view view(*tag);
+    if (!tags.m_title) {
+        tags.m_title = clean(latin1ToUtf8(untilNull(view.substr(3, 30))));
+    }
+    if (!tags.m_artist) {
+        tags.m_artist = clean(latin1ToUtf8(untilNull(view.substr(33, 30))));
+    }
+}
+
+bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+    return std::ranges::equal(a, b, [](const unsigned char x, const unsigned char y) {
+        return std::tolower(x) == std::tolower(y);
+    });
+}
+
+// Vendor string, then KEY=value pairs, all prefixed with little endian lengths.
+// Stops early if the data was cut short.
+void readVorbisComments(const std::string_view data, jukebox::AudioTags& tags) {
+    if (data.size() < 4) {
+        return;
+    }
+
+    size_t pos = 4 + static_cast<size_t>(readLE32(data, 0));
+    if (pos + 4 > data.size()) {
+        return;
+    }
+
+    const uint32_t count = readLE32(data, pos);
+    pos += 4;
+
+    for (uint32_t i = 0; i < count && pos + 4 <= data.size(); i++) {
+        const uint32_t length = readLE32(data, pos);
+        pos += 4;
+
+        if (length > data.size() - pos) {
+            return;
+        }
+
+        const std::string_view comment = data.substr(pos, length);
+        pos += length;
+
+        const size_t equals = comment.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+
+        const std::string_view key = comment.substr(0, equals);
+        const std::string_view value = comment.substr(equals + 1);
+
+        if (!tags.m_title && equalsIgnoreCase(key, "TITLE")) {
+            tags.m_title = clean(lenientUtf8(value));
+        } else if (!tags.m_artist && equalsIgnoreCase(key, "ARTIST")) {
+            tags.m_artist = clean(lenientUtf8(value));
+        }
+    }
+}
+
+// Metadata blocks after the "fLaC" marker, the file has to be right after it
+void readFlac(TagFile& file, jukebox::AudioTags& tags) {
+    while (true) {
+        const std::optional<std::string> header = file.read(4);
+        if (!header) {
+            return;
+        }
+
+        const uint8_t type = byteAt(*header, 0) & 0x7f;
+        const bool last = byteAt(*header, 0) & 0x80;
+        const uint32_t size = readBE(*header, 1, 3);
+
+        if (type == 4) {
+            if (const std::optional<std::string> comments = file.read(std::min(size, MAX_COMMENTS_SIZE))) {
+                readVorbisComments(*comments, tags);
+            }
+            return;
+        }
+
+        if (last || !file.skip(size)) {
+            return;
+        }
+    }
+}
+
+// The comment header is the second packet of the first stream, and may span
+// several pages
+void readOgg(TagFile& file, jukebox::AudioTags& tags) {
+    std::optional<uint32_t> serial;
+    std::string packet;
+    int packetIndex = 0;
+
+    for (int page = 0; page < MAX_OGG_PAGES; page++) {
+        const std::optional<std::string> header = file.read(27);
+        if (!header || !header->starts_with("OggS")) {
+            return;
+        }
+
+        const std::optional<std::string> lacing = file.read(byteAt(*header, 26));
+        if (!lacing) {
+            return;
+        }
+
+        size_t bodySize = 0;
+        for (const char segment : *lacing) {
+            bodySize += static_cast<uint8_t>(segment);
+        }
+
+        // Pages of other multiplexed streams
+        if (serial.value_or(readLE32(*header, 14)) != readLE32(*header, 14)) {
+            file.skip(bodySize);
+            continue;
+        }
+        serial = readLE32(*header, 14);
+
+        const std::optional<std::string> body = file.read(bodySize);
+        if (!body) {
+            return;
+        }
+
+        size_t offset = 0;
+        for (const char segment : *lacing) {
+            const auto segmentSize = static_cast<uint8_t>(segment);
+            if (packetIndex == 1 && packet.size() < MAX_COMMENTS_SIZE) {
+                packet.append(*body, offset, segmentSize);
+            }
+            offset += segmentSize;
+
+            // A segment shorter than 255 bytes ends its packet
+            if (segmentSize == 255) {
+                continue;
+            }
+
+            if (packetIndex == 1) {
+                const std::string_view view(packet);
+                if (view.starts_with("\x03vorbis")) {
+                    readVorbisComments(view.substr(7), tags);
+                } else if (view.starts_with("OpusTags")) {
+                    readVorbisComments(view.substr(8), tags);
+                }
+                return;
+            }
+
+            packetIndex++;
+        }
+    }
+}
+
+// Chunks after the "WAVE" form type, the file has to be right after it
+void readRiff(TagFile& file, jukebox::AudioTags& tags) {
+    while (!tags.m_title || !tags.m_artist) {
+        const std::optional<std::string> header = file.read(8);
+        if (!header) {
+            return;
+        }
+
+        const std::string_view id = std::string_view(*header).substr(0, 4);
+        const uint32_t size = readLE32(*header, 4);
+        // Chunks are padded to an even size
+        const uint64_t next = file.tell() + size + (size & 1);
+
+        if (id == "LIST" && size >= 4 && size <= MAX_COMMENTS_SIZE) {
+            const std::optional<std::string> list = file.read(size);
+            if (!list || !list->starts_with("INFO")) {
+                file.seek(next);
+                continue;
+            }
+
+            const std::string_view view(*list);
+            for (size_t pos = 4; pos + 8 <= view.size();) {
+                const std::string_view infoID = view.substr(pos, 4);
+                const uint32_t infoSize = readLE32(view, pos + 4);
+                pos += 8;
+
+                if (infoSize > view.size() - pos) {
+                    break;
+                }
+
+                const std::string_view value = untilNull(view.substr(pos, infoSize));
+                pos += infoSize + (infoSize & 1);
+
+                if (!tags.m_title && infoID == "INAM") {
+                    tags.m_title = clean(lenientUtf8(value));
+                } else if (!tags.m_artist && infoID == "IART") {
+                    tags.m_artist = clean(lenientUtf8(value));
+                }
+            }
+        } else if (id == "id3 " || id == "ID3 ") {
+            readID3v2(file, tags);
+        }
+
+        if (!file.seek(next)) {
+            return;
+        }
+    }
+}
+
+bool hasTaggedExtension(const std::filesystem::path& path) {
+    std::string extension = string::pathToString(path.extension());
+    std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return extension == ".mp3" || extension == ".ogg" || extension == ".flac" || extension == ".wav";
+}
+
+}  // namespace
+
+namespace jukebox {
+
+Result<AudioTags> readAudioTags(const std::filesystem::path& path) {
+    TagFile file(path);
+    if (!file.isOpen()) {
+        return Err("Couldn't open {}", path.filename());
+    }
+
+    const std::optional<std::string> magic = file.read(12);
+    if (!magic) {
+        return Err("{} is too short to be a song", path.filename());
+    }
+
+    AudioTags tags;
+
+    if (magic->starts_with("fLaC")) {
+        file.seek(4);
+        readFlac(file, tags);
+    } else if (magic->starts_with("OggS")) {
+        file.seek(0);
+        readOgg(file, tags);
+    } else if (magic->starts_with("RIFF") && magic->substr(8, 4) == "WAVE") {
+        readRiff(file, tags);
+    } else {
+        file.seek(0);
+        // Some FLACs have an ID3v2 tag in front of them
+        if (readID3v2(file, tags) && file.read(4) == "fLaC") {
+            readFlac(file, tags);
+        }
+        if (!tags.m_title || !tags.m_artist) {
+            readID3v1(file, tags);
+        }
+    }
+
+    return Ok(std::move(tags));
+}
+
+arc::Future<Result<AudioTags>> readAudioTagsAsync(std::filesystem::path path) { co_return readAudioTags(path); }
+
+arc::Future<std::vector<TaggedFile>> scanAudioTags(std::filesystem::path dir) {
+    std::vector<std::filesystem::path> files;
+
+    std::error_code ec;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.is_regular_file(ec) && hasTaggedExtension(entry.path())) {
+            files.push_back(entry.path());
+        }
+    }
+
+    std::vector<std::optional<AudioTags>> tags(files.size());
+    parallelFor(files.size(), [&files, &tags](const size_t i) {
+        if (Result<AudioTags> res = readAudioTags(files[i]); res.isOk() && !res.unwrap().empty()) {
+            tags[i] = std::move(res).unwrap();
+        }
+    });
+
+    std::vector<TaggedFile> ret;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (tags[i].has_value()) {
+            ret.push_back(TaggedFile{std::move(files[i]), std::move(tags[i]).value()});
+        }
+    }
+
+    co_return ret;
+}
+
+}  // namespace jukebox
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <Geode/Result.hpp>
+#include <arc/future/Future.hpp>
+
+namespace jukebox {
+
+struct AudioTags {
+    std::optional<std::string> m_title;
+    std::optional<std::string> m_artist;
+
+    [[nodiscard]] bool empty() const { return !m_title.has_value() && !m_artist.has_value(); }
+};
+
+struct TaggedFile {
+    std::filesystem::path m_path;
+    AudioTags m_tags;
+};
+
+/**
+ * Reads the title and artist of an audio file without decoding any audio.
+ * Understands ID3v2 and ID3v1 tags of MP3s, Vorbis comments of Ogg Vorbis,
+ * Opus and FLAC files, and RIFF INFO chunks of WAVs. Text is always returned
+ * as UTF-8.
+ *
+ * Only the tags are read, everything else is skipped over.
+ */
+geode::Result<AudioTags> readAudioTags(const std::filesystem::path& path);
+
+/**
+ * readAudioTags, off the main thread
+ */
+arc::Future<geode::Result<AudioTags>> readAudioTagsAsync(std::filesystem::path path);
+
+/**
+ * Reads the tags of every MP3, OGG, FLAC and WAV file directly inside a
+ * directory, a few files at a time. Files without readable tags are left out.
+ */
+arc::Future<std::vector<TaggedFile>> scanAudioTags(std::filesystem::path dir);
+
+}  // namespace jukebox
@@ -0,0 +1,46 @@
+#include <jukebox/utils/file.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fmt/format.h>
+#include <Geode/Result.hpp>
+#include <Geode/utils/string.hpp>
+
+using namespace geode::prelude;
+
+namespace jukebox::utils::file {
+
+Result<> writeStringAtomic(const std::filesystem::path& path, const std::string_view contents) {
+    const std::filesystem::path tmp = fmt::format("{}.tmp", string::pathToString(path));
+
+    std::ofstream output(tmp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!output.is_open()) {
+        return Err("Couldn't open file: {}", tmp);
+    }
+
+    output.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    output.close();
+
+    std::error_code ec;
+
+    if (output.fail()) {
+        std::filesystem::remove(tmp, ec);
+        return Err("Couldn't write file: {}", tmp);
+    }
+
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::string err = fmt::format("Couldn't move {} into place: {}", tmp.filename(), ec.message());
+        std::filesystem::remove(tmp, ec);
+        return Err(std::move(err));
+    }
+
+    return Ok();
+}
+
+}  // namespace jukebox::utils::file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include <Geode/Result.hpp>
+
+namespace jukebox::utils::file {
+
+/**
+ * Writes a file by writing a temporary file next to it first, then renaming
+ * it over the destination. A crash midway leaves either the old or the new
+ * contents, never a truncated file.
+ */
+geode::Result<> writeStringAtomic(const std::filesystem::path& path, std::string_view contents);
+
+}  // namespace jukebox::utils::file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace jukebox {
+
+/**
+ * 64-bit FNV-1a. Cheap, and good enough to tell whether a file changed, not
+ * meant for anything security related
+ */
+constexpr uint64_t fnv1a64(const std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : data) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+}  // namespace jukebox
@@ -0,0 +1,144 @@
+#include <jukebox/utils/mapped_file.hpp>
+
+#include <filesystem>
+#include <utility>
+
+#include <Geode/Result.hpp>
+#include <Geode/platform/cplatform.h>
+
+#ifdef GEODE_IS_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_handle(std::exchange(other.m_handle, nullptr)),
+      m_mapping(std::exchange(other.m_mapping, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    this->close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_handle = std::exchange(other.m_handle, nullptr);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+
+    return *this;
+}
+
+MappedFile::~MappedFile() { this->close(); }
+
+#ifdef GEODE_IS_WINDOWS
+
+Result<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    MappedFile ret;
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return Err("Couldn't open file {}: error {}", path, GetLastError());
+    }
+    ret.m_handle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        return Err("Couldn't get size of {}: error {}", path, GetLastError());
+    }
+
+    ret.m_size = static_cast<size_t>(size.QuadPart);
+    if (ret.m_size == 0) {
+        return Ok(std::move(ret));
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return Err("Couldn't map {}: error {}", path, GetLastError());
+    }
+    ret.m_mapping = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        return Err("Couldn't map view of {}: error {}", path, GetLastError());
+    }
+    ret.m_data = static_cast<const uint8_t*>(view);
+
+    return Ok(std::move(ret));
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_handle) {
+        CloseHandle(m_handle);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_handle = nullptr;
+}
+
+#else
+
+Result<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    MappedFile ret;
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Err("Couldn't open file {}", path);
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return Err("Couldn't get size of {}", path);
+    }
+
+    ret.m_size = static_cast<size_t>(st.st_size);
+    if (ret.m_size == 0) {
+        ::close(fd);
+        return Ok(std::move(ret));
+    }
+
+    void* view = mmap(nullptr, ret.m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (view == MAP_FAILED) {
+        ret.m_size = 0;
+        return Err("Couldn't map {}", path);
+    }
+    ret.m_data = static_cast<const uint8_t*>(view);
+
+    return Ok(std::move(ret));
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+}  // namespace jukebox
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+#include <Geode/Result.hpp>
+
+namespace jukebox {
+
+/**
+ * A read-only memory mapping of a whole file. The mapping is released when the
+ * object is destroyed or closed.
+ */
+class MappedFile final {
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    void* m_handle = nullptr;
+    void* m_mapping = nullptr;
+
+    MappedFile() = default;
+
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    ~MappedFile();
+
+    static geode::Result<MappedFile> open(const std::filesystem::path& path);
+
+    void close();
+
+    [[nodiscard]] std::span<const uint8_t> data() const { return {m_data, m_size}; }
+    [[nodiscard]] size_t size() const { return m_size; }
+};
+
+}  // namespace jukebox
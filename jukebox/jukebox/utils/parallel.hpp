@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace jukebox {
+
+/**
+ * Number of worker threads parallelFor would use for the given amount of items
+ */
+inline size_t parallelWorkerCount(size_t items, size_t maxThreads = 8) {
+    const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    return std::max<size_t>(std::min({hardware, maxThreads, items}), 1);
+}
+
+/**
+ * Calls func(i) for every i in [0, count) on a small pool of worker threads,
+ * and blocks until every item was processed. Items are handed out one at a
+ * time, so uneven workloads still balance out. func must be safe to call
+ * concurrently for different indexes.
+ */
+template <typename F>
+void parallelFor(size_t count, F&& func, size_t maxThreads = 8) {
+    const size_t workers = parallelWorkerCount(count, maxThreads);
+
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    auto work = [&func, &next, count]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            func(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t i = 0; i + 1 < workers; i++) {
+        threads.emplace_back(work);
+    }
+
+    // The calling thread pulls its weight too
+    work();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace jukebox
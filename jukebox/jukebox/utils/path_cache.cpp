@@ -0,0 +1,239 @@
+#include <jukebox/utils/path_cache.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Geode/loader/Log.hpp>
+
+#ifdef __linux__
+#include <cerrno>
+#include <thread>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+class PathCache::Impl : public std::enable_shared_from_this<PathCache::Impl> {
+public:
+    struct Entry {
+        PathStatus m_status;
+        std::chrono::steady_clock::time_point m_checked;
+        bool m_watched = false;
+        bool m_valid = false;
+        // Bumped by every invalidation, so a check of the disk that started
+        // before one doesn't store what it found
+        uint64_t m_generation = 0;
+    };
+
+    static constexpr std::chrono::seconds s_pollInterval{2};
+
+    std::mutex m_mutex;
+    std::unordered_map<std::filesystem::path::string_type, Entry> m_entries;
+    std::unordered_set<std::filesystem::path::string_type> m_watchedDirs;
+    // Bumped whenever every entry is dropped at once
+    uint64_t m_epoch = 0;
+
+#ifdef __linux__
+    int m_inotify = -1;
+    // Watch descriptor -> watched directory
+    std::unordered_map<int, std::filesystem::path> m_watches;
+#endif
+
+    static PathStatus stat(const std::filesystem::path& path) {
+        PathStatus ret;
+
+        std::error_code ec;
+        const std::filesystem::file_status status = std::filesystem::status(path, ec);
+        ret.m_exists = !ec && std::filesystem::exists(status);
+        if (!ret.m_exists || !std::filesystem::is_regular_file(status)) {
+            return ret;
+        }
+
+        ret.m_size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            ret.m_size = 0;
+        }
+        ret.m_modified = std::filesystem::last_write_time(path, ec);
+
+        return ret;
+    }
+
+    PathStatus status(const std::filesystem::path& path) {
+        const auto now = std::chrono::steady_clock::now();
+
+        uint64_t generation = 0;
+        uint64_t epoch = 0;
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            const Entry& entry = m_entries[path.native()];
+            if (entry.m_valid && (entry.m_watched || now - entry.m_checked < s_pollInterval)) {
+                return entry.m_status;
+            }
+
+            generation = entry.m_generation;
+            epoch = m_epoch;
+        }
+
+        // Not holding the lock, so other threads don't wait on the disk
+        const PathStatus status = stat(path);
+
+        std::lock_guard lock(m_mutex);
+
+        // If the file was invalidated meanwhile, what was found may be from
+        // before the change
+        Entry& entry = m_entries[path.native()];
+        if (m_epoch == epoch && entry.m_generation == generation) {
+            entry.m_status = status;
+            entry.m_checked = now;
+            entry.m_watched = m_watchedDirs.contains(path.parent_path().native());
+            entry.m_valid = true;
+        }
+
+        return status;
+    }
+
+    // With m_mutex held
+    void invalidate(const std::filesystem::path::string_type& path) {
+        if (const auto found = m_entries.find(path); found != m_entries.end()) {
+            found->second.m_valid = false;
+            found->second.m_generation++;
+        }
+    }
+
+    // With m_mutex held
+    void invalidateAll() {
+        m_entries.clear();
+        m_epoch++;
+    }
+
+    void watch(const std::filesystem::path& dir);
+
+#ifdef __linux__
+    void run();
+#endif
+};
+
+#ifdef __linux__
+
+void PathCache::Impl::watch(const std::filesystem::path& dir) {
+    std::lock_guard lock(m_mutex);
+
+    if (m_watchedDirs.contains(dir.native())) {
+        return;
+    }
+
+    const bool started = m_inotify == -1;
+    if (started) {
+        m_inotify = inotify_init1(IN_CLOEXEC);
+        if (m_inotify == -1) {
+            log::warn("Couldn't start watching song files, errno {}", errno);
+            return;
+        }
+    }
+
+    const int wd = inotify_add_watch(m_inotify, dir.c_str(),
+                                     IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB |
+                                         IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    if (wd == -1) {
+        log::warn("Couldn't watch {}, errno {}", dir, errno);
+        return;
+    }
+
+    m_watches.insert_or_assign(wd, dir);
+    m_watchedDirs.insert(dir.native());
+    // Entries made before were only meant to last until the next poll
+    this->invalidateAll();
+
+    if (started) {
+        std::thread([self = this->shared_from_this()] { self->run(); }).detach();
+    }
+}
+
+void PathCache::Impl::run() {
+    alignas(inotify_event) char buffer[4096];
+
+    while (true) {
+        const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            log::warn("Stopped watching song files, errno {}", errno);
+            std::lock_guard lock(m_mutex);
+            m_watches.clear();
+            m_watchedDirs.clear();
+            this->invalidateAll();
+            return;
+        }
+
+        std::lock_guard lock(m_mutex);
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Missed some changes, no telling which files they were about
+                this->invalidateAll();
+                continue;
+            }
+
+            const auto dir = m_watches.find(event->wd);
+            if (dir == m_watches.end()) {
+                continue;
+            }
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The directory itself is gone, its files go back to polling
+                m_watchedDirs.erase(dir->second.native());
+                m_watches.erase(dir);
+                this->invalidateAll();
+                continue;
+            }
+
+            if (event->len > 0) {
+                this->invalidate((dir->second / event->name).native());
+            }
+        }
+    }
+}
+
+#else
+
+void PathCache::Impl::watch(const std::filesystem::path&) {
+    // No watcher on this platform, entries expire after s_pollInterval
+}
+
+#endif
+
+PathCache::PathCache() : m_impl(std::make_shared<Impl>()) {}
+PathCache::~PathCache() = default;
+
+PathStatus PathCache::status(const std::filesystem::path& path) const { return m_impl->status(path); }
+
+void PathCache::invalidate(const std::filesystem::path& path) const {
+    std::lock_guard lock(m_impl->m_mutex);
+    m_impl->invalidate(path.native());
+}
+
+void PathCache::invalidateAll() const {
+    std::lock_guard lock(m_impl->m_mutex);
+    m_impl->invalidateAll();
+}
+
+void PathCache::watch(const std::filesystem::path& dir) const { m_impl->watch(dir); }
+
+}  // namespace jukebox
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace jukebox {
+
+struct PathStatus {
+    bool m_exists = false;
+    uintmax_t m_size = 0;
+    std::filesystem::file_time_type m_modified{};
+};
+
+/**
+ * Remembers whether files exist, how big they are and when they were last
+ * written, so code running every frame doesn't have to ask the disk.
+ *
+ * Files in watched directories stay cached until they change. On Linux, which
+ * includes Android, a background thread is told about changes by inotify.
+ * Elsewhere, and for files outside watched directories, entries are checked
+ * again once they are a couple seconds old.
+ *
+ * Changes we make ourselves should be invalidated right away instead of
+ * waiting for the watcher.
+ */
+class PathCache final {
+private:
+    class Impl;
+
+    // Shared with the watcher thread, which may outlive the cache
+    std::shared_ptr<Impl> m_impl;
+
+public:
+    PathCache();
+
+    PathCache(const PathCache&) = delete;
+    PathCache& operator=(const PathCache&) = delete;
+
+    PathCache(PathCache&&) = delete;
+    PathCache& operator=(PathCache&&) = delete;
+
+    ~PathCache();
+
+    [[nodiscard]] PathStatus status(const std::filesystem::path& path) const;
+    [[nodiscard]] bool exists(const std::filesystem::path& path) const { return this->status(path).m_exists; }
+
+    void invalidate(const std::filesystem::path& path) const;
+    void invalidateAll() const;
+
+    /**
+     * Keeps files directly inside the directory cached until they change.
+     * Falls back to checking them periodically if the platform can't watch it.
+     */
+    void watch(const std::filesystem::path& dir) const;
+};
+
+}  // namespace jukebox
@@ -0,0 +1,167 @@
+#include <jukebox/utils/sha256.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <Geode/Result.hpp>
+
+using namespace geode::prelude;
+
+namespace {
+
+constexpr std::array<uint32_t, 64> K = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// Files are hashed this many bytes at a time
+constexpr size_t READ_SIZE = 64 * 1024;
+
+}  // namespace
+
+namespace jukebox {
+
+Sha256::Sha256()
+    : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+void Sha256::compress(const uint8_t* block) {
+    std::array<uint32_t, 64> w;
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (size_t i = 16; i < 64; i++) {
+        const uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = m_state;
+
+    for (size_t i = 0; i < 64; i++) {
+        const uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+        const uint32_t ch = (e & f) ^ (~e & g);
+        const uint32_t t1 = h + s1 + ch + K[i] + w[i];
+        const uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+        const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t t2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+void Sha256::update(std::span<const uint8_t> data) {
+    m_length += data.size();
+
+    if (m_blockSize > 0) {
+        const size_t take = std::min(data.size(), m_block.size() - m_blockSize);
+        std::memcpy(m_block.data() + m_blockSize, data.data(), take);
+        m_blockSize += take;
+        data = data.subspan(take);
+
+        if (m_blockSize < m_block.size()) {
+            return;
+        }
+
+        this->compress(m_block.data());
+        m_blockSize = 0;
+    }
+
+    while (data.size() >= m_block.size()) {
+        this->compress(data.data());
+        data = data.subspan(m_block.size());
+    }
+
+    std::memcpy(m_block.data(), data.data(), data.size());
+    m_blockSize = data.size();
+}
+
+std::array<uint8_t, 32> Sha256::finish() {
+    const uint64_t bits = m_length * 8;
+
+    std::array<uint8_t, 72> padding {};
+    padding[0] = 0x80;
+    const size_t padLength = (m_blockSize < 56 ? 56 : 120) - m_blockSize;
+    for (size_t i = 0; i < 8; i++) {
+        padding[padLength + i] = static_cast<uint8_t>(bits >> (56 - i * 8));
+    }
+    this->update(std::span(padding.data(), padLength + 8));
+
+    std::array<uint8_t, 32> digest;
+    for (size_t i = 0; i < 8; i++) {
+        digest[i * 4] = static_cast<uint8_t>(m_state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(m_state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(m_state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(m_state[i]);
+    }
+    return digest;
+}
+
+std::string Sha256::toHex(const std::array<uint8_t, 32>& digest) {
+    constexpr std::string_view DIGITS = "0123456789abcdef";
+
+    std::string ret;
+    ret.reserve(digest.size() * 2);
+    for (const uint8_t byte : digest) {
+        ret.push_back(DIGITS[byte >> 4]);
+        ret.push_back(DIGITS[byte & 0xf]);
+    }
+    return ret;
+}
+
+Result<std::string> sha256File(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+    if (!in.is_open()) {
+        return Err("Couldn't open {} for hashing", path.filename());
+    }
+
+    Sha256 hash;
+    std::vector<uint8_t> buffer(READ_SIZE);
+
+    while (in) {
+        in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        const auto read = static_cast<size_t>(in.gcount());
+        if (read == 0) {
+            break;
+        }
+        hash.update(std::span<const uint8_t>(buffer.data(), read));
+    }
+
+    if (in.bad()) {
+        return Err("Couldn't read {} for hashing", path.filename());
+    }
+
+    return Ok(Sha256::toHex(hash.finish()));
+}
+
+}  // namespace jukebox
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+#include <Geode/Result.hpp>
+
+namespace jukebox {
+
+/**
+ * Incremental SHA-256, used to name audio files after their contents
+ */
+class Sha256 final {
+private:
+    std::array<uint32_t, 8> m_state;
+    std::array<uint8_t, 64> m_block {};
+    size_t m_blockSize = 0;
+    uint64_t m_length = 0;
+
+    void compress(const uint8_t* block);
+
+public:
+    Sha256();
+
+    void update(std::span<const uint8_t> data);
+    std::array<uint8_t, 32> finish();
+
+    static std::string toHex(const std::array<uint8_t, 32>& digest);
+};
+
+/**
+ * Hashes a file without loading all of it into memory
+ *
+ * @return the lowercase hex digest
+ */
+geode::Result<std::string> sha256File(const std::filesystem::path& path);
+
+}  // namespace jukebox
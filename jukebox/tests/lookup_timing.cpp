@@ -0,0 +1,195 @@
+// Times the nong list ranking and the verified song lookup against the way
+// they used to be done, on synthetic songs. Both are copied here in reduced
+// form, since the real ones live in code that needs Geode. Not a pass/fail
+// check, run it by hand:
+//
+//     cmake -S . -B build -DJUKEBOX_SELF_CHECKS=ON -DCMAKE_BUILD_TYPE=Release
+//     cmake --build build && ./build/lookup-timing
+
+#include <jukebox/utils/hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct FakeSong {
+    std::string m_uniqueID;
+    std::string m_name;
+    std::string m_indexID;
+    int m_source;
+    std::vector<int> m_verifiedLevelIDs;
+};
+
+volatile size_t g_sink = 0;
+
+template <typename F>
+double millis(const int runs, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        f();
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+std::vector<FakeSong> makeSongs(const size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<int> source(0, 2);
+    std::uniform_int_distribution<int> level(1, 5000);
+    std::uniform_int_distribution<int> index(0, 3);
+
+    std::vector<FakeSong> songs;
+    songs.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        FakeSong song{
+            .m_uniqueID = "song-" + std::to_string(rng()),
+            .m_name = "Name " + std::to_string(rng() % 100000),
+            .m_indexID = "index-" + std::to_string(index(rng)),
+            .m_source = source(rng),
+        };
+        for (int j = 0; j < 4; j++) {
+            song.m_verifiedLevelIDs.push_back(level(rng));
+        }
+        songs.push_back(std::move(song));
+    }
+    return songs;
+}
+
+// NongList::build before and after keys were worked out up front
+void timeRanking(const size_t count) {
+    std::mt19937 rng(1234);
+    const std::vector<FakeSong> songs = makeSongs(count, rng);
+
+    std::vector<std::string> verified;
+    for (size_t i = 0; i < songs.size(); i += 10) {
+        verified.push_back(songs[i].m_uniqueID);
+    }
+
+    const double before = millis(20, [&] {
+        std::unordered_set<std::string> stored;
+        std::vector<const FakeSong*> list;
+        for (const FakeSong& song : songs) {
+            stored.insert(song.m_indexID + "|" + song.m_uniqueID);
+            list.push_back(&song);
+        }
+        std::ranges::sort(list, [&verified](const FakeSong* a, const FakeSong* b) {
+            const bool aVerified = std::ranges::find(verified, a->m_uniqueID) != verified.end();
+            const bool bVerified = std::ranges::find(verified, b->m_uniqueID) != verified.end();
+            if (aVerified != bVerified) {
+                return aVerified;
+            }
+            if (a->m_source != b->m_source) {
+                return a->m_source < b->m_source;
+            }
+            return a->m_name < b->m_name;
+        });
+        g_sink = g_sink + stored.size() + list.size();
+    });
+
+    const double after = millis(20, [&] {
+        const std::unordered_set<std::string_view> verifiedSet(verified.begin(), verified.end());
+        std::unordered_multimap<uint64_t, const FakeSong*> stored;
+        stored.reserve(songs.size());
+
+        using Key = std::tuple<int, int, std::string_view>;
+        std::vector<std::pair<Key, const FakeSong*>> list;
+        list.reserve(songs.size());
+        for (const FakeSong& song : songs) {
+            const uint64_t key =
+                jukebox::fnv1a64(song.m_indexID) ^ (jukebox::fnv1a64(song.m_uniqueID) * 0x9e3779b97f4a7c15ull);
+            stored.emplace(key, &song);
+            list.emplace_back(Key{verifiedSet.contains(song.m_uniqueID) ? 0 : 1, song.m_source, song.m_name}, &song);
+        }
+        std::ranges::sort(list, std::less{}, &std::pair<Key, const FakeSong*>::first);
+        g_sink = g_sink + stored.size() + list.size();
+    });
+
+    std::printf("ranking %6zu songs: %9.3f ms before, %9.3f ms after\n", count, before, after);
+}
+
+// Verified song checks before and after the level ID index
+void timeVerified(const size_t count) {
+    std::mt19937 rng(5678);
+    const std::vector<FakeSong> songs = makeSongs(count, rng);
+
+    // Spread over song IDs, a few songs each, like indexSongs() of Nongs
+    constexpr int songIDs = 1000;
+    std::unordered_map<int, std::vector<const FakeSong*>> forID;
+    for (size_t i = 0; i < songs.size(); i++) {
+        forID[static_cast<int>(i % songIDs)].push_back(&songs[i]);
+    }
+
+    struct Verified {
+        int m_songID;
+        const FakeSong* m_song;
+    };
+    std::unordered_map<int, std::vector<Verified>> forLevel;
+    for (const auto& [songID, list] : forID) {
+        for (const FakeSong* song : list) {
+            for (const int level : song->m_verifiedLevelIDs) {
+                forLevel[level].push_back({songID, song});
+            }
+        }
+    }
+
+    // The song IDs of a level page, and the song checked for each
+    std::vector<std::tuple<int, int, std::string_view>> queries;
+    for (int i = 0; i < 10000; i++) {
+        const FakeSong& song = songs[rng() % songs.size()];
+        queries.emplace_back(song.m_verifiedLevelIDs[0], static_cast<int>(rng() % songIDs), song.m_uniqueID);
+    }
+
+    const double before = millis(5, [&] {
+        size_t found = 0;
+        for (const auto& [level, songID, uniqueID] : queries) {
+            std::vector<std::string> verified;
+            for (const FakeSong* song : forID[songID]) {
+                if (std::ranges::find(song->m_verifiedLevelIDs, level) != song->m_verifiedLevelIDs.end()) {
+                    verified.emplace_back(song->m_uniqueID);
+                }
+            }
+            found += std::ranges::find(verified, uniqueID) != verified.end();
+        }
+        g_sink = g_sink + found;
+    });
+
+    const double after = millis(5, [&] {
+        size_t found = 0;
+        for (const auto& [level, songID, uniqueID] : queries) {
+            const auto it = forLevel.find(level);
+            if (it == forLevel.end()) {
+                continue;
+            }
+            found += std::ranges::any_of(it->second, [songID, uniqueID](const Verified& verified) {
+                return verified.m_songID == songID && verified.m_song->m_uniqueID == uniqueID;
+            });
+        }
+        g_sink = g_sink + found;
+    });
+
+    std::printf("10k verified checks, %6zu songs: %9.3f ms before, %9.3f ms after\n", count, before, after);
+}
+
+}  // namespace
+
+int main() {
+    for (const size_t count : {1000, 10000}) {
+        timeRanking(count);
+    }
+    for (const size_t count : {10000, 100000}) {
+        timeVerified(count);
+    }
+    return 0;
+}
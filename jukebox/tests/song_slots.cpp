@@ -0,0 +1,180 @@
+#include <jukebox/nong/song_slots.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using jukebox::SongSlots;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                     \
+        }                                                                   \
+    } while (false)
+
+// Stands in for Nongs::Impl, the lists only hold unique IDs
+struct Lists {
+    std::array<std::vector<std::string>, SongSlots::s_lists> m_ids;
+
+    [[nodiscard]] size_t listSize(const size_t list) const { return m_ids[list].size(); }
+    [[nodiscard]] std::string_view idAt(const size_t list, const size_t index) const { return m_ids[list][index]; }
+};
+
+struct Fixture {
+    Lists m_lists;
+    SongSlots m_slots;
+
+    void add(const size_t list, std::string id) {
+        m_lists.m_ids[list].push_back(std::move(id));
+        m_slots.appended(m_lists, list);
+    }
+
+    void erase(const std::string& id) {
+        const std::optional<SongSlots::Slot> slot = m_slots.find(m_lists, id);
+        if (!slot) {
+            return;
+        }
+        std::vector<std::string>& ids = m_lists.m_ids[slot->list];
+        ids.erase(ids.begin() + static_cast<std::ptrdiff_t>(slot->index));
+        m_slots.erased(m_lists, slot->list, slot->index, id);
+    }
+
+    // What a linear search over the lists finds
+    [[nodiscard]] std::optional<SongSlots::Slot> linear(const std::string_view id) const {
+        for (size_t list = 0; list < SongSlots::s_lists; list++) {
+            for (size_t i = 0; i < m_lists.m_ids[list].size(); i++) {
+                if (m_lists.m_ids[list][i] == id) {
+                    return SongSlots::Slot{list, i};
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool matches(const std::string_view id) {
+        const std::optional<SongSlots::Slot> expected = this->linear(id);
+        const std::optional<SongSlots::Slot> found = m_slots.find(m_lists, id);
+        if (!expected || !found) {
+            return expected.has_value() == found.has_value();
+        }
+        return expected->list == found->list && expected->index == found->index;
+    }
+
+    [[nodiscard]] bool matchesAll(const std::vector<std::string>& ids) {
+        bool ok = true;
+        for (const std::string& id : ids) {
+            ok = this->matches(id) && ok;
+        }
+        return ok;
+    }
+};
+
+void checkAddAndLookup() {
+    Fixture f;
+    f.add(0, "a");
+    f.add(1, "b");
+    f.add(2, "c");
+    f.add(0, "d");
+
+    CHECK(f.matchesAll({"a", "b", "c", "d", "missing"}));
+    CHECK(f.m_slots.find(f.m_lists, "d")->index == 1);
+    CHECK(!f.m_slots.find(f.m_lists, "missing"));
+}
+
+void checkDelete() {
+    Fixture f;
+    for (const char* id : {"a", "b", "c", "d", "e"}) {
+        f.add(2, id);
+    }
+    f.add(0, "x");
+
+    f.erase("b");
+    CHECK(f.matchesAll({"a", "b", "c", "d", "e", "x"}));
+    CHECK(f.m_slots.find(f.m_lists, "e")->index == 3);
+
+    f.erase("a");
+    f.erase("e");
+    CHECK(f.matchesAll({"a", "c", "d", "e", "x"}));
+
+    f.erase("c");
+    f.erase("d");
+    f.erase("x");
+    CHECK(f.matchesAll({"c", "d", "x"}));
+}
+
+void checkReplace() {
+    // What Nongs::replaceSong does, a delete and an add of the same ID
+    Fixture f;
+    f.add(0, "a");
+    f.add(2, "b");
+    f.add(2, "c");
+
+    f.erase("b");
+    f.add(1, "b");
+    CHECK(f.matchesAll({"a", "b", "c"}));
+    CHECK(f.m_slots.find(f.m_lists, "b")->list == 1);
+    CHECK(f.m_slots.find(f.m_lists, "c")->index == 0);
+}
+
+void checkDuplicates() {
+    Fixture f;
+    f.add(1, "a");
+    f.add(0, "a");
+    f.add(2, "a");
+    f.add(0, "b");
+
+    // The first one in list order wins
+    CHECK(f.matches("a"));
+
+    f.erase("a");
+    CHECK(f.matchesAll({"a", "b"}));
+    f.erase("a");
+    CHECK(f.matchesAll({"a", "b"}));
+    f.erase("a");
+    CHECK(f.matchesAll({"a", "b"}));
+    CHECK(!f.m_slots.find(f.m_lists, "a"));
+}
+
+void checkOutsideChanges() {
+    Fixture f;
+    f.add(0, "a");
+    f.add(0, "b");
+
+    // Nongs lists can be filled and edited without going through the slots
+    f.m_lists.m_ids[1].push_back("c");
+    CHECK(f.matchesAll({"a", "b", "c"}));
+
+    f.m_lists.m_ids[0][0] = "z";
+    CHECK(f.matchesAll({"a", "b", "c", "z"}));
+
+    f.m_slots.clear();
+    CHECK(f.matchesAll({"b", "c", "z"}));
+}
+
+}  // namespace
+
+int main() {
+    checkAddAndLookup();
+    checkDelete();
+    checkReplace();
+    checkDuplicates();
+    checkOutsideChanges();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::puts("All song slot checks passed");
+    return 0;
+}